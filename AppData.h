@@ -13,7 +13,12 @@ enum IndicatorType {
     MA,
     MACD,
     RSI,
-    BOLL
+    BOLL,
+    ATR,        // 平均真实波幅
+    HIGHEST,    // 区间最高价
+    LOWEST,     // 区间最低价
+    DONCHIAN,   // 唐奇安通道
+    STC         // Schaff趋势周期
 };
 // 交易方向枚举
 enum Direction {
@@ -92,10 +97,21 @@ enum TimeFrame {
     Year         // 年线
 };
 
+// K线类型：时间K线按TimeFrame切分，其余为按成交活动切分的信息驱动K线
+enum BarType {
+    TimeBar = 0,    // 时间K线
+    VolumeBar,      // 成交量K线
+    AmountBar,      // 成交额K线
+    TickCountBar,   // 成交笔数K线
+    RangeBar,       // 价格区间K线
+    RenkoBar        // 砖形图
+};
+
 // 订单数据结构
 struct Order {
     QString orderId;            // 订单ID
     QString symbol;             // 交易品种代码
+    quint32 symbolId;           // 交易品种ID（SymbolTable）
     QDateTime createTime;       // 创建时间
     QDateTime updateTime;       // 更新时间
     Direction direction;        // 交易方向
@@ -112,7 +128,7 @@ struct Order {
     QString remark;             // 备注
     QMap<QString, QVariant> extraInfo; // 额外信息
 
-    Order() : direction(Unknown), type(Market), status(Created),
+    Order() : symbolId(0), direction(Unknown), type(Market), status(Created),
               price(0.0), stopPrice(0.0), quantity(0.0),
               filledQuantity(0.0), avgFillPrice(0.0), commission(0.0) {}
 };
@@ -122,6 +138,7 @@ struct Trade {
     QString tradeId;            // 成交ID
     QString orderId;            // 关联的订单ID
     QString symbol;             // 交易品种代码
+    quint32 symbolId;           // 交易品种ID（SymbolTable）
     QDateTime tradeTime;        // 成交时间
     Direction direction;        // 交易方向
     double price;               // 成交价格
@@ -131,12 +148,13 @@ struct Trade {
     QString accountId;          // 账户ID
     QMap<QString, QVariant> extraInfo; // 额外信息
 
-    Trade() : direction(Unknown), price(0.0), quantity(0.0), commission(0.0) {}
+    Trade() : symbolId(0), direction(Unknown), price(0.0), quantity(0.0), commission(0.0) {}
 };
 
 // 持仓数据结构
 struct Position {
     QString symbol;             // 交易品种代码
+    quint32 symbolId;           // 交易品种ID（SymbolTable）
     Direction direction;        // 持仓方向
     double quantity;            // 持仓数量
     double avgPrice;            // 平均持仓价格
@@ -147,7 +165,7 @@ struct Position {
     QString accountId;          // 账户ID
     QMap<QString, QVariant> extraInfo; // 额外信息
 
-    Position() : direction(Unknown), quantity(0.0), avgPrice(0.0),
+    Position() : symbolId(0), direction(Unknown), quantity(0.0), avgPrice(0.0),
                  marketPrice(0.0), unrealizedPnL(0.0), realizedPnL(0.0) {}
 };
 
@@ -171,6 +189,7 @@ struct Account {
 // 行情数据结构
 struct MarketData {
     QString symbol;             // 交易品种代码
+    quint32 symbolId;           // 交易品种ID（SymbolTable）
     QDateTime timestamp;        // 时间戳
     double price;               // 最新价
     double open;                // 开盘价
@@ -191,7 +210,7 @@ struct MarketData {
     QVector<double> askVolumes; // 卖盘量
     QMap<QString, QVariant> extraInfo; // 额外信息
 
-    MarketData() : price(0.0), open(0.0), high(0.0), low(0.0), close(0.0),
+    MarketData() : symbolId(0), price(0.0), open(0.0), high(0.0), low(0.0), close(0.0),
                    volume(0.0), amount(0.0), tickCount(0),
                    openInterest(0.0), bidPrice(0.0), askPrice(0.0),
                    bidVolume(0.0), askVolume(0.0) {}
@@ -200,6 +219,7 @@ struct MarketData {
 // K线数据结构
 struct Candle {
     QString symbol;             // 交易品种代码
+    quint32 symbolId;           // 交易品种ID（SymbolTable）
     TimeFrame timeFrame;        // 时间周期
     QDateTime timestamp;        // 时间戳
     double open;                // 开盘价
@@ -210,10 +230,31 @@ struct Candle {
     double amount;              // 成交额
     int tickCount;              // 成交笔数
     double openInterest;        // 持仓量（期货）
+    BarType barType;            // K线类型，信息驱动K线的timeFrame为KUnknown
+    double barSize;             // 信息驱动K线的阈值
     QMap<QString, QVariant> extraInfo; // 额外信息
 
-    Candle() : timeFrame(M1), open(0.0), high(0.0), low(0.0), close(0.0),
-               volume(0.0), amount(0.0), tickCount(0), openInterest(0.0) {}
+    Candle() : symbolId(0), timeFrame(M1), open(0.0), high(0.0), low(0.0), close(0.0),
+               volume(0.0), amount(0.0), tickCount(0), openInterest(0.0),
+               barType(TimeBar), barSize(0.0) {}
+};
+
+// 紧凑K线结构
+// 仅包含定长字段，可按位拷贝，用于替代热点路径中的MarketData/Candle
+struct Bar {
+    qint64 timestamp;           // 时间戳(毫秒, epoch)
+    quint32 symbolId;           // 交易品种ID
+    qint32 tickCount;           // 成交笔数
+    double open;                // 开盘价
+    double high;                // 最高价
+    double low;                 // 最低价
+    double close;               // 收盘价
+    double volume;              // 成交量
+    double amount;              // 成交额
+    double openInterest;        // 持仓量（期货）
+
+    Bar() : timestamp(0), symbolId(0), tickCount(0), open(0.0), high(0.0),
+            low(0.0), close(0.0), volume(0.0), amount(0.0), openInterest(0.0) {}
 };
 
 // 回测参数结构
@@ -0,0 +1,253 @@
+#include "BenchHarness.h"
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSysInfo>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<qint64> g_allocationCount(0);
+std::atomic<qint64> g_allocatedBytes(0);
+
+inline void recordAllocation(size_t size)
+{
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    g_allocatedBytes.fetch_add(static_cast<qint64>(size), std::memory_order_relaxed);
+}
+
+inline qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+#if defined(__GLIBC__)
+
+// glibc允许可执行文件覆盖malloc系列函数，Qt容器和operator new最终都会走到这里
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void __libc_free(void *ptr);
+
+void *malloc(size_t size)
+{
+    recordAllocation(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    recordAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    recordAllocation(size);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+    __libc_free(ptr);
+}
+}
+
+#else
+
+void *operator new(size_t size)
+{
+    recordAllocation(size);
+    if (void *ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+#endif
+
+qint64 AllocationCounter::count()
+{
+    return g_allocationCount.load(std::memory_order_relaxed);
+}
+
+qint64 AllocationCounter::bytes()
+{
+    return g_allocatedBytes.load(std::memory_order_relaxed);
+}
+
+qint64 BenchResult::totalNs() const
+{
+    qint64 total = 0;
+    for (qint64 sample : samplesNs) {
+        total += sample;
+    }
+    return total;
+}
+
+double BenchResult::eventsPerSecond() const
+{
+    const qint64 total = totalNs();
+    if (total <= 0) {
+        return 0.0;
+    }
+    return static_cast<double>(eventsPerOp) * samplesNs.size() * 1e9 / total;
+}
+
+qint64 BenchResult::percentileNs(double p) const
+{
+    if (samplesNs.isEmpty()) {
+        return 0;
+    }
+    // 最近秩法：第ceil(p/100*n)个样本
+    QVector<qint64> sorted = samplesNs;
+    std::sort(sorted.begin(), sorted.end());
+    const int n = sorted.size();
+    int rank = static_cast<int>(std::ceil(p / 100.0 * n));
+    rank = qBound(1, rank, n);
+    return sorted[rank - 1];
+}
+
+double BenchResult::allocationsPerOp() const
+{
+    return samplesNs.isEmpty() ? 0.0 : static_cast<double>(allocations) / samplesNs.size();
+}
+
+double BenchResult::bytesPerOp() const
+{
+    return samplesNs.isEmpty() ? 0.0 : static_cast<double>(allocatedBytes) / samplesNs.size();
+}
+
+QJsonObject BenchResult::toJson() const
+{
+    QJsonObject latency;
+    latency["p50"] = static_cast<double>(percentileNs(50));
+    latency["p90"] = static_cast<double>(percentileNs(90));
+    latency["p99"] = static_cast<double>(percentileNs(99));
+    latency["min"] = static_cast<double>(percentileNs(0));
+    latency["max"] = static_cast<double>(percentileNs(100));
+
+    QJsonObject object;
+    object["name"] = name;
+    object["iterations"] = iterations();
+    object["eventsPerOp"] = static_cast<double>(eventsPerOp);
+    object["eventsPerSecond"] = eventsPerSecond();
+    object["latencyNs"] = latency;
+    object["allocationsPerOp"] = allocationsPerOp();
+    object["bytesPerOp"] = bytesPerOp();
+    return object;
+}
+
+BenchRunner::BenchRunner(int iterations, int warmup)
+    : m_iterations(qMax(1, iterations))
+    , m_warmup(qMax(0, warmup))
+{
+}
+
+const BenchResult &BenchRunner::run(const QString &name,
+                                    qint64 eventsPerOp,
+                                    const std::function<void()> &setup,
+                                    const std::function<void()> &operation)
+{
+    for (int i = 0; i < m_warmup; ++i) {
+        if (setup) {
+            setup();
+        }
+        operation();
+    }
+
+    BenchResult result;
+    result.name = name;
+    result.eventsPerOp = eventsPerOp;
+    result.samplesNs.reserve(m_iterations);
+
+    for (int i = 0; i < m_iterations; ++i) {
+        if (setup) {
+            setup();
+        }
+        const qint64 allocationsBefore = AllocationCounter::count();
+        const qint64 bytesBefore = AllocationCounter::bytes();
+        const qint64 start = nowNs();
+        operation();
+        const qint64 elapsed = nowNs() - start;
+        result.allocations += AllocationCounter::count() - allocationsBefore;
+        result.allocatedBytes += AllocationCounter::bytes() - bytesBefore;
+        result.samplesNs.append(elapsed);
+    }
+
+    m_results.append(result);
+    print(m_results.last());
+    return m_results.last();
+}
+
+void BenchRunner::print(const BenchResult &result)
+{
+    std::printf("%-28s %14.0f ev/s  p50 %10.3f ms  p99 %10.3f ms  %12.1f allocs/op  %14.0f B/op\n",
+                qPrintable(result.name),
+                result.eventsPerSecond(),
+                result.percentileNs(50) / 1e6,
+                result.percentileNs(99) / 1e6,
+                result.allocationsPerOp(),
+                result.bytesPerOp());
+    std::fflush(stdout);
+}
+
+bool BenchRunner::writeJson(const QString &filePath, const QJsonObject &context) const
+{
+    QJsonArray cases;
+    for (const BenchResult &result : m_results) {
+        cases.append(result.toJson());
+    }
+
+    QJsonObject root;
+    root["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    root["host"] = QSysInfo::machineHostName();
+    root["cpuArchitecture"] = QSysInfo::currentCpuArchitecture();
+    root["idealThreadCount"] = QThread::idealThreadCount();
+    root["context"] = context;
+    root["results"] = cases;
+
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Indented);
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    return file.write(json) == json.size();
+}
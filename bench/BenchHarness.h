@@ -0,0 +1,102 @@
+#ifndef BENCHHARNESS_H
+#define BENCHHARNESS_H
+
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+#include <functional>
+
+/**
+ * @brief 进程内的内存分配计数
+ *
+ * 在glibc上通过替换malloc/calloc/realloc统计，可覆盖Qt容器（直接调用malloc）
+ * 和operator new两条路径；其他平台只统计operator new。计数是全局的，
+ * 包含线程池工作线程中的分配。
+ */
+class AllocationCounter
+{
+public:
+    // 累计分配次数
+    static qint64 count();
+
+    // 累计分配字节数
+    static qint64 bytes();
+};
+
+/**
+ * @brief 单个测试用例的结果
+ */
+struct BenchResult {
+    QString name;               // 用例名称
+    qint64 eventsPerOp;         // 每次操作处理的事件数（tick、K线或行情条数）
+    QVector<qint64> samplesNs;  // 每次操作的耗时(纳秒)
+    qint64 allocations;         // 所有计时操作的分配次数之和
+    qint64 allocatedBytes;      // 所有计时操作的分配字节数之和
+
+    BenchResult() : eventsPerOp(0), allocations(0), allocatedBytes(0) {}
+
+    // 计时操作的次数
+    int iterations() const { return samplesNs.size(); }
+
+    // 总耗时(纳秒)
+    qint64 totalNs() const;
+
+    // 吞吐量(事件/秒)
+    double eventsPerSecond() const;
+
+    // 单次操作耗时的百分位数(纳秒)，p取值[0, 100]
+    qint64 percentileNs(double p) const;
+
+    // 每次操作的平均分配次数/字节数
+    double allocationsPerOp() const;
+    double bytesPerOp() const;
+
+    // 转换为JSON对象
+    QJsonObject toJson() const;
+};
+
+/**
+ * @brief 基准测试运行器
+ *
+ * 每个用例先运行warmup次不计时的预热，再运行iterations次计时操作。
+ * 每次操作单独计时并统计分配，以便给出耗时分布而不只是平均值。
+ */
+class BenchRunner
+{
+public:
+    BenchRunner(int iterations, int warmup);
+
+    /**
+     * @brief 运行一个用例
+     * @param name 用例名称
+     * @param eventsPerOp 每次操作处理的事件数
+     * @param setup 每次操作前的准备工作，不计时也不统计分配，可为空
+     * @param operation 被测操作
+     * @return 用例结果（同时保存在results()中）
+     */
+    const BenchResult &run(const QString &name,
+                           qint64 eventsPerOp,
+                           const std::function<void()> &setup,
+                           const std::function<void()> &operation);
+
+    // 已运行的全部结果
+    const QVector<BenchResult> &results() const { return m_results; }
+
+    // 以表格形式输出到标准输出
+    static void print(const BenchResult &result);
+
+    /**
+     * @brief 将全部结果写为JSON文件，便于在提交之间对比
+     * @param filePath 文件路径
+     * @param context 运行参数（种子、数据规模等），原样写入"context"字段
+     * @return 是否成功
+     */
+    bool writeJson(const QString &filePath, const QJsonObject &context) const;
+
+private:
+    int m_iterations;
+    int m_warmup;
+    QVector<BenchResult> m_results;
+};
+
+#endif // BENCHHARNESS_H
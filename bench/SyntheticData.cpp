@@ -0,0 +1,150 @@
+#include "SyntheticData.h"
+#include "../global/SymbolTable.h"
+#include <QDateTime>
+
+SyntheticData::SyntheticData(quint64 seed)
+    : m_rng(seed)
+    , m_step(0.0, 0.01)
+    , m_volume(1.0, 1000.0)
+    , m_price(100.0)
+{
+}
+
+qint64 SyntheticData::defaultStartMs()
+{
+    return QDateTime(QDate(2024, 1, 2), QTime(9, 30), Qt::UTC).toMSecsSinceEpoch();
+}
+
+double SyntheticData::nextPrice()
+{
+    m_price = qMax(0.01, m_price + m_step(m_rng));
+    return m_price;
+}
+
+AppData::MarketData SyntheticData::makeTick(const QString &symbol, quint32 symbolId, qint64 msecs)
+{
+    const double price = nextPrice();
+    const double volume = m_volume(m_rng);
+
+    AppData::MarketData tick;
+    tick.symbol = symbol;
+    tick.symbolId = symbolId;
+    tick.timestamp = QDateTime::fromMSecsSinceEpoch(msecs);
+    tick.price = price;
+    tick.open = price;
+    tick.high = price + 0.01;
+    tick.low = price - 0.01;
+    tick.close = price;
+    tick.volume = volume;
+    tick.amount = volume * price;
+    tick.tickCount = 1;
+    tick.bidPrice = price - 0.01;
+    tick.bidVolume = volume / 2;
+    tick.askPrice = price + 0.01;
+    tick.askVolume = volume / 2;
+    return tick;
+}
+
+QVector<AppData::MarketData> SyntheticData::ticks(const QString &symbol,
+                                                  qint64 count,
+                                                  qint64 startMs,
+                                                  qint64 stepMs)
+{
+    const quint32 symbolId = SymbolTable::instance()->intern(symbol);
+
+    QVector<AppData::MarketData> data;
+    data.reserve(static_cast<int>(count));
+    for (qint64 i = 0; i < count; ++i) {
+        data.append(makeTick(symbol, symbolId, startMs + i * stepMs));
+    }
+    return data;
+}
+
+QVector<AppData::MarketData> SyntheticData::sessionTicks(const QString &symbol,
+                                                         qint64 count,
+                                                         qint64 stepMs)
+{
+    // 北京时间(UTC+8)的交易时段换算为UTC当日的毫秒偏移
+    static const qint64 kHourMs = 3600 * 1000LL;
+    static const qint64 kSessions[][2] = {
+        { 1 * kHourMs + kHourMs / 2, 3 * kHourMs + kHourMs / 2 },   // 9:30-11:30
+        { 5 * kHourMs, 7 * kHourMs }                                // 13:00-15:00
+    };
+
+    const quint32 symbolId = SymbolTable::instance()->intern(symbol);
+    stepMs = qMax<qint64>(1, stepMs);
+
+    QVector<AppData::MarketData> data;
+    data.reserve(static_cast<int>(count));
+    QDate date = QDateTime::fromMSecsSinceEpoch(defaultStartMs(), Qt::UTC).date();
+    while (data.size() < count) {
+        if (date.dayOfWeek() <= 5) {
+            const qint64 dayMs = QDateTime(date, QTime(0, 0), Qt::UTC).toMSecsSinceEpoch();
+            for (const auto &session : kSessions) {
+                for (qint64 t = session[0]; t < session[1] && data.size() < count; t += stepMs) {
+                    data.append(makeTick(symbol, symbolId, dayMs + t));
+                }
+            }
+        }
+        date = date.addDays(1);
+    }
+    return data;
+}
+
+QVector<AppData::MarketData> SyntheticData::bars(const QString &symbol,
+                                                 qint64 count,
+                                                 qint64 startMs,
+                                                 qint64 intervalMs)
+{
+    // 每根K线由固定数量的价格步构成，保证高低价与开收价一致
+    const int stepsPerBar = 8;
+    const quint32 symbolId = SymbolTable::instance()->intern(symbol);
+
+    QVector<AppData::MarketData> data;
+    data.reserve(static_cast<int>(count));
+    for (qint64 i = 0; i < count; ++i) {
+        AppData::MarketData bar;
+        bar.symbol = symbol;
+        bar.symbolId = symbolId;
+        bar.timestamp = QDateTime::fromMSecsSinceEpoch(startMs + i * intervalMs);
+        bar.open = m_price;
+        bar.high = m_price;
+        bar.low = m_price;
+        for (int s = 0; s < stepsPerBar; ++s) {
+            const double price = nextPrice();
+            const double volume = m_volume(m_rng);
+            bar.high = qMax(bar.high, price);
+            bar.low = qMin(bar.low, price);
+            bar.volume += volume;
+            bar.amount += volume * price;
+        }
+        bar.close = m_price;
+        bar.price = m_price;
+        bar.tickCount = stepsPerBar;
+        bar.bidPrice = m_price - 0.01;
+        bar.askPrice = m_price + 0.01;
+        data.append(bar);
+    }
+    return data;
+}
+
+void SyntheticData::priceArrays(qint64 count, QVector<double> &high, QVector<double> &low, QVector<double> &close)
+{
+    const int stepsPerBar = 8;
+
+    high.resize(static_cast<int>(count));
+    low.resize(static_cast<int>(count));
+    close.resize(static_cast<int>(count));
+    for (int i = 0; i < close.size(); ++i) {
+        double barHigh = m_price;
+        double barLow = m_price;
+        for (int s = 0; s < stepsPerBar; ++s) {
+            const double price = nextPrice();
+            barHigh = qMax(barHigh, price);
+            barLow = qMin(barLow, price);
+        }
+        high[i] = barHigh;
+        low[i] = barLow;
+        close[i] = m_price;
+    }
+}
@@ -0,0 +1,83 @@
+#ifndef SYNTHETICDATA_H
+#define SYNTHETICDATA_H
+
+#include "../AppData.h"
+#include <QString>
+#include <QVector>
+#include <random>
+
+/**
+ * @brief 可复现的合成行情生成器
+ *
+ * 价格为带漂移的随机游走，成交量服从均匀分布。相同的种子和相同的调用顺序
+ * 总是生成完全相同的数据，因此不同提交之间的测试结果可以直接比较。
+ */
+class SyntheticData
+{
+public:
+    explicit SyntheticData(quint64 seed);
+
+    /**
+     * @brief 生成tick数据
+     * @param symbol 交易品种代码
+     * @param count 条数
+     * @param startMs 第一条的时间(epoch毫秒)
+     * @param stepMs 相邻两条的时间间隔(毫秒)
+     * @return 按时间升序的tick数据
+     */
+    QVector<AppData::MarketData> ticks(const QString &symbol,
+                                       qint64 count,
+                                       qint64 startMs,
+                                       qint64 stepMs);
+
+    /**
+     * @brief 生成A股交易时段内的快照tick
+     *
+     * 只在工作日北京时间9:30-11:30、13:00-15:00生成数据，午休、隔夜和周末形成大段空档，
+     * 用于衡量K线合成跨越空档的开销
+     * @param symbol 交易品种代码
+     * @param count 条数
+     * @param stepMs 快照间隔(毫秒)，A股Level-1快照为3秒
+     * @return 按时间升序的tick数据
+     */
+    QVector<AppData::MarketData> sessionTicks(const QString &symbol,
+                                              qint64 count,
+                                              qint64 stepMs);
+
+    /**
+     * @brief 生成K线数据，每根K线由若干随机价格步构成
+     * @param symbol 交易品种代码
+     * @param count 根数
+     * @param startMs 第一根的开始时间(epoch毫秒)
+     * @param intervalMs K线周期(毫秒)
+     * @return 按时间升序的K线数据
+     */
+    QVector<AppData::MarketData> bars(const QString &symbol,
+                                      qint64 count,
+                                      qint64 startMs,
+                                      qint64 intervalMs);
+
+    /**
+     * @brief 生成连续数组形式的最高价、最低价和收盘价，用于批量指标内核的测试
+     *
+     * 价格过程与bars()相同，但不构造MarketData，千万根级别的序列也只占用3个double数组
+     * @param count 根数
+     */
+    void priceArrays(qint64 count, QVector<double> &high, QVector<double> &low, QVector<double> &close);
+
+    // 测试数据默认的起始时间：2024-01-02 09:30:00 UTC
+    static qint64 defaultStartMs();
+
+private:
+    double nextPrice();
+
+    // 生成一条随机游走的tick
+    AppData::MarketData makeTick(const QString &symbol, quint32 symbolId, qint64 msecs);
+
+    std::mt19937_64 m_rng;
+    std::normal_distribution<double> m_step;
+    std::uniform_real_distribution<double> m_volume;
+    double m_price;
+};
+
+#endif // SYNTHETICDATA_H
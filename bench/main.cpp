@@ -0,0 +1,569 @@
+#include "BenchHarness.h"
+#include "SyntheticData.h"
+#include "../AppData.h"
+#include "../history/BacktestEngine.h"
+#include "../history/ColumnarStore.h"
+#include "../history/CsvReader.h"
+#include "../history/HistoryDataManager.h"
+#include "../history/KlineGenerator.h"
+#include "../history/Strategy.h"
+#include "../indicators/ATR.h"
+#include "../indicators/BollingerBands.h"
+#include "../indicators/CrossSectionEngine.h"
+#include "../indicators/DonchianChannel.h"
+#include "../indicators/IndicatorKernels.h"
+#include "../indicators/IndicatorPipeline.h"
+#include "../indicators/MACD.h"
+#include "../indicators/MovingAverage.h"
+#include "../indicators/RSI.h"
+#include "../indicators/RollingExtremum.h"
+#include "../indicators/STC.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <cstdio>
+#include <memory>
+
+namespace {
+
+// 测试参数
+struct BenchOptions {
+    quint64 seed;        // 随机种子
+    qint64 rows;         // tick条数（回测为所有品种的总条数）
+    qint64 bars;         // 指标测试的K线根数
+    qint64 kernelBars;   // 批量内核测试的序列长度
+    int symbols;         // 回测品种数
+    int universe;        // 截面用例的品种数
+    int threads;         // CsvReader线程数
+    QString file;        // csv用例的输入文件，为空时使用合成数据
+};
+
+// 回测用例的策略：按固定间隔在当前价上下挂限价单，覆盖下单、撮合和成交回报路径
+class BenchStrategy : public Strategy
+{
+public:
+    bool initialize(QVariantMap config = QVariantMap()) override
+    {
+        Q_UNUSED(config);
+        m_tickCount = 0;
+        return true;
+    }
+
+    void cleanup() override {}
+
+    void onTick(const AppData::MarketData &data) override
+    {
+        if (++m_tickCount % 64 != 0) {
+            return;
+        }
+        if ((m_tickCount / 64) % 2 == 0) {
+            buyLimit(data.symbol, data.close - 0.02, 1.0);
+        } else {
+            sellLimit(data.symbol, data.close + 0.02, 1.0);
+        }
+    }
+
+    void onBar(const AppData::Candle &data) override { Q_UNUSED(data); }
+    void onOrder(const AppData::Order &order) override { Q_UNUSED(order); }
+    void onTrade(const AppData::Trade &trade) override { Q_UNUSED(trade); }
+
+private:
+    qint64 m_tickCount = 0;
+};
+
+// CSV读取：逐行QTextStream解析与多线程内存映射解析对比
+bool benchCsv(BenchRunner &runner, const BenchOptions &options)
+{
+    QTemporaryDir tempDir;
+    QString filePath = options.file;
+    if (filePath.isEmpty()) {
+        filePath = tempDir.filePath("bench.csv");
+        SyntheticData generator(options.seed);
+        const QVector<AppData::MarketData> ticks =
+            generator.ticks("BENCH", options.rows, SyntheticData::defaultStartMs(), 500);
+        if (!HistoryDataManager::saveToCsv(filePath, ticks)) {
+            std::fprintf(stderr, "failed to write %s\n", qPrintable(filePath));
+            return false;
+        }
+    }
+
+    // 先各读一次，校验两种读取方式的结果一致，并得到行数
+    QVector<AppData::MarketData> legacy;
+    QVector<AppData::MarketData> parallel;
+    if (!HistoryDataManager::loadFromCsv(filePath, legacy)
+        || !CsvReader::load(filePath, parallel, options.threads)) {
+        std::fprintf(stderr, "failed to read %s\n", qPrintable(filePath));
+        return false;
+    }
+    if (legacy.size() != parallel.size()) {
+        std::fprintf(stderr, "row count mismatch: %d vs %d\n", legacy.size(), parallel.size());
+        return false;
+    }
+    for (int i = 0; i < legacy.size(); ++i) {
+        const auto &a = legacy[i];
+        const auto &b = parallel[i];
+        if (a.timestamp != b.timestamp || a.close != b.close || a.volume != b.volume
+            || a.askVolume != b.askVolume || a.symbol != b.symbol) {
+            std::fprintf(stderr, "row %d mismatch\n", i);
+            return false;
+        }
+    }
+
+    const qint64 rows = legacy.size();
+    QVector<AppData::MarketData> output;
+    auto reset = [&output]() { output = QVector<AppData::MarketData>(); };
+
+    runner.run("csv/loadFromCsv", rows, reset, [&]() {
+        HistoryDataManager::loadFromCsv(filePath, output);
+    });
+    runner.run("csv/CsvReader", rows, reset, [&]() {
+        CsvReader::load(filePath, output, options.threads);
+    });
+    return true;
+}
+
+// 两组K线的起始时间和价格是否一致；成交量允许合并顺序带来的舍入误差
+bool sameBars(const QVector<AppData::MarketData> &a, const QVector<AppData::MarketData> &b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (int i = 0; i < a.size(); ++i) {
+        if (a[i].timestamp != b[i].timestamp || a[i].open != b[i].open || a[i].high != b[i].high
+            || a[i].low != b[i].low || a[i].close != b[i].close
+            || qAbs(a[i].volume - b[i].volume) > 1e-9 * qMax(1.0, qAbs(b[i].volume))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 两组K线的起始时间是否一致（子区间的边缘K线取自缓存，成交量等与单独合成不同）
+bool sameBarStarts(const QVector<AppData::MarketData> &a, const QVector<AppData::MarketData> &b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (int i = 0; i < a.size(); ++i) {
+        if (a[i].timestamp != b[i].timestamp) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 按交易时段对齐时，缓存的增量合成、子区间命中和预生成切片应与强制重新合成一致。
+// 连续的合成tick包含大量时段外的数据，这些tick归属的K线起始时间晚于tick本身
+bool verifySessionCache(const QVector<AppData::MarketData> &ticks)
+{
+    const AppData::ExchangeType exchanges[] = {AppData::SSE, AppData::SHFE};
+    const QVector<AppData::TimeFrame> timeFrames = {AppData::M1, AppData::M5, AppData::H1, AppData::D1};
+    const QVector<AppData::MarketData> headTicks = ticks.mid(0, ticks.size() - ticks.size() / 100);
+    const QVector<AppData::MarketData> rangeTicks = ticks.mid(ticks.size() / 4, ticks.size() / 4);
+    const qint64 rangeStartMs = rangeTicks.first().timestamp.toMSecsSinceEpoch();
+    const qint64 rangeEndMs = rangeTicks.last().timestamp.toMSecsSinceEpoch();
+
+    for (AppData::ExchangeType exchange : exchanges) {
+        KlineGenerator klineGenerator;
+        klineGenerator.setTradingSession(TradingSession::forExchange(exchange));
+        for (AppData::TimeFrame timeFrame : timeFrames) {
+            const QVector<AppData::MarketData> full = klineGenerator.generateKlineFromTicks(ticks, timeFrame, true);
+            const QVector<AppData::MarketData> range = klineGenerator.generateKlineFromTicks(rangeTicks, timeFrame, true);
+
+            klineGenerator.clearCache();
+            klineGenerator.generateKlineFromTicks(headTicks, timeFrame);
+            const QVector<AppData::MarketData> extended = klineGenerator.generateKlineFromTicks(ticks, timeFrame);
+            const QVector<AppData::MarketData> hit = klineGenerator.generateKlineFromTicks(rangeTicks, timeFrame);
+
+            klineGenerator.clearCache();
+            klineGenerator.preGenerateKlines(ticks, QVector<AppData::TimeFrame>() << timeFrame);
+            const QVector<AppData::MarketData> sliced =
+                klineGenerator.cachedKlines("BENCH", timeFrame, rangeStartMs, rangeEndMs).toVector();
+
+            if (!sameBars(extended, full) || !sameBarStarts(hit, range) || !sameBarStarts(sliced, range)) {
+                std::fprintf(stderr, "session cache mismatch: exchange %d, timeframe %d "
+                             "(extended %d/%d, hit %d/%d, sliced %d/%d bars)\n",
+                             static_cast<int>(exchange), static_cast<int>(timeFrame),
+                             extended.size(), full.size(), hit.size(), range.size(),
+                             sliced.size(), range.size());
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// K线合成：tick聚合为K线，以及低周期K线聚合为高周期
+bool benchKline(BenchRunner &runner, const BenchOptions &options)
+{
+    SyntheticData generator(options.seed);
+    const QVector<AppData::MarketData> ticks =
+        generator.ticks("BENCH", options.rows, SyntheticData::defaultStartMs(), 500);
+
+    // 先校验按交易时段对齐时缓存的结果与重新合成一致
+    if (!verifySessionCache(ticks)) {
+        return false;
+    }
+
+    KlineGenerator klineGenerator;
+    QVector<AppData::MarketData> minuteBars;
+
+    // forceRegenerate绕过缓存，每次都完整执行聚合
+    runner.run("kline/ticks->M1", ticks.size(), nullptr, [&]() {
+        minuteBars = klineGenerator.generateKlineFromTicks(ticks, AppData::M1, true);
+    });
+    runner.run("kline/ticks->H1", ticks.size(), nullptr, [&]() {
+        klineGenerator.generateKlineFromTicks(ticks, AppData::H1, true);
+    });
+    runner.run("kline/M1->H1", minuteBars.size(), nullptr, [&]() {
+        klineGenerator.generateKlineFromKline(minuteBars, AppData::M1, AppData::H1, true);
+    });
+
+    // 缓存：已缓存前99%的数据，追加剩余1%后只合成新增部分；子区间直接取切片
+    const QVector<AppData::MarketData> headTicks = ticks.mid(0, ticks.size() - ticks.size() / 100);
+    const qint64 appended = ticks.size() - headTicks.size();
+    runner.run("kline/cache append 1% ->M1", appended, [&]() {
+        klineGenerator.clearCache();
+        klineGenerator.generateKlineFromTicks(headTicks, AppData::M1);
+    }, [&]() {
+        klineGenerator.generateKlineFromTicks(ticks, AppData::M1);
+    });
+    const qint64 rangeStartMs = ticks[ticks.size() / 4].timestamp.toMSecsSinceEpoch();
+    const qint64 rangeEndMs = ticks[ticks.size() / 2].timestamp.toMSecsSinceEpoch();
+    runner.run("kline/cache slice", 1, nullptr, [&]() {
+        klineGenerator.cachedKlines("BENCH", AppData::M1, rangeStartMs, rangeEndMs);
+    });
+
+    // A股快照：午休、隔夜和周末的空档占时间轴的大部分
+    const QVector<AppData::MarketData> sessionTicks =
+        SyntheticData(options.seed).sessionTicks("BENCH", options.rows, 3000);
+    runner.run("kline/ashare ticks->M1", sessionTicks.size(), nullptr, [&]() {
+        klineGenerator.generateKlineFromTicks(sessionTicks, AppData::M1, true);
+    });
+    runner.run("kline/ashare ticks->M5", sessionTicks.size(), nullptr, [&]() {
+        klineGenerator.generateKlineFromTicks(sessionTicks, AppData::M5, true);
+    });
+
+    // 按交易所时段对齐（午休不占用分钟），衡量时段映射的额外开销
+    KlineGenerator sessionGenerator;
+    sessionGenerator.setTradingSession(TradingSession::forExchange(AppData::SSE));
+    runner.run("kline/ashare session ticks->M1", sessionTicks.size(), nullptr, [&]() {
+        sessionGenerator.generateKlineFromTicks(sessionTicks, AppData::M1, true);
+    });
+    runner.run("kline/ashare session ticks->H1", sessionTicks.size(), nullptr, [&]() {
+        sessionGenerator.generateKlineFromTicks(sessionTicks, AppData::H1, true);
+    });
+
+    // 级联预生成M1到W1全部周期
+    const QVector<AppData::TimeFrame> allTimeFrames = {
+        AppData::M1, AppData::M5, AppData::M15, AppData::M30,
+        AppData::H1, AppData::H4, AppData::D1, AppData::W1
+    };
+    runner.run("kline/preGenerate M1..W1", ticks.size(), nullptr, [&]() {
+        klineGenerator.preGenerateKlines(ticks, allTimeFrames);
+    });
+    return !minuteBars.isEmpty();
+}
+
+// 指标计算：整段计算和逐根增量更新
+bool benchIndicator(BenchRunner &runner, const BenchOptions &options)
+{
+    SyntheticData generator(options.seed);
+    const QVector<AppData::MarketData> bars =
+        generator.bars("BENCH", options.bars, SyntheticData::defaultStartMs(), 60 * 1000);
+    const qint64 count = bars.size();
+
+    MovingAverage sma(20, MovingAverage::SMA);
+    MovingAverage ema(20, MovingAverage::EMA);
+    MovingAverage wma(20, MovingAverage::WMA);
+    MACD macd;
+    RSI rsi;
+    BollingerBands bollinger;
+    ATR atr;
+    RollingExtremum highest(80, RollingExtremum::Highest);
+    DonchianChannel donchian(80);
+    STC stc;
+
+    runner.run("indicator/SMA20.calculate", count, nullptr, [&]() { sma.calculate(bars); });
+    runner.run("indicator/EMA20.calculate", count, nullptr, [&]() { ema.calculate(bars); });
+    runner.run("indicator/WMA20.calculate", count, nullptr, [&]() { wma.calculate(bars); });
+    runner.run("indicator/MACD.calculate", count, nullptr, [&]() { macd.calculate(bars); });
+    runner.run("indicator/RSI14.calculate", count, nullptr, [&]() { rsi.calculate(bars); });
+    runner.run("indicator/BOLL20.calculate", count, nullptr, [&]() { bollinger.calculate(bars); });
+    runner.run("indicator/ATR14.calculate", count, nullptr, [&]() { atr.calculate(bars); });
+    runner.run("indicator/Highest80.calculate", count, nullptr, [&]() { highest.calculate(bars); });
+    runner.run("indicator/Donchian80.calculate", count, nullptr, [&]() { donchian.calculate(bars); });
+    runner.run("indicator/STC.calculate", count, nullptr, [&]() { stc.calculate(bars); });
+
+    // 增量更新：每次操作从空状态开始逐根喂入全部K线
+    std::unique_ptr<MovingAverage> incremental;
+    runner.run("indicator/EMA20.update", count,
+               [&]() { incremental.reset(new MovingAverage(20, MovingAverage::EMA)); },
+               [&]() {
+                   for (const auto &bar : bars) {
+                       incremental->update(bar);
+                   }
+               });
+
+    // 计算图：两个订阅者分别登记Hull MA和ATR通道，共同的WMA/ATR节点只计算一次
+    std::unique_ptr<IndicatorPipeline> pipeline;
+    runner.run("indicator/pipeline HMA20+ATR14", count,
+               [&]() {
+                   pipeline.reset(new IndicatorPipeline);
+                   for (int subscriber = 0; subscriber < 2; ++subscriber) {
+                       const int close = pipeline->source(IndicatorPipeline::Close);
+                       const int hull = pipeline->linear(pipeline->wma(close, 10), 2.0, pipeline->wma(close, 20), -1.0);
+                       pipeline->wma(hull, 4);
+                       pipeline->linear(close, 1.0, pipeline->atr(14), -2.0);
+                       pipeline->highest(pipeline->source(IndicatorPipeline::High), 20);
+                   }
+               },
+               [&]() {
+                   for (const auto &bar : bars) {
+                       pipeline->append(bar);
+                   }
+               });
+    return true;
+}
+
+// 批量指标内核：千万根级别的连续数组，在CPU支持的每种指令集下各测一遍
+bool benchKernels(BenchRunner &runner, const BenchOptions &options)
+{
+    SyntheticData generator(options.seed);
+    QVector<double> high;
+    QVector<double> low;
+    QVector<double> close;
+    generator.priceArrays(options.kernelBars, high, low, close);
+    const int n = close.size();
+    const qint64 count = n;
+
+    QVector<double> out1(n);
+    QVector<double> out2(n);
+    QVector<double> out3(n);
+    const double *h = high.constData();
+    const double *l = low.constData();
+    const double *c = close.constData();
+    double *o1 = out1.data();
+    double *o2 = out2.data();
+    double *o3 = out3.data();
+
+    const IndicatorKernels::Isa detected = IndicatorKernels::detectedIsa();
+    for (int isa = IndicatorKernels::ScalarIsa; isa <= detected; ++isa) {
+        IndicatorKernels::setActiveIsa(static_cast<IndicatorKernels::Isa>(isa));
+        const QString prefix = QString("kernel/%1/").arg(IndicatorKernels::isaName(IndicatorKernels::activeIsa()));
+
+        runner.run(prefix + "SMA20", count, nullptr, [&]() { IndicatorKernels::sma(c, n, 20, o1); });
+        runner.run(prefix + "EMA20", count, nullptr, [&]() { IndicatorKernels::ema(c, n, 20, o1); });
+        runner.run(prefix + "WMA20", count, nullptr, [&]() { IndicatorKernels::wma(c, n, 20, o1); });
+        runner.run(prefix + "RSI14", count, nullptr, [&]() { IndicatorKernels::rsi(c, n, 14, o1); });
+        runner.run(prefix + "MACD", count, nullptr, [&]() { IndicatorKernels::macd(c, n, 12, 26, 9, o1, o2, o3); });
+        runner.run(prefix + "BOLL20", count, nullptr,
+                   [&]() { IndicatorKernels::bollinger(c, n, 20, 2.0, o1, o2, o3); });
+        runner.run(prefix + "ATR14", count, nullptr, [&]() { IndicatorKernels::atr(h, l, c, n, 14, o1); });
+        runner.run(prefix + "MAX10", count, nullptr, [&]() { IndicatorKernels::rollingMax(h, n, 10, o1); });
+        runner.run(prefix + "MIN10", count, nullptr, [&]() { IndicatorKernels::rollingMin(l, n, 10, o1); });
+        runner.run(prefix + "MAX250", count, nullptr, [&]() { IndicatorKernels::rollingMax(h, n, 250, o1); });
+    }
+    IndicatorKernels::setActiveIsa(detected);
+    return true;
+}
+
+// 截面指标：全市场品种的日K线，截面引擎与每个品种各一组指标对象对比
+bool benchCrossSection(BenchRunner &runner, const BenchOptions &options)
+{
+    const int barsPerSymbol = 250;     // 约一年的日K线
+    const int symbolCount = qMax(1, options.universe);
+
+    SyntheticData generator(options.seed);
+    QVector<double> high;
+    QVector<double> low;
+    QVector<double> closes;
+    generator.priceArrays(static_cast<qint64>(symbolCount) * barsPerSymbol, high, low, closes);
+    const qint64 count = closes.size();
+
+    QStringList symbols;
+    QVector<QVector<AppData::MarketData>> bars(symbolCount);
+    for (int symbol = 0; symbol < symbolCount; ++symbol) {
+        symbols.append(QString("SYM%1").arg(symbol, 6, 10, QChar('0')));
+        bars[symbol].resize(barsPerSymbol);
+        for (int i = 0; i < barsPerSymbol; ++i) {
+            const int index = symbol * barsPerSymbol + i;
+            bars[symbol][i].high = high[index];
+            bars[symbol][i].low = low[index];
+            bars[symbol][i].close = closes[index];
+        }
+    }
+
+    // 对照：每个品种各一组IndicatorBase对象
+    runner.run("cross/objects RSI14+MACD+BOLL20", count, nullptr, [&]() {
+        for (const auto &symbolBars : bars) {
+            RSI rsi;
+            MACD macd;
+            BollingerBands bollinger;
+            rsi.calculate(symbolBars);
+            macd.calculate(symbolBars);
+            bollinger.calculate(symbolBars);
+        }
+    });
+
+    CrossSectionEngine engine(symbols);
+    const int rsi = engine.rsi(14);
+    engine.macd();
+    engine.bollinger(20, 2.0);
+    runner.run("cross/engine.calculate RSI14+MACD+BOLL20", count, nullptr,
+               [&]() { engine.calculate(closes, barsPerSymbol); });
+
+    // 实时：每次操作追加一根截面K线
+    QVector<double> row(symbolCount);
+    for (int symbol = 0; symbol < symbolCount; ++symbol) {
+        row[symbol] = closes[symbol * barsPerSymbol + barsPerSymbol - 1];
+    }
+    runner.run("cross/engine.update", symbolCount, nullptr, [&]() { engine.update(row); });
+    runner.run("cross/engine.rank top50", symbolCount, nullptr, [&]() { engine.rank(rsi, Qt::DescendingOrder, 50); });
+    return true;
+}
+
+// 回测：多品种列式存储上的完整回测流程（加载、归并、撮合、指标统计）
+bool benchBacktest(BenchRunner &runner, const BenchOptions &options)
+{
+    QTemporaryDir tempDir;
+    auto dataManager = std::make_shared<HistoryDataManager>();
+    dataManager->setDataDir(tempDir.path());
+
+    const int symbolCount = qMax(1, options.symbols);
+    const qint64 rowsPerSymbol = qMax<qint64>(1, options.rows / symbolCount);
+    const qint64 startMs = SyntheticData::defaultStartMs();
+    qint64 endMs = startMs;
+
+    SyntheticData generator(options.seed);
+    AppData::BacktestParams params;
+    params.timeFrame = AppData::Tick;
+    for (int i = 0; i < symbolCount; ++i) {
+        const QString symbol = QString("BENCH%1").arg(i);
+        // 各品种的tick时间错开，使事件流需要真正归并
+        const QVector<AppData::MarketData> ticks =
+            generator.ticks(symbol, rowsPerSymbol, startMs + i * 7, 500);
+        if (!ColumnarStore::write(dataManager->getColumnarFilePath(symbol, AppData::Tick),
+                                  symbol, AppData::Tick, ticks)) {
+            std::fprintf(stderr, "failed to write store for %s\n", qPrintable(symbol));
+            return false;
+        }
+        params.symbols.append(symbol);
+        endMs = qMax(endMs, ticks.last().timestamp.toMSecsSinceEpoch());
+    }
+    params.startDate = QDateTime::fromMSecsSinceEpoch(startMs);
+    params.endDate = QDateTime::fromMSecsSinceEpoch(endMs);
+
+    std::unique_ptr<BacktestEngine> engine;
+    bool success = true;
+    runner.run("backtest/runBacktest", rowsPerSymbol * symbolCount,
+               [&]() {
+                   engine.reset(new BacktestEngine);
+                   engine->setDataManager(dataManager);
+                   engine->setBacktestParams(params);
+                   engine->setProgressInterval(0, 0);
+                   engine->addStrategy(std::make_shared<BenchStrategy>());
+               },
+               [&]() { success = engine->runBacktest() && success; });
+    return success;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("kquant_bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("kquant performance benchmarks");
+    parser.addHelpOption();
+    parser.addPositionalArgument("cases", "benchmark cases: csv, kline, indicator, kernels, cross, backtest or all", "[cases...]");
+    QCommandLineOption seedOption("seed", "random seed for synthetic data", "n", "20240101");
+    QCommandLineOption rowsOption("rows", "number of synthetic ticks", "n", "200000");
+    QCommandLineOption barsOption("bars", "number of synthetic bars for indicator cases", "n", "100000");
+    QCommandLineOption kernelBarsOption("kernel-bars", "series length for the kernels case", "n", "10000000");
+    QCommandLineOption symbolsOption("symbols", "number of symbols in the backtest case", "n", "4");
+    QCommandLineOption universeOption("universe", "number of symbols in the cross case", "n", "5000");
+    QCommandLineOption iterationsOption("iterations", "timed iterations per case", "n", "10");
+    QCommandLineOption warmupOption("warmup", "untimed warm-up iterations per case", "n", "1");
+    QCommandLineOption fileOption("file", "input file for the csv case instead of synthetic data", "path");
+    QCommandLineOption threadsOption("threads", "CsvReader worker threads (0 = thread pool default)", "n", "0");
+    QCommandLineOption jsonOption("json", "write results as JSON to the given file", "path");
+    parser.addOption(seedOption);
+    parser.addOption(rowsOption);
+    parser.addOption(barsOption);
+    parser.addOption(kernelBarsOption);
+    parser.addOption(symbolsOption);
+    parser.addOption(universeOption);
+    parser.addOption(iterationsOption);
+    parser.addOption(warmupOption);
+    parser.addOption(fileOption);
+    parser.addOption(threadsOption);
+    parser.addOption(jsonOption);
+    parser.process(app);
+
+    BenchOptions options;
+    options.seed = parser.value(seedOption).toULongLong();
+    options.rows = parser.value(rowsOption).toLongLong();
+    options.bars = parser.value(barsOption).toLongLong();
+    options.kernelBars = parser.value(kernelBarsOption).toLongLong();
+    options.symbols = parser.value(symbolsOption).toInt();
+    options.universe = parser.value(universeOption).toInt();
+    options.threads = parser.value(threadsOption).toInt();
+    options.file = parser.value(fileOption);
+
+    QStringList cases = parser.positionalArguments();
+    if (cases.isEmpty() || cases.contains("all")) {
+        cases = QStringList() << "csv" << "kline" << "indicator" << "kernels" << "cross" << "backtest";
+    }
+
+    BenchRunner runner(parser.value(iterationsOption).toInt(),
+                       parser.value(warmupOption).toInt());
+
+    int exitCode = 0;
+    for (const QString &name : cases) {
+        bool ok = false;
+        if (name == "csv") {
+            ok = benchCsv(runner, options);
+        } else if (name == "kline") {
+            ok = benchKline(runner, options);
+        } else if (name == "indicator") {
+            ok = benchIndicator(runner, options);
+        } else if (name == "kernels") {
+            ok = benchKernels(runner, options);
+        } else if (name == "cross") {
+            ok = benchCrossSection(runner, options);
+        } else if (name == "backtest") {
+            ok = benchBacktest(runner, options);
+        } else {
+            std::fprintf(stderr, "unknown case: %s\n", qPrintable(name));
+        }
+        if (!ok) {
+            exitCode = 1;
+        }
+    }
+
+    if (parser.isSet(jsonOption)) {
+        QJsonObject context;
+        context["seed"] = QString::number(options.seed);
+        context["rows"] = static_cast<double>(options.rows);
+        context["bars"] = static_cast<double>(options.bars);
+        context["kernelBars"] = static_cast<double>(options.kernelBars);
+        context["symbols"] = options.symbols;
+        context["universe"] = options.universe;
+        context["threads"] = options.threads;
+        context["cases"] = QJsonArray::fromStringList(cases);
+        if (!options.file.isEmpty()) {
+            context["file"] = options.file;
+        }
+        if (!runner.writeJson(parser.value(jsonOption), context)) {
+            std::fprintf(stderr, "failed to write %s\n", qPrintable(parser.value(jsonOption)));
+            exitCode = 1;
+        }
+    }
+
+    return exitCode;
+}
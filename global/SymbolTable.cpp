@@ -0,0 +1,59 @@
+#include "SymbolTable.h"
+
+SymbolTable::SymbolTable() {
+    // 下标0保留给kInvalidId
+    m_symbols.append(QString());
+}
+
+SymbolTable::~SymbolTable() {
+}
+
+SymbolTable* SymbolTable::instance() {
+    // 局部静态变量的初始化是线程安全的
+    static SymbolTable table;
+    return &table;
+}
+
+quint32 SymbolTable::intern(const QString& symbol) {
+    if (symbol.isEmpty()) {
+        return kInvalidId;
+    }
+
+    {
+        QReadLocker locker(&m_lock);
+        auto it = m_ids.constFind(symbol);
+        if (it != m_ids.constEnd()) {
+            return it.value();
+        }
+    }
+
+    QWriteLocker locker(&m_lock);
+    // 加写锁前可能已被其他线程分配
+    auto it = m_ids.constFind(symbol);
+    if (it != m_ids.constEnd()) {
+        return it.value();
+    }
+
+    quint32 id = static_cast<quint32>(m_symbols.size());
+    m_symbols.append(symbol);
+    m_ids.insert(symbol, id);
+    return id;
+}
+
+quint32 SymbolTable::find(const QString& symbol) const {
+    QReadLocker locker(&m_lock);
+    return m_ids.value(symbol, kInvalidId);
+}
+
+QString SymbolTable::symbol(quint32 id) const {
+    QReadLocker locker(&m_lock);
+    if (id == kInvalidId || id >= static_cast<quint32>(m_symbols.size())) {
+        return QString();
+    }
+    return m_symbols.at(static_cast<int>(id));
+}
+
+int SymbolTable::count() const {
+    QReadLocker locker(&m_lock);
+    return m_symbols.size() - 1;
+}
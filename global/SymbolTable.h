@@ -0,0 +1,41 @@
+#ifndef SYMBOLTABLE_H
+#define SYMBOLTABLE_H
+
+#include <QString>
+#include <QHash>
+#include <QVector>
+#include <QReadWriteLock>
+
+// 交易品种代码驻留表
+// 进程内每个品种代码只分配一次连续的整数ID，行情、订单、持仓在入口处转换为ID后，
+// 热点路径上只需比较整数，按品种存放的状态也可以直接用ID作为数组下标。
+// ID从1开始分配，0表示未分配。所有接口均为线程安全。
+class SymbolTable {
+public:
+    static const quint32 kInvalidId = 0;
+
+    static SymbolTable* instance();
+
+    // 获取品种代码对应的ID，不存在时分配新ID（空代码返回kInvalidId）
+    quint32 intern(const QString& symbol);
+
+    // 查找品种代码对应的ID，不存在时返回kInvalidId
+    quint32 find(const QString& symbol) const;
+
+    // 获取ID对应的品种代码，ID无效时返回空字符串
+    QString symbol(quint32 id) const;
+
+    // 已分配的品种数量，有效ID范围为[1, count()]
+    int count() const;
+
+private:
+    SymbolTable();
+    ~SymbolTable();
+    Q_DISABLE_COPY(SymbolTable)
+
+    mutable QReadWriteLock m_lock;
+    QHash<QString, quint32> m_ids;
+    QVector<QString> m_symbols;
+};
+
+#endif // SYMBOLTABLE_H
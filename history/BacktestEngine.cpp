@@ -1,12 +1,27 @@
 ﻿#include "BacktestEngine.h"
+#include "../global/SymbolTable.h"
 #include <QDebug>
 #include <QThread>
 #include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QtConcurrent>
 #include <algorithm>
 #include <cmath>
 
+namespace {
+
+// 取消和进度检查的最大间隔（行情条数），检查本身也有开销，不必每条都做
+const qint64 kCheckStride = 1024;
+
+} // namespace
+
 BacktestEngine::BacktestEngine(QObject *parent)
     : QObject(parent)
+    , m_running(false)
+    , m_cancelRequested(false)
+    , m_progressEventInterval(0)
+    , m_progressMsecInterval(100)
+    , m_orderSequence(0)
 {
 }
 
@@ -40,19 +55,86 @@ void BacktestEngine::addStrategy(std::shared_ptr<Strategy> strategy)
 
 bool BacktestEngine::runBacktest()
 {
+    if (!acquireRun()) {
+        return false;
+    }
+    return runAcquired();
+}
+
+QFuture<bool> BacktestEngine::runBacktestAsync()
+{
+    // 在调用线程中占用运行标志，连续两次调用不会因任务尚未开始而都被接受
+    if (!acquireRun()) {
+        return QtConcurrent::run([]() {
+            return false;
+        });
+    }
+    return QtConcurrent::run([this]() {
+        return runAcquired();
+    });
+}
+
+bool BacktestEngine::isRunning() const
+{
+    return m_running.load();
+}
+
+bool BacktestEngine::acquireRun()
+{
+    bool expected = false;
+    if (!m_running.compare_exchange_strong(expected, true)) {
+        emit logMessage(tr("回测正在运行，忽略本次运行请求"), 1);
+        return false;
+    }
+    return true;
+}
+
+bool BacktestEngine::runAcquired()
+{
+    m_cancelRequested.store(false);
+
     if (!initialize()) {
+        m_running.store(false);
         emit logMessage(u8"回测初始化失败", 2);
         return false;
     }
 
-    execute();
+    bool completed = execute();
     cleanup();
-    calculateMetrics();
+
+    if (completed) {
+        calculateMetrics();
+    }
+
+    // 先释放运行标志再通知，槽函数中可以直接开始下一次回测
+    m_running.store(false);
+
+    if (!completed) {
+        emit logMessage(tr("回测已取消"), 1);
+        emit backtestCancelled();
+        return false;
+    }
 
     emit backtestFinished();
     return true;
 }
 
+void BacktestEngine::cancel()
+{
+    m_cancelRequested.store(true);
+}
+
+bool BacktestEngine::isCancelRequested() const
+{
+    return m_cancelRequested.load();
+}
+
+void BacktestEngine::setProgressInterval(qint64 eventInterval, qint64 msecInterval)
+{
+    m_progressEventInterval = qMax<qint64>(0, eventInterval);
+    m_progressMsecInterval = qMax<qint64>(0, msecInterval);
+}
+
 AppData::BacktestResult BacktestEngine::getBacktestResult() const
 {
     return m_result;
@@ -74,26 +156,17 @@ bool BacktestEngine::initialize()
     m_account.unrealizedPnL = 0.0;
     m_account.realizedPnL = 0.0;
 
+    m_account.positions.clear();
+    m_positions.clear();
+    m_orderBooks.clear();
+    m_orderSymbols.clear();
+
     // 加载市场数据
-    for (const auto &symbol : m_params.symbols) {
-        QVector<AppData::MarketData> symbolData;
-        if (!m_dataManager->loadHistoricalData(symbol, 
-                                              m_params.startDate, 
-                                              m_params.endDate, 
-                                              symbolData, 
-                                              m_params.timeFrame)) {
-            emit logMessage(tr("加载历史数据失败: %1").arg(symbol), 2);
-            return false;
-        }
-        m_marketData.append(symbolData);
+    m_eventStream.clear();
+    if (!loadMarketData()) {
+        return false;
     }
 
-    // 按时间排序市场数据
-    std::sort(m_marketData.begin(), m_marketData.end(), 
-              [](const AppData::MarketData &a, const AppData::MarketData &b) {
-                  return a.timestamp < b.timestamp;
-              });
-
     // 初始化策略
     for (auto &strategy : m_strategies) {
         strategy->setAccount(m_account);
@@ -103,30 +176,134 @@ bool BacktestEngine::initialize()
     return true;
 }
 
-void BacktestEngine::execute()
+bool BacktestEngine::loadMarketData()
 {
-    int totalSteps = m_marketData.size();
-    int currentStep = 0;
+    const int symbolCount = m_params.symbols.size();
+    QVector<std::shared_ptr<MarketEventSource>> sources(symbolCount);
+
+    // 有列式存储的品种直接使用内存映射视图，不把数据加载到内存
+    QVector<int> pending;
+    for (int i = 0; i < symbolCount; ++i) {
+        auto history = m_dataManager->openMappedHistory(m_params.symbols[i], m_params.timeFrame);
+        if (!history) {
+            pending.append(i);
+            continue;
+        }
+        history->adviseSequential();
+        BarView view = history->view(m_params.startDate.toMSecsSinceEpoch(),
+                                     m_params.endDate.toMSecsSinceEpoch());
+        sources[i] = std::make_shared<MappedEventSource>(history, view);
+    }
 
-    for (const auto &data : m_marketData) {
-        m_currentTime = data.timestamp;
+    // 其余品种的数据互不依赖，在线程池中并行加载
+    QVector<QVector<AppData::MarketData>> symbolData(pending.size());
+    QVector<QFuture<bool>> futures;
+    futures.reserve(pending.size());
+    for (int i = 0; i < pending.size(); ++i) {
+        const QString symbol = m_params.symbols[pending[i]];
+        QVector<AppData::MarketData> *output = &symbolData[i];
+        futures.append(QtConcurrent::run([this, symbol, output]() {
+            return m_dataManager->loadHistoricalData(symbol,
+                                                     m_params.startDate,
+                                                     m_params.endDate,
+                                                     *output,
+                                                     m_params.timeFrame);
+        }));
+    }
 
-        // 更新策略
-        for (auto &strategy : m_strategies) {
-            strategy->onTick(data);
+    bool success = true;
+    for (int i = 0; i < pending.size(); ++i) {
+        if (!futures[i].result()) {
+            emit logMessage(tr("加载历史数据失败: %1").arg(m_params.symbols[pending[i]]), 2);
+            success = false;
+            continue;
         }
+        sources[pending[i]] = std::make_shared<VectorEventSource>(std::move(symbolData[i]));
+    }
+    if (!success) {
+        return false;
+    }
 
-        // 撮合订单
-        matchOrders(data);
+    // 每个品种的数据已按时间排序，由事件流在回测过程中按需归并，无需整体重新排序
+    for (const auto &source : sources) {
+        m_eventStream.addSource(source);
+    }
+    return true;
+}
+
+bool BacktestEngine::execute()
+{
+    const qint64 totalSteps = m_eventStream.size();
+    qint64 currentStep = 0;
+
+    // 在界面线程中同步运行时才需要处理事件循环，工作线程中运行时不处理
+    const bool pumpEvents = QThread::currentThread() == thread();
+
+    // 取消和进度每隔checkStride条行情检查一次
+    const qint64 checkStride = m_progressEventInterval > 0
+                                   ? qMin(m_progressEventInterval, kCheckStride)
+                                   : kCheckStride;
+    qint64 untilCheck = checkStride;
+    qint64 lastReportedStep = 0;
+    qint64 lastReportedMsecs = 0;
+    int lastProgress = -1;
+    QElapsedTimer timer;
+    timer.start();
+
+    // 逐行从事件流中取出数据，复用同一个MarketData对象
+    AppData::MarketData data;
+    while (m_eventStream.next(data)) {
+        processMarketData(data);
+        ++currentStep;
+
+        if (--untilCheck > 0) {
+            continue;
+        }
+        untilCheck = checkStride;
+
+        if (m_cancelRequested.load(std::memory_order_relaxed)) {
+            return false;
+        }
 
         // 更新进度
-        currentStep++;
+        const qint64 elapsed = timer.elapsed();
+        const bool eventsDue = m_progressEventInterval > 0
+                               && currentStep - lastReportedStep >= m_progressEventInterval;
+        const bool timeDue = m_progressMsecInterval > 0
+                             && elapsed - lastReportedMsecs >= m_progressMsecInterval;
+        if (!eventsDue && !timeDue) {
+            continue;
+        }
+        lastReportedStep = currentStep;
+        lastReportedMsecs = elapsed;
+
         int progress = static_cast<int>(currentStep * 100.0 / totalSteps);
-        emit progressUpdated(progress);
+        if (progress != lastProgress) {
+            lastProgress = progress;
+            emit progressUpdated(progress);
+        }
 
         // 处理事件循环
-        QCoreApplication::processEvents();
+        if (pumpEvents) {
+            QCoreApplication::processEvents();
+        }
     }
+
+    emit progressUpdated(100);
+    return true;
+}
+
+void BacktestEngine::processMarketData(const AppData::MarketData &data)
+{
+    m_currentTime = data.timestamp;
+
+    // 更新策略
+    for (auto &strategy : m_strategies) {
+        strategy->onTick(data);
+    }
+
+    // 撮合订单
+    matchOrders(data);
 }
 
 void BacktestEngine::cleanup()
@@ -134,110 +311,133 @@ void BacktestEngine::cleanup()
     for (auto &strategy : m_strategies) {
         strategy->cleanup();
     }
+
+    // 释放事件流持有的数据和内存映射
+    m_eventStream.clear();
 }
 
 void BacktestEngine::processOrder(const AppData::Order &order)
 {
-    m_activeOrders[order.orderId] = order;
+    AppData::Order activeOrder = order;
+    if (activeOrder.symbolId == SymbolTable::kInvalidId) {
+        activeOrder.symbolId = SymbolTable::instance()->intern(activeOrder.symbol);
+    }
+
+    // 没有订单ID的订单由引擎分配，否则同一个空ID的订单会互相覆盖
+    if (activeOrder.orderId.isEmpty()) {
+        activeOrder.orderId = QString("order_%1").arg(++m_orderSequence);
+    }
+
+    const int index = static_cast<int>(activeOrder.symbolId);
+    if (index >= m_orderBooks.size()) {
+        m_orderBooks.resize(index + 1);
+    }
+
+    // 同一订单ID重复提交时以新订单为准
+    auto previous = m_orderSymbols.constFind(activeOrder.orderId);
+    if (previous != m_orderSymbols.constEnd() && previous.value() != activeOrder.symbolId) {
+        m_orderBooks[static_cast<int>(previous.value())].remove(activeOrder.orderId);
+    }
+
+    m_orderBooks[index].add(activeOrder);
+    m_orderSymbols.insert(activeOrder.orderId, activeOrder.symbolId);
 }
 
 void BacktestEngine::processCancelOrder(const QString &orderId)
 {
-    if (m_activeOrders.contains(orderId)) {
-        m_activeOrders.remove(orderId);
+    auto it = m_orderSymbols.find(orderId);
+    if (it == m_orderSymbols.end()) {
+        return;
     }
+
+    m_orderBooks[static_cast<int>(it.value())].remove(orderId);
+    m_orderSymbols.erase(it);
 }
 
 void BacktestEngine::matchOrders(const AppData::MarketData &data)
 {
-    QVector<QString> toRemove;
-
-    for (auto it = m_activeOrders.begin(); it != m_activeOrders.end(); ++it) {
-        const auto &order = it.value();
-
-        // 检查订单是否匹配
-        bool matched = false;
-        double fillPrice = 0.0;
-
-        if (order.type == AppData::Market) {
-            // 市价单立即成交
-            matched = true;
-            fillPrice = data.close;
-        } else if (order.type == AppData::Limit) {
-            // 限价单检查价格
-            if ((order.direction == AppData::Long && order.price >= data.low) ||
-                (order.direction == AppData::Short && order.price <= data.high)) {
-                matched = true;
-                fillPrice = order.price;
-            }
-        } else if (order.type == AppData::Stop) {
-            // 止损单检查价格
-            if ((order.direction == AppData::Long && data.high >= order.stopPrice) ||
-                (order.direction == AppData::Short && data.low <= order.stopPrice)) {
-                matched = true;
-                fillPrice = order.stopPrice;
-            }
-        }
+    // 只撮合与当前行情同一品种的订单
+    quint32 symbolId = data.symbolId;
+    if (symbolId == SymbolTable::kInvalidId) {
+        symbolId = SymbolTable::instance()->find(data.symbol);
+    }
+    if (static_cast<int>(symbolId) >= m_orderBooks.size()) {
+        return;
+    }
 
-        if (matched) {
-            // 创建成交记录
-            AppData::Trade trade;
-            trade.tradeId = QString("trade_%1").arg(m_trades.size() + 1);
-            trade.orderId = order.orderId;
-            trade.symbol = order.symbol;
-            trade.tradeTime = m_currentTime;
-            trade.direction = order.direction;
-            trade.price = fillPrice;
-            trade.quantity = order.quantity;
-            trade.commission = trade.price * trade.quantity * m_params.commission;
-            trade.accountId = m_account.accountId;
-
-            // 更新订单状态
-            AppData::Order updatedOrder = order;
-            updatedOrder.status = AppData::Completed;
-            updatedOrder.filledQuantity = order.quantity;
-            updatedOrder.avgFillPrice = fillPrice;
-            updatedOrder.updateTime = m_currentTime;
-
-            // 添加到成交记录
-            m_trades.append(trade);
-
-            // 更新账户
-            updateAccount(trade);
-
-            // 通知策略
-            for (auto &strategy : m_strategies) {
-                strategy->updateOrder(updatedOrder);
-                strategy->onTrade(trade);
-            }
+    OrderBook &orderBook = m_orderBooks[static_cast<int>(symbolId)];
+    if (orderBook.isEmpty()) {
+        return;
+    }
 
-            // 标记订单为待删除
-            toRemove.append(order.orderId);
-        }
+    // 先从订单簿中取出所有成交的订单，再统一回调策略。
+    // 策略在回调中可能下新单，引起m_orderBooks扩容，因此回调期间不能持有其元素的引用
+    m_fills.clear();
+    orderBook.match(data, m_fills);
+    if (m_fills.isEmpty()) {
+        return;
+    }
+
+    const QVector<OrderBook::Fill> fills = m_fills;
+    for (const auto &fill : fills) {
+        m_orderSymbols.remove(fill.first.orderId);
     }
 
-    // 删除已成交的订单
-    for (const auto &orderId : toRemove) {
-        m_activeOrders.remove(orderId);
+    for (const auto &fill : fills) {
+        const AppData::Order &order = fill.first;
+        double fillPrice = fill.second;
+
+        // 创建成交记录
+        AppData::Trade trade;
+        trade.tradeId = QString("trade_%1").arg(m_trades.size() + 1);
+        trade.orderId = order.orderId;
+        trade.symbol = order.symbol;
+        trade.symbolId = order.symbolId;
+        trade.tradeTime = m_currentTime;
+        trade.direction = order.direction;
+        trade.price = fillPrice;
+        trade.quantity = order.quantity;
+        trade.commission = trade.price * trade.quantity * m_params.commission;
+        trade.accountId = m_account.accountId;
+
+        // 更新订单状态
+        AppData::Order updatedOrder = order;
+        updatedOrder.status = AppData::Completed;
+        updatedOrder.filledQuantity = order.quantity;
+        updatedOrder.avgFillPrice = fillPrice;
+        updatedOrder.updateTime = m_currentTime;
+
+        // 添加到成交记录
+        m_trades.append(trade);
+
+        // 更新账户
+        updateAccount(trade);
+
+        // 通知策略
+        for (auto &strategy : m_strategies) {
+            strategy->updateOrder(updatedOrder);
+            strategy->onTrade(trade);
+        }
     }
 }
 
 void BacktestEngine::updateAccount(const AppData::Trade &trade)
 {
+    auto &position = positionSlot(trade.symbolId);
+    bool hasPosition = position.symbolId != SymbolTable::kInvalidId;
+
     // 计算盈亏
     double pnl = 0.0;
     if (trade.direction == AppData::Long) {
         // 做多：卖出时计算盈亏
-        if (m_account.positions.contains(trade.symbol)) {
-            auto &position = m_account.positions[trade.symbol];
+        if (hasPosition) {
             if (position.direction == AppData::Long) {
                 pnl = (trade.price - position.avgPrice) * trade.quantity;
             }
         }
     } else {
         // 做空：买入时计算盈亏
-        if (m_account.positions.contains(trade.symbol)) {
-            auto &position = m_account.positions[trade.symbol];
+        if (hasPosition) {
             if (position.direction == AppData::Short) {
                 pnl = (position.avgPrice - trade.price) * trade.quantity;
             }
@@ -252,44 +452,53 @@ void BacktestEngine::updateAccount(const AppData::Trade &trade)
     // 更新持仓
     if (trade.direction == AppData::Long) {
         // 买入
-        if (!m_account.positions.contains(trade.symbol)) {
-            AppData::Position position;
+        if (!hasPosition) {
+            position = AppData::Position();
             position.symbol = trade.symbol;
+            position.symbolId = trade.symbolId;
             position.direction = AppData::Long;
             position.quantity = trade.quantity;
             position.avgPrice = trade.price;
             position.openTime = m_currentTime;
-            m_account.positions[trade.symbol] = position;
         } else {
-            auto &position = m_account.positions[trade.symbol];
             position.avgPrice = (position.avgPrice * position.quantity + trade.price * trade.quantity) / 
                                (position.quantity + trade.quantity);
             position.quantity += trade.quantity;
         }
     } else {
         // 卖出
-        if (!m_account.positions.contains(trade.symbol)) {
-            AppData::Position position;
+        if (!hasPosition) {
+            position = AppData::Position();
             position.symbol = trade.symbol;
+            position.symbolId = trade.symbolId;
             position.direction = AppData::Short;
             position.quantity = trade.quantity;
             position.avgPrice = trade.price;
             position.openTime = m_currentTime;
-            m_account.positions[trade.symbol] = position;
         } else {
-            auto &position = m_account.positions[trade.symbol];
             position.avgPrice = (position.avgPrice * position.quantity + trade.price * trade.quantity) / 
                                (position.quantity + trade.quantity);
             position.quantity += trade.quantity;
         }
     }
 
+    // 同步到账户持仓
+    m_account.positions[position.symbol] = position;
+
     // 更新策略账户信息
     for (auto &strategy : m_strategies) {
         strategy->setAccount(m_account);
     }
 }
 
+AppData::Position &BacktestEngine::positionSlot(quint32 symbolId)
+{
+    if (static_cast<int>(symbolId) >= m_positions.size()) {
+        m_positions.resize(static_cast<int>(symbolId) + 1);
+    }
+    return m_positions[static_cast<int>(symbolId)];
+}
+
 void BacktestEngine::calculateMetrics()
 {
     // 计算回测结果
@@ -3,14 +3,24 @@
 
 #include "Strategy.h"
 #include "HistoryDataManager.h"
+#include "MarketEventStream.h"
+#include "OrderBook.h"
 #include "../AppData.h"
 #include <QObject>
 #include <QVector>
 #include <QMap>
 #include <QDateTime>
+#include <QFuture>
+#include <atomic>
 #include <memory>
 
-// 回测引擎类
+/**
+ * @brief 回测引擎类
+ *
+ * 线程约定：同一引擎同时只运行一次回测，运行期间再次调用runBacktest()或
+ * runBacktestAsync()会被拒绝并返回false。运行期间不能修改参数、策略和数据管理器，
+ * 也不能销毁引擎；cancel()、isCancelRequested()和isRunning()可在任意线程调用。
+ */
 class BacktestEngine : public QObject
 {
     Q_OBJECT
@@ -25,9 +35,27 @@ public:
     // 添加策略
     void addStrategy(std::shared_ptr<Strategy> strategy);
 
-    // 运行回测
+    // 运行回测，已有回测在运行时返回false
     bool runBacktest();
 
+    // 在线程池的工作线程中运行回测，信号通过队列连接回到界面线程；
+    // 已有回测在运行时不启动新的回测，返回的任务结果为false
+    QFuture<bool> runBacktestAsync();
+
+    // 是否有回测在运行（线程安全）
+    bool isRunning() const;
+
+    // 请求取消正在运行的回测（线程安全），回测会在下一次检查时停止
+    void cancel();
+    bool isCancelRequested() const;
+
+    /**
+     * @brief 设置进度通知的频率，两个条件满足任意一个即发出progressUpdated
+     * @param eventInterval 每处理多少条行情通知一次，0表示不按条数通知
+     * @param msecInterval 每隔多少毫秒通知一次，0表示不按时间通知
+     */
+    void setProgressInterval(qint64 eventInterval, qint64 msecInterval);
+
     // 获取回测结果
     AppData::BacktestResult getBacktestResult() const;
 
@@ -38,13 +66,26 @@ signals:
     void progressUpdated(int progress);
     void logMessage(const QString &message, int level = 0);
     void backtestFinished();
+    void backtestCancelled();
 
 private:
+    // 占用运行标志，已有回测在运行时返回false
+    bool acquireRun();
+
+    // 在已占用运行标志的前提下执行一次完整的回测，结束时释放标志
+    bool runAcquired();
+
     // 初始化回测
     bool initialize();
 
-    // 执行回测
-    void execute();
+    // 为各品种建立行情游标：有列式存储的使用内存映射，其余并行加载
+    bool loadMarketData();
+
+    // 执行回测，被取消时返回false
+    bool execute();
+
+    // 处理一条行情数据
+    void processMarketData(const AppData::MarketData &data);
 
     // 清理回测
     void cleanup();
@@ -61,6 +102,9 @@ private:
     // 更新账户
     void updateAccount(const AppData::Trade &trade);
 
+    // 获取品种对应的持仓槽位，不存在时扩容
+    AppData::Position &positionSlot(quint32 symbolId);
+
     // 计算回测指标
     void calculateMetrics();
 
@@ -69,8 +113,16 @@ private:
     QVector<std::shared_ptr<Strategy>> m_strategies; // 策略列表
     std::shared_ptr<HistoryDataManager> m_dataManager; // 数据管理器
 
-    QVector<AppData::MarketData> m_marketData; // 市场数据
-    QMap<QString, AppData::Order> m_activeOrders; // 活动订单
+    MarketEventStream m_eventStream; // 按时间归并的多品种行情事件流
+    std::atomic<bool> m_running; // 是否有回测在运行
+    std::atomic<bool> m_cancelRequested; // 取消标志
+    qint64 m_progressEventInterval; // 进度通知的行情条数间隔
+    qint64 m_progressMsecInterval; // 进度通知的时间间隔(毫秒)
+    QVector<OrderBook> m_orderBooks; // 订单簿，按品种ID(SymbolTable)索引
+    QHash<QString, quint32> m_orderSymbols; // 活动订单ID到品种ID
+    QVector<OrderBook::Fill> m_fills; // 撮合结果缓冲区，避免每条行情分配内存
+    quint64 m_orderSequence; // 引擎分配订单ID的序号
+    QVector<AppData::Position> m_positions; // 持仓，按品种ID(SymbolTable)索引
     QVector<AppData::Trade> m_trades; // 成交记录
     AppData::Account m_account; // 账户信息
     QDateTime m_currentTime; // 当前回测时间
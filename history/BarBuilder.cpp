@@ -0,0 +1,158 @@
+﻿#include "BarBuilder.h"
+#include <limits>
+
+namespace {
+
+// 阈值比较的相对容差，避免价格区间、砖高因浮点误差差一点达不到阈值
+const double kRelativeEpsilon = 1e-9;
+
+} // namespace
+
+BarBuilder::BarBuilder()
+{
+    reset();
+}
+
+BarBuilder::BarBuilder(const BarSpec &spec)
+    : m_spec(spec)
+{
+    reset();
+}
+
+const BarSpec &BarBuilder::spec() const
+{
+    return m_spec;
+}
+
+void BarBuilder::reset()
+{
+    m_bar = AppData::Bar();
+    m_measure = 0.0;
+    m_lastMs = std::numeric_limits<qint64>::min();
+    m_renkoBase = 0.0;
+    m_renkoLevel = 0;
+    m_renkoDirection = 0;
+    m_renkoAnchored = false;
+}
+
+bool BarBuilder::hasOpenBar() const
+{
+    return m_bar.tickCount > 0;
+}
+
+const AppData::Bar &BarBuilder::openBar() const
+{
+    return m_bar;
+}
+
+int BarBuilder::add(qint64 msecs, quint32 symbolId, double price, double volume, double amount,
+                    double openInterest, QVector<AppData::Bar> &closed)
+{
+    if (msecs < m_lastMs || m_spec.isTimeBar() || !m_spec.isValid()) {
+        return 0;
+    }
+    m_lastMs = msecs;
+
+    if (m_bar.tickCount == 0) {
+        // 砖形图的走势从上一块砖的收盘价开始
+        const double open = m_renkoAnchored ? renkoPrice(m_renkoLevel) : price;
+        m_bar.timestamp = msecs;
+        m_bar.symbolId = symbolId;
+        m_bar.open = open;
+        m_bar.high = open;
+        m_bar.low = open;
+        m_bar.volume = 0.0;
+        m_bar.amount = 0.0;
+        m_measure = 0.0;
+    }
+
+    m_bar.high = qMax(m_bar.high, price);
+    m_bar.low = qMin(m_bar.low, price);
+    m_bar.close = price;
+    m_bar.volume += volume;
+    m_bar.amount += amount;
+    m_bar.openInterest = openInterest;
+    ++m_bar.tickCount;
+
+    switch (m_spec.type()) {
+        case AppData::VolumeBar: m_measure += volume; break;
+        case AppData::AmountBar: m_measure += amount > 0 ? amount : price * volume; break;
+        case AppData::TickCountBar: m_measure += 1.0; break;
+        case AppData::RangeBar: m_measure = m_bar.high - m_bar.low; break;
+        case AppData::RenkoBar: {
+            const int before = closed.size();
+            addRenko(msecs, price, closed);
+            return closed.size() - before;
+        }
+        default: return 0;
+    }
+
+    if (m_measure < m_spec.size() * (1.0 - kRelativeEpsilon)) {
+        return 0;
+    }
+    closed.append(m_bar);
+    m_bar.tickCount = 0;
+    return 1;
+}
+
+bool BarBuilder::flush(AppData::Bar &bar)
+{
+    if (m_bar.tickCount == 0 || m_spec.type() == AppData::RenkoBar) {
+        return false;
+    }
+    bar = m_bar;
+    m_bar.tickCount = 0;
+    return true;
+}
+
+double BarBuilder::renkoPrice(qint64 level) const
+{
+    return m_renkoBase + static_cast<double>(level) * m_spec.size();
+}
+
+void BarBuilder::addRenko(qint64 msecs, double price, QVector<AppData::Bar> &closed)
+{
+    if (!m_renkoAnchored) {
+        m_renkoBase = price;
+        m_renkoLevel = 0;
+        m_renkoAnchored = true;
+        return;
+    }
+
+    const double tolerance = m_spec.size() * kRelativeEpsilon;
+    for (;;) {
+        // 同向移动一个砖高，或反向移动两个砖高（反向砖从上一块砖的另一端开始）
+        qint64 openLevel = m_renkoLevel;
+        qint64 closeLevel;
+        if (m_renkoDirection >= 0 && price >= renkoPrice(m_renkoLevel + 1) - tolerance) {
+            closeLevel = m_renkoLevel + 1;
+        } else if (m_renkoDirection <= 0 && price <= renkoPrice(m_renkoLevel - 1) + tolerance) {
+            closeLevel = m_renkoLevel - 1;
+        } else if (m_renkoDirection > 0 && price <= renkoPrice(m_renkoLevel - 2) + tolerance) {
+            openLevel = m_renkoLevel - 1;
+            closeLevel = m_renkoLevel - 2;
+        } else if (m_renkoDirection < 0 && price >= renkoPrice(m_renkoLevel + 2) - tolerance) {
+            openLevel = m_renkoLevel + 1;
+            closeLevel = m_renkoLevel + 2;
+        } else {
+            break;
+        }
+
+        // 第一块砖带走累计的成交，同一笔成交生成的后续砖没有成交
+        AppData::Bar brick = m_bar;
+        if (m_bar.tickCount == 0) {
+            brick.timestamp = msecs;
+            brick.volume = 0.0;
+            brick.amount = 0.0;
+        }
+        brick.open = renkoPrice(openLevel);
+        brick.close = renkoPrice(closeLevel);
+        brick.high = qMax(brick.open, brick.close);
+        brick.low = qMin(brick.open, brick.close);
+        closed.append(brick);
+
+        m_renkoDirection = closeLevel > openLevel ? 1 : -1;
+        m_renkoLevel = closeLevel;
+        m_bar.tickCount = 0;
+    }
+}
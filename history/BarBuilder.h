@@ -0,0 +1,75 @@
+﻿#ifndef BARBUILDER_H
+#define BARBUILDER_H
+
+#include "../AppData.h"
+#include "BarSpec.h"
+#include <QVector>
+
+/**
+ * @brief 信息驱动K线的增量合成器
+ *
+ * 每笔成交以O(1)的工作量并入当前K线，批量合成（KlineGenerator::generateBarsFromTicks等）
+ * 和实时合成（KlineGenerator::processTick）使用同一个合成器，两者结果一致。
+ *
+ * 触发结束条件的那笔成交计入当前K线，K线的时间戳为其第一笔成交的时间。
+ * 砖形图的砖只含开盘价和收盘价两个边界，一笔成交跨越多个砖高时生成多块砖，
+ * 成交量计入第一块。时间早于上一笔的乱序成交忽略。
+ */
+class BarBuilder
+{
+public:
+    BarBuilder();
+    explicit BarBuilder(const BarSpec &spec);
+
+    const BarSpec &spec() const;
+
+    // 丢弃未完成的K线和砖形图的基准价
+    void reset();
+
+    // 是否有未完成的K线
+    bool hasOpenBar() const;
+
+    // 未完成的K线，砖形图为从上一块砖的收盘价开始的走势
+    const AppData::Bar &openBar() const;
+
+    /**
+     * @brief 并入一笔成交
+     * @param msecs 成交时间(epoch毫秒)
+     * @param symbolId 交易品种ID
+     * @param price 成交价
+     * @param volume 成交量
+     * @param amount 成交额，为0时成交额K线按价格乘成交量累计
+     * @param openInterest 持仓量
+     * @param closed 完成的K线追加到末尾
+     * @return 完成的K线数
+     */
+    int add(qint64 msecs, quint32 symbolId, double price, double volume, double amount,
+            double openInterest, QVector<AppData::Bar> &closed);
+
+    /**
+     * @brief 结束未完成的K线（收盘、断线或批量合成到末尾时）
+     *
+     * 砖形图未走完一个砖高时不构成砖，返回false并继续累计
+     * @param bar 输出的K线
+     * @return 是否输出了K线
+     */
+    bool flush(AppData::Bar &bar);
+
+private:
+    // 砖形图第level层的价格
+    double renkoPrice(qint64 level) const;
+
+    // 砖形图：根据最新价生成砖
+    void addRenko(qint64 msecs, double price, QVector<AppData::Bar> &closed);
+
+    BarSpec m_spec;
+    AppData::Bar m_bar;         // 未完成的K线，tickCount为0表示没有
+    double m_measure;           // 成交量/成交额/笔数的累计值，或价格区间
+    qint64 m_lastMs;            // 上一笔成交的时间
+    double m_renkoBase;         // 砖形图：第一笔成交价，砖的边界为 base + level * size
+    qint64 m_renkoLevel;        // 砖形图：上一块砖收盘价所在的层
+    int m_renkoDirection;       // 砖形图：上一块砖的方向，0表示还没有砖
+    bool m_renkoAnchored;       // 砖形图：是否已确定基准价
+};
+
+#endif // BARBUILDER_H
@@ -0,0 +1,168 @@
+﻿#include "BarSeries.h"
+#include <algorithm>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<AppData::Bar>::value, "Bar must be trivially copyable");
+
+BarSeries::BarSeries()
+    : m_symbolId(0)
+    , m_timeFrame(AppData::KUnknown)
+{
+}
+
+BarSeries::BarSeries(quint32 symbolId, AppData::TimeFrame timeFrame)
+    : m_symbolId(symbolId)
+    , m_timeFrame(timeFrame)
+{
+}
+
+void BarSeries::reserve(int size)
+{
+    m_timestamps.reserve(size);
+    m_opens.reserve(size);
+    m_highs.reserve(size);
+    m_lows.reserve(size);
+    m_closes.reserve(size);
+    m_volumes.reserve(size);
+    m_amounts.reserve(size);
+    m_tickCounts.reserve(size);
+    m_openInterests.reserve(size);
+}
+
+void BarSeries::clear()
+{
+    m_timestamps.clear();
+    m_opens.clear();
+    m_highs.clear();
+    m_lows.clear();
+    m_closes.clear();
+    m_volumes.clear();
+    m_amounts.clear();
+    m_tickCounts.clear();
+    m_openInterests.clear();
+}
+
+void BarSeries::append(const AppData::Bar &bar)
+{
+    m_timestamps.append(bar.timestamp);
+    m_opens.append(bar.open);
+    m_highs.append(bar.high);
+    m_lows.append(bar.low);
+    m_closes.append(bar.close);
+    m_volumes.append(bar.volume);
+    m_amounts.append(bar.amount);
+    m_tickCounts.append(bar.tickCount);
+    m_openInterests.append(bar.openInterest);
+}
+
+void BarSeries::replaceLast(const AppData::Bar &bar)
+{
+    if (isEmpty()) {
+        append(bar);
+        return;
+    }
+
+    const int i = size() - 1;
+    m_timestamps[i] = bar.timestamp;
+    m_opens[i] = bar.open;
+    m_highs[i] = bar.high;
+    m_lows[i] = bar.low;
+    m_closes[i] = bar.close;
+    m_volumes[i] = bar.volume;
+    m_amounts[i] = bar.amount;
+    m_tickCounts[i] = bar.tickCount;
+    m_openInterests[i] = bar.openInterest;
+}
+
+AppData::Bar BarSeries::at(int i) const
+{
+    AppData::Bar bar;
+    bar.timestamp = m_timestamps[i];
+    bar.symbolId = m_symbolId;
+    bar.tickCount = m_tickCounts[i];
+    bar.open = m_opens[i];
+    bar.high = m_highs[i];
+    bar.low = m_lows[i];
+    bar.close = m_closes[i];
+    bar.volume = m_volumes[i];
+    bar.amount = m_amounts[i];
+    bar.openInterest = m_openInterests[i];
+    return bar;
+}
+
+AppData::Bar BarSeries::last() const
+{
+    if (isEmpty()) {
+        AppData::Bar bar;
+        bar.symbolId = m_symbolId;
+        return bar;
+    }
+    return at(size() - 1);
+}
+
+int BarSeries::lowerBound(qint64 timestamp) const
+{
+    return std::lower_bound(m_timestamps.constBegin(), m_timestamps.constEnd(), timestamp)
+           - m_timestamps.constBegin();
+}
+
+AppData::Bar BarSeries::toBar(const AppData::MarketData &data)
+{
+    return toBar(data, data.symbolId);
+}
+
+AppData::Bar BarSeries::toBar(const AppData::MarketData &data, quint32 symbolId)
+{
+    AppData::Bar bar;
+    bar.timestamp = data.timestamp.toMSecsSinceEpoch();
+    bar.symbolId = symbolId;
+    bar.tickCount = data.tickCount;
+    bar.open = data.open;
+    bar.high = data.high;
+    bar.low = data.low;
+    bar.close = data.close;
+    bar.volume = data.volume;
+    bar.amount = data.amount;
+    bar.openInterest = data.openInterest;
+    return bar;
+}
+
+AppData::MarketData BarSeries::toMarketData(const AppData::Bar &bar, const QString &symbol)
+{
+    AppData::MarketData data;
+    data.symbol = symbol;
+    data.symbolId = bar.symbolId;
+    data.timestamp = QDateTime::fromMSecsSinceEpoch(bar.timestamp);
+    data.price = bar.close;
+    data.open = bar.open;
+    data.high = bar.high;
+    data.low = bar.low;
+    data.close = bar.close;
+    data.volume = bar.volume;
+    data.amount = bar.amount;
+    data.tickCount = bar.tickCount;
+    data.openInterest = bar.openInterest;
+    return data;
+}
+
+BarSeries BarSeries::fromMarketData(const QVector<AppData::MarketData> &data,
+                                    quint32 symbolId,
+                                    AppData::TimeFrame timeFrame)
+{
+    BarSeries series(symbolId, timeFrame);
+    series.reserve(data.size());
+    for (const auto &item : data) {
+        series.append(toBar(item, symbolId));
+    }
+    return series;
+}
+
+QVector<AppData::MarketData> BarSeries::toMarketData(const QString &symbol) const
+{
+    QVector<AppData::MarketData> data;
+    data.reserve(size());
+    for (int i = 0; i < size(); ++i) {
+        data.append(toMarketData(at(i), symbol));
+    }
+    return data;
+}
@@ -0,0 +1,122 @@
+﻿#ifndef BARSERIES_H
+#define BARSERIES_H
+
+#include "../AppData.h"
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief 结构数组(SoA)形式的K线序列
+ *
+ * 时间戳和开高低收量额分别存放在各自连续的数组中，指标计算等只需要
+ * 某几列的场景可以直接顺序遍历对应数组，避免逐个拷贝MarketData。
+ * 同一序列内的K线属于同一品种、同一周期。
+ */
+class BarSeries
+{
+public:
+    BarSeries();
+    explicit BarSeries(quint32 symbolId, AppData::TimeFrame timeFrame = AppData::KUnknown);
+
+    // 交易品种ID
+    quint32 symbolId() const { return m_symbolId; }
+    void setSymbolId(quint32 symbolId) { m_symbolId = symbolId; }
+
+    // 时间周期
+    AppData::TimeFrame timeFrame() const { return m_timeFrame; }
+    void setTimeFrame(AppData::TimeFrame timeFrame) { m_timeFrame = timeFrame; }
+
+    // 行数
+    int size() const { return m_timestamps.size(); }
+    bool isEmpty() const { return m_timestamps.isEmpty(); }
+
+    // 预留容量
+    void reserve(int size);
+
+    // 清空数据（保留品种和周期）
+    void clear();
+
+    // 追加一根K线
+    void append(const AppData::Bar &bar);
+
+    // 覆盖最后一根K线（用于更新未完成的K线），序列为空时追加
+    void replaceLast(const AppData::Bar &bar);
+
+    // 获取第i根K线
+    AppData::Bar at(int i) const;
+
+    // 获取最后一根K线，序列为空时返回默认值
+    AppData::Bar last() const;
+
+    // 各列数组
+    const QVector<qint64> &timestamps() const { return m_timestamps; }
+    const QVector<double> &opens() const { return m_opens; }
+    const QVector<double> &highs() const { return m_highs; }
+    const QVector<double> &lows() const { return m_lows; }
+    const QVector<double> &closes() const { return m_closes; }
+    const QVector<double> &volumes() const { return m_volumes; }
+    const QVector<double> &amounts() const { return m_amounts; }
+
+    /**
+     * @brief 查找第一根时间戳不小于timestamp的K线
+     * @param timestamp 时间戳(毫秒)
+     * @return 行号，不存在时返回size()
+     */
+    int lowerBound(qint64 timestamp) const;
+
+    /**
+     * @brief 将MarketData转换为Bar，交易品种ID取data.symbolId
+     * @param data 行情数据
+     * @return 紧凑K线
+     */
+    static AppData::Bar toBar(const AppData::MarketData &data);
+
+    /**
+     * @brief 将MarketData转换为Bar
+     * @param data 行情数据
+     * @param symbolId 交易品种ID，覆盖data.symbolId
+     * @return 紧凑K线
+     */
+    static AppData::Bar toBar(const AppData::MarketData &data, quint32 symbolId);
+
+    /**
+     * @brief 将Bar转换为MarketData，最新价取收盘价，交易品种ID取bar.symbolId
+     * @param bar 紧凑K线
+     * @param symbol 交易品种代码
+     * @return 行情数据
+     */
+    static AppData::MarketData toMarketData(const AppData::Bar &bar, const QString &symbol);
+
+    /**
+     * @brief 由MarketData序列构造K线序列
+     * @param data 行情数据（按时间升序）
+     * @param symbolId 交易品种ID
+     * @param timeFrame 时间周期
+     * @return K线序列
+     */
+    static BarSeries fromMarketData(const QVector<AppData::MarketData> &data,
+                                    quint32 symbolId = 0,
+                                    AppData::TimeFrame timeFrame = AppData::KUnknown);
+
+    /**
+     * @brief 转换为MarketData序列，供尚未迁移的接口使用
+     * @param symbol 交易品种代码
+     * @return 行情数据
+     */
+    QVector<AppData::MarketData> toMarketData(const QString &symbol) const;
+
+private:
+    quint32 m_symbolId;
+    AppData::TimeFrame m_timeFrame;
+    QVector<qint64> m_timestamps;
+    QVector<double> m_opens;
+    QVector<double> m_highs;
+    QVector<double> m_lows;
+    QVector<double> m_closes;
+    QVector<double> m_volumes;
+    QVector<double> m_amounts;
+    QVector<qint32> m_tickCounts;
+    QVector<double> m_openInterests;
+};
+
+#endif // BARSERIES_H
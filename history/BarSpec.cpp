@@ -0,0 +1,123 @@
+﻿#include "BarSpec.h"
+#include <QDateTime>
+#include <cmath>
+
+namespace {
+
+// 信息驱动K线名称的前缀，按BarType顺序排列
+const char *const kTypePrefixes[] = {
+    "",         // TimeBar
+    "vol",      // VolumeBar
+    "amt",      // AmountBar
+    "ticks",    // TickCountBar
+    "range",    // RangeBar
+    "renko"     // RenkoBar
+};
+
+// 有数据目录的时间周期
+const AppData::TimeFrame kNamedTimeFrames[] = {
+    AppData::Tick, AppData::M1, AppData::M5, AppData::M15, AppData::M30,
+    AppData::H1, AppData::H4, AppData::D1, AppData::W1
+};
+
+} // namespace
+
+BarSpec::BarSpec()
+    : m_type(AppData::TimeBar), m_timeFrame(AppData::KUnknown), m_size(0.0)
+{
+}
+
+BarSpec::BarSpec(AppData::TimeFrame timeFrame)
+    : m_type(AppData::TimeBar), m_timeFrame(timeFrame), m_size(0.0)
+{
+}
+
+BarSpec::BarSpec(AppData::BarType type, double size)
+    : m_type(type), m_timeFrame(AppData::KUnknown), m_size(type == AppData::TimeBar ? 0.0 : size)
+{
+}
+
+bool BarSpec::isValid() const
+{
+    if (isTimeBar()) {
+        return m_timeFrame != AppData::KUnknown;
+    }
+    if (m_type < AppData::VolumeBar || m_type > AppData::RenkoBar) {
+        return false;
+    }
+    return std::isfinite(m_size) && m_size > 0.0;
+}
+
+QString BarSpec::name() const
+{
+    if (isTimeBar()) {
+        return timeFrameName(m_timeFrame);
+    }
+    if (!isValid()) {
+        return "unknown";
+    }
+    return QString("%1%2").arg(kTypePrefixes[m_type]).arg(QString::number(m_size, 'g', 12));
+}
+
+BarSpec BarSpec::fromName(const QString &name)
+{
+    for (AppData::TimeFrame timeFrame : kNamedTimeFrames) {
+        if (name == timeFrameName(timeFrame)) {
+            return BarSpec(timeFrame);
+        }
+    }
+
+    // "ticks"比"tick"长，按前缀匹配不会与tick周期混淆
+    for (int type = AppData::VolumeBar; type <= AppData::RenkoBar; ++type) {
+        const QString prefix = kTypePrefixes[type];
+        if (!name.startsWith(prefix)) {
+            continue;
+        }
+        bool ok = false;
+        const double size = name.mid(prefix.size()).toDouble(&ok);
+        const BarSpec spec(static_cast<AppData::BarType>(type), size);
+        return ok && spec.isValid() ? spec : BarSpec();
+    }
+    return BarSpec();
+}
+
+QString BarSpec::timeFrameName(AppData::TimeFrame timeFrame)
+{
+    switch (timeFrame) {
+        case AppData::Tick: return "tick";
+        case AppData::M1: return "1m";
+        case AppData::M5: return "5m";
+        case AppData::M15: return "15m";
+        case AppData::M30: return "30m";
+        case AppData::H1: return "1h";
+        case AppData::H4: return "4h";
+        case AppData::D1: return "1d";
+        case AppData::W1: return "1w";
+        default: return "unknown";
+    }
+}
+
+AppData::Candle BarSpec::toCandle(const AppData::Bar &bar, const QString &symbol) const
+{
+    AppData::Candle candle;
+    candle.symbol = symbol;
+    candle.symbolId = bar.symbolId;
+    candle.timeFrame = m_timeFrame;
+    candle.timestamp = QDateTime::fromMSecsSinceEpoch(bar.timestamp);
+    candle.open = bar.open;
+    candle.high = bar.high;
+    candle.low = bar.low;
+    candle.close = bar.close;
+    candle.volume = bar.volume;
+    candle.amount = bar.amount;
+    candle.tickCount = bar.tickCount;
+    candle.openInterest = bar.openInterest;
+    candle.barType = m_type;
+    candle.barSize = m_size;
+    return candle;
+}
+
+bool BarSpec::operator==(const BarSpec &other) const
+{
+    return m_type == other.m_type && m_timeFrame == other.m_timeFrame && m_size == other.m_size;
+}
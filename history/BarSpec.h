@@ -0,0 +1,66 @@
+﻿#ifndef BARSPEC_H
+#define BARSPEC_H
+
+#include "../AppData.h"
+#include <QString>
+
+/**
+ * @brief K线规格：时间K线的周期，或信息驱动K线的类型和阈值
+ *
+ * 信息驱动K线按成交活动而不是时间切分：
+ *   - 成交量/成交额/成交笔数K线：累计值达到阈值时结束
+ *   - 价格区间K线：最高价与最低价之差达到阈值时结束
+ *   - 砖形图：价格较上一块砖的收盘价同向移动一个砖高时生成一块砖，反向需要移动两个砖高
+ *
+ * 可由TimeFrame隐式构造，接受BarSpec的接口同样可以直接传入时间周期。
+ */
+class BarSpec
+{
+public:
+    // 无效规格
+    BarSpec();
+
+    // 时间K线
+    BarSpec(AppData::TimeFrame timeFrame);
+
+    // 信息驱动K线，size为阈值（成交量、成交额、笔数或价格）
+    BarSpec(AppData::BarType type, double size);
+
+    AppData::BarType type() const { return m_type; }
+
+    // 时间K线的周期，信息驱动K线为KUnknown
+    AppData::TimeFrame timeFrame() const { return m_timeFrame; }
+
+    // 信息驱动K线的阈值，时间K线为0
+    double size() const { return m_size; }
+
+    bool isTimeBar() const { return m_type == AppData::TimeBar; }
+    bool isValid() const;
+
+    /**
+     * @brief 规格名称，用作数据目录名和缓存键
+     *
+     * 时间K线为"1m"、"1d"等，信息驱动K线为类型前缀加阈值，
+     * 如"vol1000"、"amt5000000"、"ticks500"、"range0.5"、"renko10"
+     */
+    QString name() const;
+
+    // 由name()的结果解析，无法识别时返回无效规格
+    static BarSpec fromName(const QString &name);
+
+    // 时间周期对应的名称，即数据目录名
+    static QString timeFrameName(AppData::TimeFrame timeFrame);
+
+    // 转换为策略onBar()使用的K线结构
+    AppData::Candle toCandle(const AppData::Bar &bar, const QString &symbol) const;
+
+    bool operator==(const BarSpec &other) const;
+    bool operator!=(const BarSpec &other) const { return !(*this == other); }
+
+private:
+    AppData::BarType m_type;
+    AppData::TimeFrame m_timeFrame;
+    double m_size;
+};
+
+#endif // BARSPEC_H
@@ -0,0 +1,326 @@
+﻿#include "ColumnarStore.h"
+#include "CsvReader.h"
+#include "../global/SymbolTable.h"
+#include <QFile>
+#include <QSaveFile>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const char kMagic[4] = {'K', 'Q', 'C', 'S'};
+
+static_assert(sizeof(ColumnarStore::FileHeader) == 128, "FileHeader must be 128 bytes");
+static_assert(sizeof(ColumnarStore::BlockIndex) == 16, "BlockIndex must be 16 bytes");
+
+// double列与MarketData成员的对应关系，顺序与ColumnarStore::Column一致（不含时间戳列）
+double AppData::MarketData::* const kDoubleColumns[] = {
+    &AppData::MarketData::open,
+    &AppData::MarketData::high,
+    &AppData::MarketData::low,
+    &AppData::MarketData::close,
+    &AppData::MarketData::volume,
+    &AppData::MarketData::amount,
+    &AppData::MarketData::bidPrice,
+    &AppData::MarketData::bidVolume,
+    &AppData::MarketData::askPrice,
+    &AppData::MarketData::askVolume
+};
+
+static_assert(sizeof(kDoubleColumns) / sizeof(kDoubleColumns[0]) == ColumnarStore::ColumnCount - 1,
+              "column table out of sync");
+
+// 校验值的初值和混合一步：按8字节的位模式逐个并入
+const quint64 kChecksumSeed = 0xcbf29ce484222325ULL;
+
+inline quint64 mixChecksum(quint64 checksum, quint64 word)
+{
+    checksum = (checksum ^ word) * 0x100000001b3ULL;
+    return checksum ^ (checksum >> 29);
+}
+
+// 从指定偏移读取定长字节
+bool readAt(QFile &file, qint64 offset, void *buffer, qint64 bytes)
+{
+    if (bytes == 0) {
+        return true;
+    }
+    if (!file.seek(offset)) {
+        return false;
+    }
+    return file.read(static_cast<char *>(buffer), bytes) == bytes;
+}
+
+} // namespace
+
+const char *const ColumnarStore::kFileSuffix = ".kbar";
+
+QString ColumnarStore::fileName(const QString &symbol)
+{
+    return symbol + kFileSuffix;
+}
+
+bool ColumnarStore::readHeader(const QString &filePath, FileHeader &header)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    if (file.read(reinterpret_cast<char *>(&header), sizeof(header)) != sizeof(header)) {
+        return false;
+    }
+
+    // 校验文件标识和版本
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion) {
+        return false;
+    }
+
+    // 校验文件大小与文件头描述是否一致
+    qint64 expectedSize = columnOffset(header, ColumnCount);
+    return header.rowsPerBlock > 0 && header.rowCount >= 0 && file.size() >= expectedSize;
+}
+
+qint64 ColumnarStore::columnOffset(const FileHeader &header, int column)
+{
+    // 所有列宽度均为8字节
+    return static_cast<qint64>(sizeof(FileHeader))
+           + header.blockCount * static_cast<qint64>(sizeof(BlockIndex))
+           + column * header.rowCount * 8;
+}
+
+bool ColumnarStore::write(const QString &filePath,
+                          const QString &symbol,
+                          AppData::TimeFrame timeFrame,
+                          const QVector<AppData::MarketData> &data,
+                          quint32 rowsPerBlock)
+{
+    if (rowsPerBlock == 0) {
+        rowsPerBlock = kDefaultRowsPerBlock;
+    }
+
+    const qint64 rowCount = data.size();
+    const qint64 blockCount = (rowCount + rowsPerBlock - 1) / rowsPerBlock;
+
+    // 时间戳列，同时计算校验值：范围内的数据被替换而行数和首尾时间不变时也能识别出变化
+    QVector<qint64> timestamps(data.size());
+    quint64 checksum = kChecksumSeed;
+    for (int i = 0; i < data.size(); ++i) {
+        timestamps[i] = data[i].timestamp.toMSecsSinceEpoch();
+        checksum = mixChecksum(checksum, static_cast<quint64>(timestamps[i]));
+        for (double AppData::MarketData::*member : kDoubleColumns) {
+            quint64 bits;
+            std::memcpy(&bits, &(data[i].*member), sizeof(bits));
+            checksum = mixChecksum(checksum, bits);
+        }
+    }
+
+    // 文件头
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.timeFrame = timeFrame;
+    header.rowsPerBlock = rowsPerBlock;
+    header.rowCount = rowCount;
+    header.blockCount = blockCount;
+    header.firstTimestamp = rowCount > 0 ? timestamps.first() : 0;
+    header.lastTimestamp = rowCount > 0 ? timestamps.last() : 0;
+    header.checksum = checksum != 0 ? checksum : 1;
+    QByteArray symbolUtf8 = symbol.toUtf8();
+    std::memcpy(header.symbol, symbolUtf8.constData(),
+                qMin(symbolUtf8.size(), static_cast<int>(sizeof(header.symbol)) - 1));
+
+    // 块索引
+    QVector<BlockIndex> blocks(static_cast<int>(blockCount));
+    for (int b = 0; b < blocks.size(); ++b) {
+        qint64 first = static_cast<qint64>(b) * rowsPerBlock;
+        qint64 last = qMin(first + rowsPerBlock, rowCount) - 1;
+        blocks[b].firstTimestamp = timestamps[first];
+        blocks[b].lastTimestamp = timestamps[last];
+    }
+
+    // 使用QSaveFile保证写入过程中断时不会破坏原文件
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    bool ok = file.write(reinterpret_cast<const char *>(&header), sizeof(header)) == sizeof(header);
+    ok = ok && file.write(reinterpret_cast<const char *>(blocks.constData()),
+                          blockCount * sizeof(BlockIndex)) == qint64(blockCount * sizeof(BlockIndex));
+    ok = ok && file.write(reinterpret_cast<const char *>(timestamps.constData()),
+                          rowCount * 8) == rowCount * 8;
+
+    // 逐列写入double数据
+    QVector<double> column(data.size());
+    for (double AppData::MarketData::*member : kDoubleColumns) {
+        if (!ok) {
+            break;
+        }
+        for (int i = 0; i < data.size(); ++i) {
+            column[i] = data[i].*member;
+        }
+        ok = file.write(reinterpret_cast<const char *>(column.constData()), rowCount * 8) == rowCount * 8;
+    }
+
+    if (!ok) {
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
+
+bool ColumnarStore::read(const QString &filePath,
+                         qint64 startMs,
+                         qint64 endMs,
+                         QVector<AppData::MarketData> &data)
+{
+    FileHeader header;
+    if (!readHeader(filePath, header)) {
+        return false;
+    }
+
+    // 请求范围与文件无交集
+    if (header.rowCount == 0 || endMs < header.firstTimestamp || startMs > header.lastTimestamp) {
+        return true;
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    // 读取块索引
+    QVector<BlockIndex> blocks(static_cast<int>(header.blockCount));
+    if (!readAt(file, sizeof(FileHeader), blocks.data(), header.blockCount * sizeof(BlockIndex))) {
+        return false;
+    }
+
+    // 定位第一个可能包含startMs的块和第一个完全晚于endMs的块
+    auto firstBlock = std::lower_bound(blocks.constBegin(), blocks.constEnd(), startMs,
+                                       [](const BlockIndex &block, qint64 t) {
+                                           return block.lastTimestamp < t;
+                                       });
+    auto endBlock = std::upper_bound(firstBlock, blocks.constEnd(), endMs,
+                                     [](qint64 t, const BlockIndex &block) {
+                                         return t < block.firstTimestamp;
+                                     });
+    if (firstBlock >= endBlock) {
+        return true;
+    }
+
+    const qint64 firstRow = (firstBlock - blocks.constBegin()) * static_cast<qint64>(header.rowsPerBlock);
+    const qint64 endRow = qMin((endBlock - blocks.constBegin()) * static_cast<qint64>(header.rowsPerBlock),
+                               header.rowCount);
+
+    // 读取相关块的时间戳，并精确裁剪到请求范围
+    QVector<qint64> timestamps(static_cast<int>(endRow - firstRow));
+    if (!readAt(file, columnOffset(header, TimestampColumn) + firstRow * 8,
+                timestamps.data(), timestamps.size() * 8)) {
+        return false;
+    }
+
+    const int begin = std::lower_bound(timestamps.constBegin(), timestamps.constEnd(), startMs)
+                      - timestamps.constBegin();
+    const int end = std::upper_bound(timestamps.constBegin(), timestamps.constEnd(), endMs)
+                    - timestamps.constBegin();
+    const int count = end - begin;
+    if (count <= 0) {
+        return true;
+    }
+
+    // 预先构造输出行
+    const QString symbol = QString::fromUtf8(header.symbol, static_cast<int>(qstrnlen(header.symbol, sizeof(header.symbol))));
+    const quint32 symbolId = SymbolTable::instance()->intern(symbol);
+    const int base = data.size();
+    data.resize(base + count);
+    for (int i = 0; i < count; ++i) {
+        AppData::MarketData &row = data[base + i];
+        row.symbol = symbol;
+        row.symbolId = symbolId;
+        row.timestamp = QDateTime::fromMSecsSinceEpoch(timestamps[begin + i]);
+    }
+
+    // 逐列读取double数据
+    QVector<double> column(count);
+    for (int c = OpenColumn; c < ColumnCount; ++c) {
+        if (!readAt(file, columnOffset(header, c) + (firstRow + begin) * 8, column.data(), count * 8)) {
+            data.resize(base);
+            return false;
+        }
+        double AppData::MarketData::*member = kDoubleColumns[c - OpenColumn];
+        for (int i = 0; i < count; ++i) {
+            data[base + i].*member = column[i];
+        }
+    }
+
+    return true;
+}
+
+bool ColumnarStore::merge(const QString &filePath,
+                          const QString &symbol,
+                          AppData::TimeFrame timeFrame,
+                          const QVector<AppData::MarketData> &data)
+{
+    if (data.isEmpty()) {
+        return true;
+    }
+
+    // 新数据按时间排序（通常已有序，stable_sort开销很小）
+    QVector<AppData::MarketData> incoming = data;
+    std::stable_sort(incoming.begin(), incoming.end(),
+                     [](const AppData::MarketData &a, const AppData::MarketData &b) {
+                         return a.timestamp < b.timestamp;
+                     });
+
+    FileHeader header;
+    if (!QFile::exists(filePath) || !readHeader(filePath, header) || header.rowCount == 0) {
+        return write(filePath, symbol, timeFrame, incoming);
+    }
+
+    QVector<AppData::MarketData> existing;
+    if (!read(filePath, header.firstTimestamp, header.lastTimestamp, existing)) {
+        return false;
+    }
+
+    // 保留已有数据中早于/晚于新数据时间范围的部分，重叠部分以新数据为准
+    const QDateTime newFirst = incoming.first().timestamp;
+    const QDateTime newLast = incoming.last().timestamp;
+
+    QVector<AppData::MarketData> merged;
+    merged.reserve(existing.size() + incoming.size());
+    for (const auto &row : existing) {
+        if (row.timestamp < newFirst) {
+            merged.append(row);
+        }
+    }
+    merged.append(incoming);
+    for (const auto &row : existing) {
+        if (row.timestamp > newLast) {
+            merged.append(row);
+        }
+    }
+
+    return write(filePath, symbol, timeFrame, merged, header.rowsPerBlock);
+}
+
+qint64 ColumnarStore::importCsv(const QStringList &csvFiles,
+                               const QString &filePath,
+                               const QString &symbol,
+                               AppData::TimeFrame timeFrame)
+{
+    QVector<AppData::MarketData> rows;
+    for (const QString &csvFile : csvFiles) {
+        if (!CsvReader::load(csvFile, rows)) {
+            return -1;
+        }
+    }
+
+    if (rows.isEmpty()) {
+        return 0;
+    }
+
+    return merge(filePath, symbol, timeFrame, rows) ? rows.size() : -1;
+}
@@ -0,0 +1,144 @@
+﻿#ifndef COLUMNARSTORE_H
+#define COLUMNARSTORE_H
+
+#include "../AppData.h"
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @brief 列式二进制行情存储
+ *
+ * 每个品种、每个周期一个文件，文件布局如下（小端序）：
+ *   [FileHeader][BlockIndex x blockCount][timestamp列][open列]...[askVolume列]
+ *
+ * 所有列均为定长数组：时间戳为int64毫秒(epoch)，其余列为double，按时间升序排列。
+ * 块索引记录每个块（rowsPerBlock行）的首尾时间戳，按时间范围加载时通过块索引
+ * 直接定位到相关的块并按列读取，无需文本解析，也无需排序。
+ *
+ * 存储相关接口（本类、MappedHistory/BarView、HistoryDataManager::loadHistoricalData）
+ * 的时间范围均为包含两端的闭区间[startMs, endMs]。
+ */
+class ColumnarStore
+{
+public:
+    // 列定义，顺序即文件中的列顺序
+    enum Column {
+        TimestampColumn = 0,
+        OpenColumn,
+        HighColumn,
+        LowColumn,
+        CloseColumn,
+        VolumeColumn,
+        AmountColumn,
+        BidPriceColumn,
+        BidVolumeColumn,
+        AskPriceColumn,
+        AskVolumeColumn,
+        ColumnCount
+    };
+
+    // 文件头（128字节）
+    struct FileHeader {
+        char magic[4];          // 文件标识 "KQCS"
+        quint32 version;        // 格式版本
+        qint32 timeFrame;       // 时间周期(AppData::TimeFrame)
+        quint32 rowsPerBlock;   // 每个块的行数
+        qint64 rowCount;        // 总行数
+        qint64 blockCount;      // 块数量
+        qint64 firstTimestamp;  // 第一行时间戳(毫秒)
+        qint64 lastTimestamp;   // 最后一行时间戳(毫秒)
+        char symbol[32];        // 交易品种代码(UTF-8, 以0结尾)
+        quint64 checksum;       // 各列数据的校验值，每次写入重新计算；0表示文件由未记录校验值的旧版本写入
+        char reserved[40];      // 保留
+    };
+
+    // 块索引项
+    struct BlockIndex {
+        qint64 firstTimestamp;  // 块内第一行时间戳
+        qint64 lastTimestamp;   // 块内最后一行时间戳
+    };
+
+    static const quint32 kVersion = 1;
+    static const quint32 kDefaultRowsPerBlock = 4096;
+    static const char *const kFileSuffix;
+
+    /**
+     * @brief 获取品种对应的存储文件名
+     * @param symbol 交易品种代码
+     * @return 文件名（不含目录）
+     */
+    static QString fileName(const QString &symbol);
+
+    /**
+     * @brief 读取并校验文件头
+     * @param filePath 文件路径
+     * @param header 输出的文件头
+     * @return 是否成功
+     */
+    static bool readHeader(const QString &filePath, FileHeader &header);
+
+    /**
+     * @brief 计算某一列在文件中的起始偏移
+     * @param header 文件头
+     * @param column 列
+     * @return 字节偏移
+     */
+    static qint64 columnOffset(const FileHeader &header, int column);
+
+    /**
+     * @brief 将数据写入存储文件（覆盖写入），数据需按时间升序排列
+     * @param filePath 文件路径
+     * @param symbol 交易品种代码
+     * @param timeFrame 时间周期
+     * @param data 行情数据
+     * @param rowsPerBlock 每个块的行数
+     * @return 是否成功
+     */
+    static bool write(const QString &filePath,
+                      const QString &symbol,
+                      AppData::TimeFrame timeFrame,
+                      const QVector<AppData::MarketData> &data,
+                      quint32 rowsPerBlock = kDefaultRowsPerBlock);
+
+    /**
+     * @brief 按时间范围[startMs, endMs]读取数据，结果追加到data末尾
+     * @param filePath 文件路径
+     * @param startMs 开始时间(毫秒)
+     * @param endMs 结束时间(毫秒)
+     * @param data 输出数据
+     * @return 是否成功（范围内无数据也返回true）
+     */
+    static bool read(const QString &filePath,
+                     qint64 startMs,
+                     qint64 endMs,
+                     QVector<AppData::MarketData> &data);
+
+    /**
+     * @brief 将新数据合并进存储文件，已有数据中与新数据时间范围重叠的部分会被替换
+     * @param filePath 文件路径
+     * @param symbol 交易品种代码
+     * @param timeFrame 时间周期
+     * @param data 新数据
+     * @return 是否成功
+     */
+    static bool merge(const QString &filePath,
+                      const QString &symbol,
+                      AppData::TimeFrame timeFrame,
+                      const QVector<AppData::MarketData> &data);
+
+    /**
+     * @brief 从saveToCsv写出的CSV文件导入到存储文件（使用CsvReader并行解析）
+     * @param csvFiles CSV文件路径列表
+     * @param filePath 存储文件路径
+     * @param symbol 交易品种代码
+     * @param timeFrame 时间周期
+     * @return 导入的行数，失败返回-1
+     */
+    static qint64 importCsv(const QStringList &csvFiles,
+                            const QString &filePath,
+                            const QString &symbol,
+                            AppData::TimeFrame timeFrame);
+};
+
+#endif // COLUMNARSTORE_H
@@ -0,0 +1,462 @@
+﻿#include "CsvReader.h"
+#include "../global/SymbolTable.h"
+#include <QFile>
+#include <QByteArray>
+#include <QDateTime>
+#include <QThreadPool>
+#include <QFuture>
+#include <QtConcurrent>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+// 每个解析块的最小字节数，避免小文件被切得过碎
+const qint64 kMinChunkBytes = 1 << 20;
+
+// 每个线程分配的块数，块略多于线程数可以平衡各块解析速度的差异
+const int kChunksPerThread = 4;
+
+// saveToCsv写出的字段数
+const int kMaxFields = 12;
+
+// 双精度可精确表示的10的整数次幂
+const double kPow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+const quint64 kPow10u[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+    10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// 读取定长数字
+inline bool readDigits(const char *p, int count, int &value)
+{
+    value = 0;
+    for (int i = 0; i < count; ++i) {
+        if (!isDigit(p[i])) {
+            return false;
+        }
+        value = value * 10 + (p[i] - '0');
+    }
+    return true;
+}
+
+// 公历日期距1970-01-01的天数
+qint64 daysFromCivil(int year, int month, int day)
+{
+    year -= month <= 2;
+    const qint64 era = (year >= 0 ? year : year - 399) / 400;
+    const int yearOfEra = static_cast<int>(year - era * 400);
+    const int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+int daysInMonth(int year, int month)
+{
+    static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (month == 2 && ((year % 4 == 0 && year % 100 != 0) || year % 400 == 0)) {
+        return 29;
+    }
+    return days[month - 1];
+}
+
+// 本地时间的UTC偏移缓存，行情文件按时间排序，同一天的行只需查询一次时区
+struct LocalOffsetCache {
+    qint64 day = std::numeric_limits<qint64>::min();
+    int offsetSecs = 0;
+    bool uniform = false;   // 当天是否没有夏令时切换
+};
+
+thread_local LocalOffsetCache t_offsetCache;
+
+bool localToEpoch(int year, int month, int day, int hour, int minute, int second, int msec,
+                  qint64 &msecs)
+{
+    const qint64 days = daysFromCivil(year, month, day);
+    LocalOffsetCache &cache = t_offsetCache;
+    if (cache.day != days) {
+        const QDate date(year, month, day);
+        const int first = QDateTime(date, QTime(0, 0), Qt::LocalTime).offsetFromUtc();
+        const int last = QDateTime(date, QTime(23, 59, 59, 999), Qt::LocalTime).offsetFromUtc();
+        cache.day = days;
+        cache.offsetSecs = first;
+        cache.uniform = first == last;
+    }
+
+    if (cache.uniform) {
+        const qint64 secs = days * 86400 + hour * 3600 + minute * 60 + second - cache.offsetSecs;
+        msecs = secs * 1000 + msec;
+        return true;
+    }
+
+    // 夏令时切换当天交给QDateTime处理
+    QDateTime dateTime(QDate(year, month, day), QTime(hour, minute, second, msec), Qt::LocalTime);
+    if (!dateTime.isValid()) {
+        return false;
+    }
+    msecs = dateTime.toMSecsSinceEpoch();
+    return true;
+}
+
+// 每个解析块的状态
+struct ChunkParser {
+    QByteArray lastSymbolBytes;
+    QString lastSymbol;
+    quint32 lastSymbolId = SymbolTable::kInvalidId;
+
+    void parseLine(const char *line, const char *end, QVector<AppData::MarketData> &out);
+    void parse(const char *begin, const char *end, QVector<AppData::MarketData> &out);
+};
+
+void ChunkParser::parseLine(const char *line, const char *end, QVector<AppData::MarketData> &out)
+{
+    if (end > line && end[-1] == '\r') {
+        --end;
+    }
+
+    // 切分字段
+    const char *fieldBegin[kMaxFields];
+    const char *fieldEnd[kMaxFields];
+    int fieldCount = 0;
+    const char *p = line;
+    while (true) {
+        const char *comma = static_cast<const char *>(std::memchr(p, ',', end - p));
+        const char *stop = comma ? comma : end;
+        if (fieldCount < kMaxFields) {
+            fieldBegin[fieldCount] = p;
+            fieldEnd[fieldCount] = stop;
+        }
+        ++fieldCount;
+        if (!comma) {
+            break;
+        }
+        p = comma + 1;
+    }
+
+    // 确保字段数量正确
+    if (fieldCount < 8) {
+        return;
+    }
+
+    out.append(AppData::MarketData());
+    AppData::MarketData &marketData = out.last();
+
+    // 同一文件通常只有一个品种，按原始字节比较以复用上一行的QString
+    const int symbolLength = static_cast<int>(fieldEnd[0] - fieldBegin[0]);
+    if (symbolLength != lastSymbolBytes.size()
+        || std::memcmp(fieldBegin[0], lastSymbolBytes.constData(), symbolLength) != 0) {
+        lastSymbolBytes = QByteArray(fieldBegin[0], symbolLength);
+        lastSymbol = QString::fromUtf8(lastSymbolBytes);
+        lastSymbolId = SymbolTable::instance()->intern(lastSymbol);
+    }
+    marketData.symbol = lastSymbol;
+    marketData.symbolId = lastSymbolId;
+
+    qint64 msecs = 0;
+    if (CsvReader::parseDateTime(fieldBegin[1], fieldEnd[1], msecs)) {
+        marketData.timestamp = QDateTime::fromMSecsSinceEpoch(msecs);
+    } else {
+        marketData.timestamp = QDateTime::fromString(
+            QString::fromLatin1(fieldBegin[1], static_cast<int>(fieldEnd[1] - fieldBegin[1])), Qt::ISODate);
+    }
+
+    marketData.open = CsvReader::parseDouble(fieldBegin[2], fieldEnd[2]);
+    marketData.high = CsvReader::parseDouble(fieldBegin[3], fieldEnd[3]);
+    marketData.low = CsvReader::parseDouble(fieldBegin[4], fieldEnd[4]);
+    marketData.close = CsvReader::parseDouble(fieldBegin[5], fieldEnd[5]);
+    marketData.volume = CsvReader::parseDouble(fieldBegin[6], fieldEnd[6]);
+    marketData.amount = CsvReader::parseDouble(fieldBegin[7], fieldEnd[7]);
+
+    // 如果有买卖盘数据
+    if (fieldCount >= 12) {
+        marketData.bidPrice = CsvReader::parseDouble(fieldBegin[8], fieldEnd[8]);
+        marketData.bidVolume = CsvReader::parseDouble(fieldBegin[9], fieldEnd[9]);
+        marketData.askPrice = CsvReader::parseDouble(fieldBegin[10], fieldEnd[10]);
+        marketData.askVolume = CsvReader::parseDouble(fieldBegin[11], fieldEnd[11]);
+    }
+}
+
+void ChunkParser::parse(const char *begin, const char *end, QVector<AppData::MarketData> &out)
+{
+    // 按首行长度估算行数
+    const char *firstNewline = static_cast<const char *>(std::memchr(begin, '\n', end - begin));
+    if (firstNewline && firstNewline > begin) {
+        out.reserve(static_cast<int>((end - begin) / (firstNewline - begin + 1)) + 1);
+    }
+
+    const char *line = begin;
+    while (line < end) {
+        const char *newline = static_cast<const char *>(std::memchr(line, '\n', end - line));
+        const char *lineEnd = newline ? newline : end;
+        parseLine(line, lineEnd, out);
+        line = lineEnd + 1;
+    }
+}
+
+// 从pos开始找到下一行的行首
+const char *nextLineStart(const char *pos, const char *end)
+{
+    const char *newline = static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+    return newline ? newline + 1 : end;
+}
+
+} // namespace
+
+bool CsvReader::load(const QString &filePath, QVector<AppData::MarketData> &data, int threadCount)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const qint64 size = file.size();
+    if (size == 0) {
+        return true;
+    }
+
+    uchar *mapped = file.map(0, size);
+    if (!mapped) {
+        return false;
+    }
+
+    const char *fileBegin = reinterpret_cast<const char *>(mapped);
+    const char *fileEnd = fileBegin + size;
+
+    // 跳过CSV头
+    const char *body = nextLineStart(fileBegin, fileEnd);
+    const qint64 bodyBytes = fileEnd - body;
+
+    QThreadPool localPool;
+    QThreadPool *pool = QThreadPool::globalInstance();
+    if (threadCount > 0) {
+        localPool.setMaxThreadCount(threadCount);
+        pool = &localPool;
+    }
+
+    // 按换行符对齐切分
+    const qint64 maxChunks = qMax<qint64>(1, bodyBytes / kMinChunkBytes);
+    const int chunkCount = static_cast<int>(qMin<qint64>(pool->maxThreadCount() * kChunksPerThread, maxChunks));
+    QVector<const char *> bounds;
+    bounds.append(body);
+    for (int i = 1; i < chunkCount; ++i) {
+        const char *nominal = body + bodyBytes * i / chunkCount;
+        const char *start = nextLineStart(qMax(nominal, bounds.last()), fileEnd);
+        bounds.append(start);
+    }
+    bounds.append(fileEnd);
+
+    // 并行解析各块
+    QVector<QVector<AppData::MarketData>> results(chunkCount);
+    QVector<QFuture<void>> futures;
+    futures.reserve(chunkCount);
+    for (int i = 0; i < chunkCount; ++i) {
+        const char *chunkBegin = bounds[i];
+        const char *chunkEnd = bounds[i + 1];
+        QVector<AppData::MarketData> *chunkResult = &results[i];
+        futures.append(QtConcurrent::run(pool, [chunkBegin, chunkEnd, chunkResult]() {
+            ChunkParser parser;
+            parser.parse(chunkBegin, chunkEnd, *chunkResult);
+        }));
+    }
+    for (auto &future : futures) {
+        future.waitForFinished();
+    }
+
+    file.unmap(mapped);
+
+    // 按块顺序拼接
+    int total = 0;
+    for (const auto &chunk : results) {
+        total += chunk.size();
+    }
+    data.reserve(data.size() + total);
+    for (auto &chunk : results) {
+        for (auto &row : chunk) {
+            data.append(std::move(row));
+        }
+        chunk.clear();
+        chunk.squeeze();
+    }
+
+    return true;
+}
+
+double CsvReader::parseDouble(const char *begin, const char *end)
+{
+    const char *p = begin;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+
+    // value = mantissa * 10^exponent；末尾的0暂不乘入尾数，以尽量留在快速路径内
+    quint64 mantissa = 0;
+    int digits = 0;
+    int pendingZeros = 0;
+    int exponent = 0;
+    bool anyDigit = false;
+    bool inFraction = false;
+
+    for (; p < end; ++p) {
+        const char c = *p;
+        if (isDigit(c)) {
+            anyDigit = true;
+            if (inFraction) {
+                --exponent;
+            }
+            if (c == '0') {
+                ++pendingZeros;
+                continue;
+            }
+            if (mantissa == 0) {
+                mantissa = static_cast<quint64>(c - '0');
+                digits = 1;
+            } else {
+                if (digits + pendingZeros + 1 > 19) {
+                    return QByteArray(begin, static_cast<int>(end - begin)).toDouble();
+                }
+                mantissa = mantissa * kPow10u[pendingZeros + 1] + static_cast<quint64>(c - '0');
+                digits += pendingZeros + 1;
+            }
+            pendingZeros = 0;
+        } else if (c == '.' && !inFraction) {
+            inFraction = true;
+        } else {
+            break;
+        }
+    }
+
+    // 未乘入尾数的0
+    exponent += pendingZeros;
+
+    // 指数部分
+    if (p < end && (*p == 'e' || *p == 'E') && anyDigit) {
+        ++p;
+        bool negativeExp = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negativeExp = *p == '-';
+            ++p;
+        }
+        int exp = 0;
+        bool anyExpDigit = false;
+        for (; p < end && isDigit(*p) && exp < 10000; ++p) {
+            exp = exp * 10 + (*p - '0');
+            anyExpDigit = true;
+        }
+        if (!anyExpDigit) {
+            return QByteArray(begin, static_cast<int>(end - begin)).toDouble();
+        }
+        exponent += negativeExp ? -exp : exp;
+    }
+
+    // 含其他字符（空格、nan、inf等）时交给Qt处理
+    if (p != end || !anyDigit) {
+        if (begin == end) {
+            return 0.0;
+        }
+        return QByteArray(begin, static_cast<int>(end - begin)).toDouble();
+    }
+
+    if (mantissa == 0) {
+        return negative ? -0.0 : 0.0;
+    }
+
+    // 尾数不超过15位且指数在±22以内时，一次乘除即可得到正确舍入的结果
+    if (digits > 15 || exponent < -22 || exponent > 22) {
+        return QByteArray(begin, static_cast<int>(end - begin)).toDouble();
+    }
+
+    double value = static_cast<double>(mantissa);
+    value = exponent < 0 ? value / kPow10[-exponent] : value * kPow10[exponent];
+    return negative ? -value : value;
+}
+
+bool CsvReader::parseDateTime(const char *begin, const char *end, qint64 &msecs)
+{
+    // yyyy-MM-ddTHH:mm:ss
+    if (end - begin < 19
+        || begin[4] != '-' || begin[7] != '-' || begin[10] != 'T'
+        || begin[13] != ':' || begin[16] != ':') {
+        return false;
+    }
+
+    int year, month, day, hour, minute, second;
+    if (!readDigits(begin, 4, year) || !readDigits(begin + 5, 2, month)
+        || !readDigits(begin + 8, 2, day) || !readDigits(begin + 11, 2, hour)
+        || !readDigits(begin + 14, 2, minute) || !readDigits(begin + 17, 2, second)) {
+        return false;
+    }
+
+    if (month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month)
+        || hour > 23 || minute > 59 || second > 59) {
+        return false;
+    }
+
+    // 毫秒部分，超过3位时交给Qt处理舍入
+    const char *p = begin + 19;
+    int msec = 0;
+    if (p < end && (*p == '.' || *p == ',')) {
+        ++p;
+        int count = 0;
+        while (p < end && isDigit(*p)) {
+            if (++count > 3) {
+                return false;
+            }
+            msec = msec * 10 + (*p - '0');
+            ++p;
+        }
+        if (count == 0) {
+            return false;
+        }
+        for (; count < 3; ++count) {
+            msec *= 10;
+        }
+    }
+
+    // 不带时区，按本地时间处理
+    if (p == end) {
+        return localToEpoch(year, month, day, hour, minute, second, msec, msecs);
+    }
+
+    // 时区部分：Z、±HH:mm 或 ±HHmm
+    int offsetSecs = 0;
+    if (*p == 'Z' && p + 1 == end) {
+        offsetSecs = 0;
+    } else if (*p == '+' || *p == '-') {
+        const int sign = *p == '-' ? -1 : 1;
+        ++p;
+        int offsetHour = 0;
+        int offsetMinute = 0;
+        if (end - p == 5 && p[2] == ':') {
+            if (!readDigits(p, 2, offsetHour) || !readDigits(p + 3, 2, offsetMinute)) {
+                return false;
+            }
+        } else if (end - p == 4) {
+            if (!readDigits(p, 2, offsetHour) || !readDigits(p + 2, 2, offsetMinute)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+        offsetSecs = sign * (offsetHour * 3600 + offsetMinute * 60);
+    } else {
+        return false;
+    }
+
+    const qint64 secs = daysFromCivil(year, month, day) * 86400
+                        + hour * 3600 + minute * 60 + second - offsetSecs;
+    msecs = secs * 1000 + msec;
+    return true;
+}
@@ -0,0 +1,53 @@
+﻿#ifndef CSVREADER_H
+#define CSVREADER_H
+
+#include "../AppData.h"
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief 多线程CSV行情读取器
+ *
+ * 读取HistoryDataManager::saveToCsv写出的CSV文件。文件通过内存映射读入，
+ * 按换行符切分为若干块后在全局线程池中并行解析，最后按块的顺序拼接结果，
+ * 因此输出的行顺序与文件一致。
+ *
+ * 数值和ISO-8601时间使用手写解析器，不构造QString/QStringList；
+ * 遇到手写解析器不能精确处理的格式时回退到Qt的解析函数，结果与
+ * HistoryDataManager::loadFromCsv逐行解析保持一致。
+ */
+class CsvReader
+{
+public:
+    /**
+     * @brief 加载CSV文件，结果追加到data末尾
+     * @param filePath 文件路径
+     * @param data 输出数据
+     * @param threadCount 解析线程数，0表示使用全局线程池的最大线程数
+     * @return 是否成功（文件无法打开时返回false）
+     */
+    static bool load(const QString &filePath,
+                     QVector<AppData::MarketData> &data,
+                     int threadCount = 0);
+
+    /**
+     * @brief 解析一个十进制浮点数字段
+     * @param begin 字段起始
+     * @param end 字段结束
+     * @return 解析结果，无法解析时为0
+     */
+    static double parseDouble(const char *begin, const char *end);
+
+    /**
+     * @brief 解析一个ISO-8601时间字段(yyyy-MM-ddTHH:mm:ss[.zzz][Z|±HH:mm])
+     *
+     * 不带时区的时间按本地时间处理
+     * @param begin 字段起始
+     * @param end 字段结束
+     * @param msecs 输出的epoch毫秒
+     * @return 是否成功
+     */
+    static bool parseDateTime(const char *begin, const char *end, qint64 &msecs);
+};
+
+#endif // CSVREADER_H
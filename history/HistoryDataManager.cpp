@@ -12,6 +12,23 @@
 #include <QThread>
 
 #include "HistoryDataManager.h"
+#include "ColumnarStore.h"
+#include "CsvReader.h"
+#include "KlineGenerator.h"
+#include "MappedHistory.h"
+#include "../global/SymbolTable.h"
+
+#include <limits>
+
+namespace {
+
+// 派生K线文件格式版本，合成规则或文件格式变化时递增，使旧文件失效
+const int kDerivedFormatVersion = 1;
+
+// 派生K线所在的子目录
+const char *const kDerivedDirName = "derived";
+
+} // namespace
 
 // 构造函数
 HistoryDataManager::HistoryDataManager(QObject *parent) : QObject(parent)
@@ -52,23 +69,8 @@ QString HistoryDataManager::getDataDir() const
 // 获取数据文件路径
 QString HistoryDataManager::getDataFilePath(const QString &symbol, AppData::TimeFrame timeFrame) const
 {
-    // 创建基础目录结构
-    QString timeFrameStr;
-    switch (timeFrame) {
-        case AppData::Tick: timeFrameStr = "tick"; break;
-        case AppData::M1: timeFrameStr = "1m"; break;
-        case AppData::M5: timeFrameStr = "5m"; break;
-        case AppData::M15: timeFrameStr = "15m"; break;
-        case AppData::M30: timeFrameStr = "30m"; break;
-        case AppData::H1: timeFrameStr = "1h"; break;
-        case AppData::H4: timeFrameStr = "4h"; break;
-        case AppData::D1: timeFrameStr = "1d"; break;
-        case AppData::W1: timeFrameStr = "1w"; break;
-        default: timeFrameStr = "unknown"; break;
-    }
-    
     // 创建目录结构: D:/data/[timeframe]/[symbol]/
-    QString dirPath = QString("%1/%2/%3").arg(m_dataDir, timeFrameStr, symbol);
+    QString dirPath = QString("%1/%2/%3").arg(m_dataDir, BarSpec::timeFrameName(timeFrame), symbol);
     QDir dir(dirPath);
     if (!dir.exists()) {
         dir.mkpath(".");
@@ -79,6 +81,26 @@ QString HistoryDataManager::getDataFilePath(const QString &symbol, AppData::Time
     return dirPath;
 }
 
+// 获取列式存储文件路径: D:/data/[timeframe]/[symbol]/[symbol].kbar
+QString HistoryDataManager::getColumnarFilePath(const QString &symbol, AppData::TimeFrame timeFrame) const
+{
+    return getDataFilePath(symbol, timeFrame) + "/" + ColumnarStore::fileName(symbol);
+}
+
+// 数据目录中某周期下已有数据的品种
+QStringList HistoryDataManager::availableSymbols(AppData::TimeFrame timeFrame) const
+{
+    // 只读取目录，不创建缺失的目录
+    QDir dir(QString("%1/%2").arg(m_dataDir, BarSpec::timeFrameName(timeFrame)));
+    QStringList symbols;
+    for (const QString &symbol : dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name)) {
+        if (!QDir(dir.filePath(symbol)).entryList(QDir::Files).isEmpty()) {
+            symbols.append(symbol);
+        }
+    }
+    return symbols;
+}
+
 // 检查数据是否存在
 bool HistoryDataManager::hasHistoricalData(const QString &symbol, AppData::TimeFrame timeFrame) const
 {
@@ -89,6 +111,175 @@ bool HistoryDataManager::hasHistoricalData(const QString &symbol, AppData::TimeF
     return dir.exists() && !dir.entryList(QDir::Files).isEmpty();
 }
 
+// 源数据指纹
+QString HistoryDataManager::sourceFingerprint(const QString &symbol, AppData::TimeFrame sourceTimeFrame) const
+{
+    // 只读取目录，不创建缺失的目录
+    QDir dir(QString("%1/%2/%3").arg(m_dataDir, BarSpec::timeFrameName(sourceTimeFrame), symbol));
+    const QFileInfoList csvFiles = dir.entryInfoList(QStringList() << "*.csv", QDir::Files, QDir::Name);
+    
+    // 列式存储按文件头中的数据范围和校验值计入，由CSV导入或重新导入生成的相同数据不改变指纹
+    const QFileInfo columnarInfo(dir.filePath(ColumnarStore::fileName(symbol)));
+    ColumnarStore::FileHeader header;
+    const bool hasColumnar = ColumnarStore::readHeader(columnarInfo.filePath(), header);
+    if (csvFiles.isEmpty() && !hasColumnar) {
+        return QString();
+    }
+    
+    // 只读取目录信息和文件头，启动时的开销与文件大小无关
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    for (const QFileInfo &info : csvFiles) {
+        hash.addData(QString("%1|%2|%3\n")
+                     .arg(info.fileName())
+                     .arg(info.size())
+                     .arg(info.lastModified().toMSecsSinceEpoch())
+                     .toUtf8());
+    }
+    if (hasColumnar) {
+        hash.addData(QString("%1|%2|%3|%4|%5\n")
+                     .arg(ColumnarStore::kFileSuffix)
+                     .arg(header.rowCount)
+                     .arg(header.firstTimestamp)
+                     .arg(header.lastTimestamp)
+                     .arg(header.checksum)
+                     .toUtf8());
+        // 旧版本写入的文件没有校验值，退回按文件大小和修改时间判断
+        if (header.checksum == 0) {
+            hash.addData(QString("%1|%2\n")
+                         .arg(columnarInfo.size())
+                         .arg(columnarInfo.lastModified().toMSecsSinceEpoch())
+                         .toUtf8());
+        }
+    }
+    return hash.result().toHex();
+}
+
+// 获取派生K线文件路径
+QString HistoryDataManager::getDerivedFilePath(const QString &symbol,
+                                               const BarSpec &spec,
+                                               const QString &variant) const
+{
+    const QString source = sourceFingerprint(symbol, AppData::Tick);
+    if (source.isEmpty() || !spec.isValid()) {
+        return QString();
+    }
+    
+    // 时间K线沿用周期编号，已有的派生文件保持有效
+    const QString key = QString("v%1|%2|%3|%4")
+                        .arg(kDerivedFormatVersion)
+                        .arg(source)
+                        .arg(spec.isTimeBar() ? QString::number(spec.timeFrame()) : spec.name())
+                        .arg(variant);
+    const QString fileName = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Md5).toHex().left(16);
+    
+    // 只计算路径，目录由saveDerivedBars创建
+    const QString dirPath = QString("%1/%2/%3/%4").arg(m_dataDir, spec.name(), symbol, kDerivedDirName);
+    return dirPath + "/" + fileName + ColumnarStore::kFileSuffix;
+}
+
+// 加载派生K线
+bool HistoryDataManager::loadDerivedBars(const QString &symbol,
+                                         const BarSpec &spec,
+                                         QVector<AppData::MarketData> &data,
+                                         const QString &variant)
+{
+    const QString filePath = getDerivedFilePath(symbol, spec, variant);
+    if (filePath.isEmpty() || !QFile::exists(filePath)) {
+        return false;
+    }
+    
+    const int before = data.size();
+    if (!ColumnarStore::read(filePath,
+                             std::numeric_limits<qint64>::min(),
+                             std::numeric_limits<qint64>::max(),
+                             data)) {
+        emit logMessage(tr("派生K线文件读取失败: %1").arg(filePath), 1);
+        return false;
+    }
+    
+    emit logMessage(tr("从派生K线文件加载了 %1 条数据").arg(data.size() - before), 0);
+    return true;
+}
+
+// 保存派生K线
+bool HistoryDataManager::saveDerivedBars(const QString &symbol,
+                                         const BarSpec &spec,
+                                         const QVector<AppData::MarketData> &data,
+                                         const QString &variant)
+{
+    const QString filePath = getDerivedFilePath(symbol, spec, variant);
+    if (filePath.isEmpty() || data.isEmpty()) {
+        return false;
+    }
+    
+    QFileInfo saved(filePath);
+    QDir dir(saved.absolutePath());
+    if (!dir.exists()) {
+        dir.mkpath(".");
+    }
+    
+    if (!ColumnarStore::write(filePath, symbol, spec.timeFrame(), data)) {
+        emit logMessage(tr("保存派生K线失败: %1").arg(filePath), 2);
+        return false;
+    }
+    
+    // 删除对应旧tick文件的派生文件；同一规格按不同variant生成的文件也一并清理，
+    // 保证每个规格目录下只保留最近一次生成的结果
+    const QStringList stale = dir.entryList(QStringList() << QString("*%1").arg(ColumnarStore::kFileSuffix), QDir::Files);
+    for (const QString &fileName : stale) {
+        if (fileName != saved.fileName()) {
+            dir.remove(fileName);
+        }
+    }
+    
+    emit logMessage(tr("保存了 %1 条派生K线到文件: %2").arg(data.size()).arg(filePath), 0);
+    return true;
+}
+
+// 优先加载派生K线，否则由tick数据合成并写回
+bool HistoryDataManager::loadOrDeriveBars(const QString &symbol,
+                                          const BarSpec &spec,
+                                          KlineGenerator &generator,
+                                          QVector<AppData::MarketData> &data)
+{
+    if (spec.timeFrame() == AppData::Tick) {
+        emit logMessage(tr("tick数据不需要合成"), 1);
+        return false;
+    }
+    if (!spec.isValid()) {
+        emit logMessage(tr("无效的K线规格"), 1);
+        return false;
+    }
+    
+    // 先把CSV文件（包括导入之后新放入的）合并进列式存储，派生文件的指纹和合成所用的数据
+    // 都基于合并后的存储，不会出现按新指纹保存、却由缺少新数据的旧存储合成的结果
+    if (!importCsvToColumnar(symbol, AppData::Tick)) {
+        return false;
+    }
+    
+    // 时间K线按交易时段对齐的结果与按epoch对齐的结果分开保存，信息驱动K线与交易时段无关
+    const QString variant = spec.isTimeBar() ? generator.tradingSession().signature() : QString();
+    if (loadDerivedBars(symbol, spec, data, variant)) {
+        return true;
+    }
+    
+    // 直接在内存映射的视图上合成
+    std::shared_ptr<MappedHistory> history = openMappedHistory(symbol, AppData::Tick);
+    if (!history) {
+        emit logMessage(tr("没有可用于合成K线的tick数据: %1").arg(symbol), 1);
+        return false;
+    }
+    
+    const QVector<AppData::MarketData> bars = generator.generateBarsFromView(history->view(), spec);
+    if (bars.isEmpty()) {
+        return false;
+    }
+    
+    saveDerivedBars(symbol, spec, bars, variant);
+    data += bars;
+    return true;
+}
+
 // 从CSV文件加载数据
 bool HistoryDataManager::loadFromCsv(const QString &filePath, QVector<AppData::MarketData> &data)
 {
@@ -102,6 +293,10 @@ bool HistoryDataManager::loadFromCsv(const QString &filePath, QVector<AppData::M
     // 读取CSV头
     QString header = in.readLine();
     
+    // 同一文件通常只有一个品种，缓存上一行的品种ID
+    QString lastSymbol;
+    quint32 lastSymbolId = SymbolTable::kInvalidId;
+
     // 读取数据行
     while (!in.atEnd()) {
         QString line = in.readLine();
@@ -114,6 +309,11 @@ bool HistoryDataManager::loadFromCsv(const QString &filePath, QVector<AppData::M
         
         // 解析CSV数据
         marketData.symbol = fields[0];
+        if (marketData.symbol != lastSymbol) {
+            lastSymbol = marketData.symbol;
+            lastSymbolId = SymbolTable::instance()->intern(lastSymbol);
+        }
+        marketData.symbolId = lastSymbolId;
         marketData.timestamp = QDateTime::fromString(fields[1], Qt::ISODate);
         marketData.open = fields[2].toDouble();
         marketData.high = fields[3].toDouble();
@@ -123,7 +323,7 @@ bool HistoryDataManager::loadFromCsv(const QString &filePath, QVector<AppData::M
         marketData.amount = fields[7].toDouble();
         
         // 如果有买卖盘数据
-        if (fields.size() >= 11) {
+        if (fields.size() >= 12) {
             marketData.bidPrice = fields[8].toDouble();
             marketData.bidVolume = fields[9].toDouble();
             marketData.askPrice = fields[10].toDouble();
@@ -148,7 +348,7 @@ bool HistoryDataManager::saveToCsv(const QString &filePath, const QVector<AppDat
     QTextStream out(&file);
     
     // 写入CSV头
-    out << "Symbol,Timestamp,Open,High,Low,Close,Volume,Amount,BidPrice,BidVolume,AskPrice,AskVolume";
+    out << "Symbol,Timestamp,Open,High,Low,Close,Volume,Amount,BidPrice,BidVolume,AskPrice,AskVolume\n";
     
     // 写入数据行
     for (const auto &marketData : data) {
@@ -163,7 +363,7 @@ bool HistoryDataManager::saveToCsv(const QString &filePath, const QVector<AppDat
             << QString::number(marketData.bidPrice, 'f', 8) << ","
             << QString::number(marketData.bidVolume, 'f', 8) << ","
             << QString::number(marketData.askPrice, 'f', 8) << ","
-            << QString::number(marketData.askVolume, 'f', 8) << "";
+            << QString::number(marketData.askVolume, 'f', 8) << "\n";
     }
     
     file.close();
@@ -177,6 +377,28 @@ bool HistoryDataManager::loadHistoricalData(const QString &symbol,
                                           QVector<AppData::MarketData> &data,
                                           AppData::TimeFrame timeFrame)
 {
+    // 优先从列式存储加载：按块索引定位，无需文本解析和排序。
+    // 导入之后新放入目录的CSV文件先合并进来，否则部分覆盖的范围会漏掉这些数据
+    QString columnarPath = getColumnarFilePath(symbol, timeFrame);
+    if (QFile::exists(columnarPath)) {
+        importCsvToColumnar(symbol, timeFrame);
+        int before = data.size();
+        if (ColumnarStore::read(columnarPath,
+                                startTime.toMSecsSinceEpoch(),
+                                endTime.toMSecsSinceEpoch(),
+                                data)) {
+            int loaded = data.size() - before;
+            if (loaded > 0) {
+                emit logMessage(tr(u8"从列式存储加载了 %1 条数据").arg(loaded), 0);
+                return true;
+            }
+            // 列式文件可能早于之后追加的CSV文件生成，范围内没有数据时仍查找CSV
+            emit logMessage(tr("列式存储中没有符合时间范围的数据，回退到CSV: %1").arg(columnarPath), 0);
+        } else {
+            emit logMessage(tr("列式存储文件读取失败，回退到CSV: %1").arg(columnarPath), 1);
+        }
+    }
+
     // 获取数据目录
     QString dirPath = getDataFilePath(symbol, timeFrame);
     QDir dir(dirPath);
@@ -218,7 +440,7 @@ bool HistoryDataManager::loadHistoricalData(const QString &symbol,
         QVector<AppData::MarketData> fileData;
         QString filePath = dir.filePath(fileName);
         
-        if (loadFromCsv(filePath, fileData)) {
+        if (CsvReader::load(filePath, fileData)) {
             // 过滤时间范围内的数据
             for (const auto &marketData : fileData) {
                 if (marketData.timestamp >= startTime && marketData.timestamp <= endTime) {
@@ -257,55 +479,79 @@ bool HistoryDataManager::saveHistoricalData(const QString &symbol,
         return false;
     }
     
-    // 获取数据的时间范围
-    QDateTime startTime = data.first().timestamp;
-    QDateTime endTime = data.last().timestamp;
+    QString columnarPath = getColumnarFilePath(symbol, timeFrame);
     
-    // 获取数据目录
-    QString dirPath = getDataFilePath(symbol, timeFrame);
+    // 先导入目录中尚未导入的CSV文件，避免其数据被列式存储遮蔽或之后覆盖新数据
+    if (!importCsvToColumnar(symbol, timeFrame)) {
+        return false;
+    }
     
-    // 按照时间范围分割数据，确保每个文件不超过1GB
-    const qint64 MAX_FILE_SIZE = 1024 * 1024 * 1024; // 1GB
-    const int APPROX_RECORD_SIZE = 200; // 每条记录大约占用的字节数
-    const int MAX_RECORDS_PER_FILE = MAX_FILE_SIZE / APPROX_RECORD_SIZE;
+    // 合并写入列式存储，与已有数据重叠的时间范围以新数据为准
+    if (!ColumnarStore::merge(columnarPath, symbol, timeFrame, data)) {
+        emit logMessage(tr("保存数据到文件失败: %1").arg(columnarPath), 2);
+        return false;
+    }
     
-    // 分割数据
-    for (int i = 0; i < data.size(); i += MAX_RECORDS_PER_FILE) {
-        // 计算当前批次的结束索引
-        int endIndex = qMin(i + MAX_RECORDS_PER_FILE, data.size());
-        
-        // 提取当前批次的数据
-        QVector<AppData::MarketData> batchData;
-        for (int j = i; j < endIndex; j++) {
-            batchData.append(data[j]);
+    emit logMessage(tr("保存了 %1 条数据到文件: %2").arg(data.size()).arg(columnarPath), 0);
+    return true;
+}
+
+// 将数据目录中尚未导入的CSV文件导入到列式存储
+bool HistoryDataManager::importCsvToColumnar(const QString &symbol, AppData::TimeFrame timeFrame)
+{
+    QString dirPath = getDataFilePath(symbol, timeFrame);
+    QDir dir(dirPath);
+    QString columnarPath = getColumnarFilePath(symbol, timeFrame);
+    
+    // 已有列式存储时只导入修改时间晚于它的CSV文件
+    const QFileInfo columnarInfo(columnarPath);
+    const bool incremental = columnarInfo.exists();
+    QStringList csvFiles;
+    for (const QFileInfo &info : dir.entryInfoList(QStringList() << "*.csv", QDir::Files, QDir::Name)) {
+        if (!incremental || info.lastModified() > columnarInfo.lastModified()) {
+            csvFiles.append(info.filePath());
         }
-        
-        if (batchData.isEmpty()) continue;
-        
-        // 获取当前批次的时间范围
-        QDateTime batchStartTime = batchData.first().timestamp;
-        QDateTime batchEndTime = batchData.last().timestamp;
-        
-        // 生成文件名: symbol_starttime_endtime.csv
-        QString fileName = QString("%1_%2_%3.csv")
-                            .arg(symbol)
-                            .arg(batchStartTime.toString("yyyyMMdd-HHmmss"))
-                            .arg(batchEndTime.toString("yyyyMMdd-HHmmss"));
-        
-        QString filePath = dirPath + "/" + fileName;
-        
-        // 保存数据到CSV文件
-        if (saveToCsv(filePath, batchData)) {
-            emit logMessage(tr("保存了 %1 条数据到文件: %2").arg(batchData.size()).arg(fileName), 0);
-        } else {
-            emit logMessage(tr("保存数据到文件失败: %1").arg(fileName), 2);
+    }
+    if (csvFiles.isEmpty()) {
+        return true;
+    }
+    
+    // 合并按时间范围整体替换：新建时一次导入全部文件，增量导入时逐个文件合并，
+    // 避免多个文件的时间范围之间已有的数据被覆盖
+    const int batchSize = incremental ? 1 : csvFiles.size();
+    qint64 imported = 0;
+    for (int i = 0; i < csvFiles.size(); i += batchSize) {
+        const qint64 rows = ColumnarStore::importCsv(csvFiles.mid(i, batchSize), columnarPath, symbol, timeFrame);
+        if (rows < 0) {
+            emit logMessage(tr("CSV导入列式存储失败: %1").arg(dirPath), 2);
             return false;
         }
+        imported += rows;
     }
     
+    emit logMessage(tr("从 %1 个CSV文件导入了 %2 条数据到列式存储").arg(csvFiles.size()).arg(imported), 0);
     return true;
 }
 
+// 以内存映射方式打开列式存储
+std::shared_ptr<MappedHistory> HistoryDataManager::openMappedHistory(const QString &symbol,
+                                                                     AppData::TimeFrame timeFrame)
+{
+    QString columnarPath = getColumnarFilePath(symbol, timeFrame);
+    if (!QFile::exists(columnarPath)) {
+        return nullptr;
+    }
+    
+    // 映射前合并之后新放入目录的CSV文件，失败时仍使用已有数据
+    importCsvToColumnar(symbol, timeFrame);
+    
+    auto history = std::make_shared<MappedHistory>();
+    if (!history->open(columnarPath)) {
+        return nullptr;
+    }
+    return history;
+}
+
 // 从东方财富获取A股历史数据 (tick级别)
 bool HistoryDataManager::fetchEastMoneyData(const QString &symbol, 
                                           const QDateTime &startTime, 
@@ -406,6 +652,7 @@ bool HistoryDataManager::fetchEastMoneyData(const QString &symbol,
             
             AppData::MarketData marketData;
             marketData.symbol = symbol;
+            marketData.symbolId = SymbolTable::instance()->intern(symbol);
             
             // 解析时间戳 (格式为 HHmmss)
             QString timeStr = tick["time"].toString();
@@ -539,6 +786,7 @@ bool HistoryDataManager::fetchBinanceData(const QString &symbol,
             
             AppData::MarketData marketData;
             marketData.symbol = symbol;
+            marketData.symbolId = SymbolTable::instance()->intern(symbol);
             
             // 解析时间戳
             qint64 timestamp = trade["T"].toVariant().toLongLong();
@@ -671,6 +919,7 @@ bool HistoryDataManager::fetchOKXData(const QString &symbol,
 
             AppData::MarketData marketData;
             marketData.symbol = symbol;
+            marketData.symbolId = SymbolTable::instance()->intern(symbol);
             marketData.timestamp = QDateTime::fromString(tick["ts"].toString(), Qt::ISODate);
             marketData.close = tick["px"].toString().toDouble(); // 成交价
             marketData.volume = tick["sz"].toString().toDouble(); // 成交量
@@ -2,6 +2,7 @@
 #define HISTORYDATAMANAGER_H
 
 #include "../AppData.h"
+#include "BarSpec.h"
 #include <QObject>
 #include <QString>
 #include <QDateTime>
@@ -10,6 +11,10 @@
 #include <QFile>
 #include <QTextStream>
 #include <QDir>
+#include <memory>
+
+class KlineGenerator;
+class MappedHistory;
 
 // 历史数据管理器，负责获取和管理历史数据
 class HistoryDataManager : public QObject
@@ -23,7 +28,7 @@ public:
     void setDataDir(const QString &dirPath);
     QString getDataDir() const;
 
-    // 加载历史数据
+    // 加载[startTime, endTime]范围内的历史数据，两端均包含
     bool loadHistoricalData(const QString &symbol, 
                            const QDateTime &startTime, 
                            const QDateTime &endTime,
@@ -39,10 +44,58 @@ public:
     QString getDataFilePath(const QString &symbol, 
                            AppData::TimeFrame timeFrame = AppData::Tick) const;
 
+    // 获取列式存储文件路径
+    QString getColumnarFilePath(const QString &symbol,
+                               AppData::TimeFrame timeFrame = AppData::Tick) const;
+
+    // 数据目录中某周期下有数据文件的品种，按名称排序
+    QStringList availableSymbols(AppData::TimeFrame timeFrame = AppData::Tick) const;
+
     // 检查数据是否存在
     bool hasHistoricalData(const QString &symbol, 
                          AppData::TimeFrame timeFrame = AppData::Tick) const;
 
+    // 将数据目录中的CSV文件导入到列式存储：不存在列式存储时导入全部文件，
+    // 否则只逐个合并修改时间晚于列式存储的文件（导入之后新放入的文件）
+    bool importCsvToColumnar(const QString &symbol,
+                            AppData::TimeFrame timeFrame = AppData::Tick);
+
+    // 以内存映射方式打开列式存储，打开前先合并新放入的CSV文件；不存在或打开失败时返回空指针
+    std::shared_ptr<MappedHistory> openMappedHistory(const QString &symbol,
+                                                     AppData::TimeFrame timeFrame = AppData::Tick);
+
+    // 源数据指纹：由周期目录下CSV文件的名称、大小和修改时间，以及列式存储文件头中的
+    // 行数、时间范围和数据校验值计算，其他文件不参与；没有源数据时返回空字符串
+    QString sourceFingerprint(const QString &symbol,
+                              AppData::TimeFrame sourceTimeFrame = AppData::Tick) const;
+
+    // 派生K线文件路径: [数据目录]/[规格名]/[品种]/derived/[指纹].kbar
+    // 规格名对时间K线即周期目录名，信息驱动K线如vol1000；
+    // 文件名由格式版本、tick文件指纹、K线规格和variant（如交易时段描述）共同决定，
+    // tick文件变化后旧文件自然失效；没有tick数据时返回空字符串
+    QString getDerivedFilePath(const QString &symbol,
+                               const BarSpec &spec,
+                               const QString &variant = QString()) const;
+
+    // 加载与当前tick文件对应的派生K线
+    bool loadDerivedBars(const QString &symbol,
+                         const BarSpec &spec,
+                         QVector<AppData::MarketData> &data,
+                         const QString &variant = QString());
+
+    // 保存派生K线，同时删除该规格下已失效的派生文件
+    bool saveDerivedBars(const QString &symbol,
+                         const BarSpec &spec,
+                         const QVector<AppData::MarketData> &data,
+                         const QString &variant = QString());
+
+    // 获取由tick数据合成的K线（时间K线或信息驱动K线）：先将新放入的CSV文件合并进tick列式存储，
+    // 再优先加载磁盘上的派生K线，不存在或已失效时用generator从tick列式存储合成并写回磁盘
+    bool loadOrDeriveBars(const QString &symbol,
+                          const BarSpec &spec,
+                          KlineGenerator &generator,
+                          QVector<AppData::MarketData> &data);
+
     // 从CSV文件加载数据
     static bool loadFromCsv(const QString &filePath, 
                            QVector<AppData::MarketData> &data);
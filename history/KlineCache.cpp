@@ -0,0 +1,283 @@
+﻿#include "KlineCache.h"
+#include <algorithm>
+
+KlineSlice::KlineSlice()
+    : m_offset(0)
+    , m_count(0)
+{
+}
+
+KlineSlice::KlineSlice(const QVector<AppData::MarketData> &bars, int offset, int count)
+    : m_bars(bars)
+    , m_offset(offset)
+    , m_count(count)
+{
+}
+
+QVector<AppData::MarketData> KlineSlice::toVector() const
+{
+    if (m_offset == 0 && m_count == m_bars.size()) {
+        return m_bars;
+    }
+    return m_bars.mid(m_offset, m_count);
+}
+
+qint64 KlineCache::Segment::bytes() const
+{
+    return static_cast<qint64>(bars.size()) * static_cast<qint64>(sizeof(AppData::MarketData) + sizeof(qint64));
+}
+
+KlineCache::KlineCache(qint64 maxBytes)
+    : m_maxBytes(maxBytes)
+    , m_totalBytes(0)
+    , m_clock(0)
+{
+}
+
+void KlineCache::setMaxBytes(qint64 maxBytes)
+{
+    m_maxBytes = qMax<qint64>(0, maxBytes);
+    evict();
+}
+
+qint64 KlineCache::maxBytes() const
+{
+    return m_maxBytes;
+}
+
+qint64 KlineCache::totalBytes() const
+{
+    return m_totalBytes;
+}
+
+int KlineCache::segmentAt(const QVector<Segment> &segments, qint64 ms)
+{
+    // 最后一个fromMs <= ms的时间段
+    auto it = std::upper_bound(segments.constBegin(), segments.constEnd(), ms,
+                               [](qint64 value, const Segment &segment) {
+                                   return value < segment.fromMs;
+                               });
+    if (it == segments.constBegin()) {
+        return -1;
+    }
+    --it;
+    return ms <= it->toMs ? static_cast<int>(it - segments.constBegin()) : -1;
+}
+
+void KlineCache::appendStarts(Segment &segment, const AppData::MarketData *begin, const AppData::MarketData *end)
+{
+    segment.barStarts.reserve(segment.barStarts.size() + static_cast<int>(end - begin));
+    for (const AppData::MarketData *it = begin; it != end; ++it) {
+        segment.barStarts.append(it->timestamp.toMSecsSinceEpoch());
+    }
+}
+
+void KlineCache::mergeBar(AppData::MarketData &into, const AppData::MarketData &next)
+{
+    // 与KlineGenerator的合成规则一致
+    into.high = qMax(into.high, next.high);
+    into.low = qMin(into.low, next.low);
+    into.close = next.close;
+    into.volume += next.volume;
+    into.amount += next.amount;
+    if (next.bidPrice > 0) {
+        into.bidPrice = next.bidPrice;
+        into.bidVolume += next.bidVolume;
+    }
+    if (next.askPrice > 0) {
+        into.askPrice = next.askPrice;
+        into.askVolume += next.askVolume;
+    }
+}
+
+bool KlineCache::find(const QString &symbol, AppData::TimeFrame timeFrame,
+                      qint64 fromMs, qint64 toMs,
+                      qint64 firstBarMs, qint64 lastBarMs,
+                      KlineSlice &slice)
+{
+    auto series = m_series.find(qMakePair(symbol, static_cast<int>(timeFrame)));
+    if (series == m_series.end()) {
+        return false;
+    }
+
+    QVector<Segment> &segments = series.value();
+    const int index = segmentAt(segments, fromMs);
+    if (index < 0 || toMs > segments[index].toMs) {
+        return false;
+    }
+
+    Segment &segment = segments[index];
+    segment.lastUsed = ++m_clock;
+
+    // 第一根为最后一个起始时间 <= firstBarMs的K线，最后一根为最后一个起始时间 <= lastBarMs的K线
+    const qint64 *starts = segment.barStarts.constData();
+    const qint64 *startsEnd = starts + segment.barStarts.size();
+    const qint64 *first = std::upper_bound(starts, startsEnd, firstBarMs);
+    if (first != starts) {
+        --first;
+    }
+    const qint64 *last = std::upper_bound(first, startsEnd, lastBarMs);
+
+    slice = KlineSlice(segment.bars, static_cast<int>(first - starts), static_cast<int>(last - first));
+    return true;
+}
+
+bool KlineCache::coveredUntil(const QString &symbol, AppData::TimeFrame timeFrame,
+                              qint64 fromMs, qint64 &coveredToMs) const
+{
+    auto series = m_series.constFind(qMakePair(symbol, static_cast<int>(timeFrame)));
+    if (series == m_series.constEnd()) {
+        return false;
+    }
+
+    const int index = segmentAt(series.value(), fromMs);
+    if (index < 0) {
+        return false;
+    }
+    coveredToMs = series.value()[index].toMs;
+    return true;
+}
+
+bool KlineCache::insert(const QString &symbol, AppData::TimeFrame timeFrame,
+                        qint64 fromMs, qint64 toMs, const QVector<AppData::MarketData> &bars)
+{
+    Segment segment;
+    segment.fromMs = fromMs;
+    segment.toMs = toMs;
+    segment.bars = bars;
+    segment.lastUsed = ++m_clock;
+    appendStarts(segment, bars.constData(), bars.constData() + bars.size());
+
+    const qint64 bytes = segment.bytes();
+    if (bytes > m_maxBytes) {
+        return false;
+    }
+
+    // 替换所有与新时间段重叠的旧时间段
+    QVector<Segment> &segments = m_series[qMakePair(symbol, static_cast<int>(timeFrame))];
+    auto overlapBegin = std::lower_bound(segments.begin(), segments.end(), fromMs,
+                                         [](const Segment &s, qint64 value) {
+                                             return s.toMs < value;
+                                         });
+    auto overlapEnd = overlapBegin;
+    while (overlapEnd != segments.end() && overlapEnd->fromMs <= toMs) {
+        m_totalBytes -= overlapEnd->bytes();
+        ++overlapEnd;
+    }
+    const int position = static_cast<int>(overlapBegin - segments.begin());
+    segments.erase(overlapBegin, overlapEnd);
+    segments.insert(position, segment);
+    m_totalBytes += bytes;
+
+    evict();
+    return true;
+}
+
+bool KlineCache::extend(const QString &symbol, AppData::TimeFrame timeFrame,
+                        qint64 coveredToMs, qint64 toMs, const QVector<AppData::MarketData> &bars)
+{
+    auto series = m_series.find(qMakePair(symbol, static_cast<int>(timeFrame)));
+    if (series == m_series.end() || toMs < coveredToMs) {
+        return false;
+    }
+
+    QVector<Segment> &segments = series.value();
+    const int index = segmentAt(segments, coveredToMs);
+    if (index < 0 || segments[index].toMs != coveredToMs) {
+        return false;
+    }
+
+    Segment &segment = segments[index];
+    m_totalBytes -= segment.bytes();
+
+    const AppData::MarketData *begin = bars.constData();
+    const AppData::MarketData *end = begin + bars.size();
+    if (begin != end && !segment.bars.isEmpty()
+        && begin->timestamp.toMSecsSinceEpoch() == segment.barStarts.last()) {
+        mergeBar(segment.bars.last(), *begin);
+        ++begin;
+    }
+    segment.bars.reserve(segment.bars.size() + static_cast<int>(end - begin));
+    for (const AppData::MarketData *it = begin; it != end; ++it) {
+        segment.bars.append(*it);
+    }
+    appendStarts(segment, begin, end);
+    segment.toMs = toMs;
+    segment.lastUsed = ++m_clock;
+    m_totalBytes += segment.bytes();
+
+    // 延长后覆盖到的后续时间段已过时
+    int next = index + 1;
+    while (next < segments.size() && segments[next].fromMs <= toMs) {
+        m_totalBytes -= segments[next].bytes();
+        segments.remove(next);
+    }
+
+    evict();
+    return true;
+}
+
+void KlineCache::clear(AppData::TimeFrame timeFrame)
+{
+    if (timeFrame == AppData::KUnknown) {
+        m_series.clear();
+        m_totalBytes = 0;
+        return;
+    }
+
+    for (auto it = m_series.begin(); it != m_series.end();) {
+        if (it.key().second == static_cast<int>(timeFrame)) {
+            for (const Segment &segment : it.value()) {
+                m_totalBytes -= segment.bytes();
+            }
+            it = m_series.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+KlineCache::Stats KlineCache::stats(AppData::TimeFrame timeFrame) const
+{
+    Stats result;
+    for (auto it = m_series.constBegin(); it != m_series.constEnd(); ++it) {
+        if (it.key().second != static_cast<int>(timeFrame)) {
+            continue;
+        }
+        for (const Segment &segment : it.value()) {
+            ++result.segments;
+            result.bars += segment.bars.size();
+            result.bytes += segment.bytes();
+        }
+    }
+    return result;
+}
+
+void KlineCache::evict()
+{
+    // 时间段数量不多，线性查找最久未使用的一段即可
+    while (m_totalBytes > m_maxBytes && !m_series.isEmpty()) {
+        auto oldestSeries = m_series.end();
+        int oldestIndex = -1;
+        quint64 oldestUsed = 0;
+        for (auto it = m_series.begin(); it != m_series.end(); ++it) {
+            const QVector<Segment> &segments = it.value();
+            for (int i = 0; i < segments.size(); ++i) {
+                if (oldestIndex < 0 || segments[i].lastUsed < oldestUsed) {
+                    oldestSeries = it;
+                    oldestIndex = i;
+                    oldestUsed = segments[i].lastUsed;
+                }
+            }
+        }
+        if (oldestIndex < 0) {
+            break;
+        }
+
+        m_totalBytes -= oldestSeries.value()[oldestIndex].bytes();
+        oldestSeries.value().remove(oldestIndex);
+        if (oldestSeries.value().isEmpty()) {
+            m_series.erase(oldestSeries);
+        }
+    }
+}
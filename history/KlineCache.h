@@ -0,0 +1,162 @@
+﻿#ifndef KLINECACHE_H
+#define KLINECACHE_H
+
+#include "../AppData.h"
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief 缓存K线的只读切片
+ *
+ * 与缓存共享同一份K线数据，构造和复制都不拷贝K线。缓存之后追加数据时
+ * 按写时复制分离，已取得的切片内容保持不变。
+ */
+class KlineSlice
+{
+public:
+    KlineSlice();
+    KlineSlice(const QVector<AppData::MarketData> &bars, int offset, int count);
+
+    int size() const { return m_count; }
+    bool isEmpty() const { return m_count == 0; }
+
+    const AppData::MarketData &at(int i) const { return m_bars.at(m_offset + i); }
+    const AppData::MarketData &operator[](int i) const { return at(i); }
+
+    const AppData::MarketData *begin() const { return m_bars.constData() + m_offset; }
+    const AppData::MarketData *end() const { return begin() + m_count; }
+
+    // 转换为QVector，切片为整段时共享数据，否则拷贝切片范围内的K线
+    QVector<AppData::MarketData> toVector() const;
+
+private:
+    QVector<AppData::MarketData> m_bars;
+    int m_offset;
+    int m_count;
+};
+
+/**
+ * @brief 按品种和周期缓存K线的连续时间段
+ *
+ * 每个品种、周期下保存若干互不重叠的时间段，每段记录合成它的源数据时间范围
+ * [fromMs, toMs]。请求的时间范围落在某一段内时直接返回切片；源数据在段末尾
+ * 之后追加时，只需合成新增部分并通过extend()接到段末尾。
+ * 内存按字节计算，超出上限时淘汰最久未使用的时间段。
+ *
+ * 本类不加锁，由调用方保证线程安全。
+ */
+class KlineCache
+{
+public:
+    // 默认内存上限：256MB
+    static const qint64 kDefaultMaxBytes = 256LL * 1024 * 1024;
+
+    explicit KlineCache(qint64 maxBytes = kDefaultMaxBytes);
+
+    // 内存上限(字节)，减小时立即淘汰
+    void setMaxBytes(qint64 maxBytes);
+    qint64 maxBytes() const;
+
+    // 当前占用的内存(字节)
+    qint64 totalBytes() const;
+
+    /**
+     * @brief 查找覆盖源数据范围[fromMs, toMs]的时间段，返回其中fromMs到toMs之间的K线
+     *
+     * 切片的第一根为包含fromMs的K线，边缘K线包含缓存中该周期的全部数据。
+     * 按交易时段对齐时，时段外的tick归属下一时段的K线，其起始时间晚于tick本身，
+     * 因此截取K线用的是fromMs、toMs所属K线的起始时间，而不是源数据时间
+     * @param symbol 交易品种代码
+     * @param timeFrame 时间周期
+     * @param fromMs 源数据开始时间(epoch毫秒，包含)
+     * @param toMs 源数据结束时间(epoch毫秒，包含)
+     * @param firstBarMs fromMs所属K线的起始时间
+     * @param lastBarMs toMs所属K线的起始时间
+     * @param slice 输出的切片
+     * @return 是否命中
+     */
+    bool find(const QString &symbol, AppData::TimeFrame timeFrame,
+              qint64 fromMs, qint64 toMs,
+              qint64 firstBarMs, qint64 lastBarMs,
+              KlineSlice &slice);
+
+    /**
+     * @brief 查找包含fromMs的时间段，返回该段源数据的结束时间
+     * @param symbol 交易品种代码
+     * @param timeFrame 时间周期
+     * @param fromMs 源数据开始时间(epoch毫秒)
+     * @param coveredToMs 输出的段结束时间
+     * @return 是否存在包含fromMs的时间段
+     */
+    bool coveredUntil(const QString &symbol, AppData::TimeFrame timeFrame,
+                      qint64 fromMs, qint64 &coveredToMs) const;
+
+    /**
+     * @brief 插入由源数据[fromMs, toMs]合成的K线，与之重叠的时间段被替换
+     * @return 是否已缓存（单段超过内存上限时不缓存）
+     */
+    bool insert(const QString &symbol, AppData::TimeFrame timeFrame,
+                qint64 fromMs, qint64 toMs, const QVector<AppData::MarketData> &bars);
+
+    /**
+     * @brief 把源数据(coveredToMs, toMs]合成的K线接到结束于coveredToMs的时间段末尾
+     *
+     * 第一根与段末尾K线的起始时间相同时合并为一根
+     * @param coveredToMs 调用coveredUntil()得到的段结束时间，段已被替换或淘汰时返回false
+     * @param toMs 新的段结束时间
+     * @param bars 新增的K线
+     * @return 是否成功
+     */
+    bool extend(const QString &symbol, AppData::TimeFrame timeFrame,
+                qint64 coveredToMs, qint64 toMs, const QVector<AppData::MarketData> &bars);
+
+    // 清除缓存，timeFrame为KUnknown时清除所有周期
+    void clear(AppData::TimeFrame timeFrame = AppData::KUnknown);
+
+    // 缓存统计
+    struct Stats {
+        int segments;
+        qint64 bars;
+        qint64 bytes;
+
+        Stats() : segments(0), bars(0), bytes(0) {}
+    };
+
+    // 指定周期的缓存统计
+    Stats stats(AppData::TimeFrame timeFrame) const;
+
+private:
+    // 一段连续时间的K线
+    struct Segment {
+        qint64 fromMs;                          // 源数据开始时间
+        qint64 toMs;                            // 源数据结束时间
+        QVector<AppData::MarketData> bars;
+        QVector<qint64> barStarts;              // K线起始时间，用于二分查找
+        quint64 lastUsed;                       // 最近使用的逻辑时钟
+
+        qint64 bytes() const;
+    };
+
+    typedef QPair<QString, int> SeriesKey;
+
+    // 包含ms的时间段的序号，不存在时返回-1
+    static int segmentAt(const QVector<Segment> &segments, qint64 ms);
+
+    // 把K线起始时间追加到barStarts
+    static void appendStarts(Segment &segment, const AppData::MarketData *begin, const AppData::MarketData *end);
+
+    // 把同一周期的后一根K线合并到前一根
+    static void mergeBar(AppData::MarketData &into, const AppData::MarketData &next);
+
+    // 淘汰最久未使用的时间段，直到不超过内存上限
+    void evict();
+
+    QHash<SeriesKey, QVector<Segment>> m_series;    // 每个序列的时间段按fromMs升序
+    qint64 m_maxBytes;
+    qint64 m_totalBytes;
+    quint64 m_clock;
+};
+
+#endif // KLINECACHE_H
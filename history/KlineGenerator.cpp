@@ -1,46 +1,67 @@
 ﻿#include "KlineGenerator.h"
+#include "BarSeries.h"
+#include "MappedHistory.h"
+#include "../global/SymbolTable.h"
 #include <QDebug>
-#include <QCryptographicHash>
 #include <QElapsedTimer>
 #include <algorithm>
+#include <limits>
 
-KlineGenerator::KlineGenerator(QObject *parent) : QObject(parent), m_cacheSize(100)
+namespace {
+
+// 预生成时每个并行任务的最少tick数，避免任务过小
+const int kMinPreGenerateChunkTicks = 65536;
+
+// 时间戳(毫秒)所属周期的序号，按epoch对齐，负时间戳向下取整
+inline qint64 bucketIndex(qint64 msecs, qint64 intervalMsecs)
+{
+    qint64 bucket = msecs / intervalMsecs;
+    if (msecs < 0 && msecs % intervalMsecs != 0) {
+        --bucket;
+    }
+    return bucket;
+}
+
+// 按百分比节流的进度通知，整个范围内最多通知101次
+class ProgressThrottle
+{
+public:
+    ProgressThrottle(qint64 firstMsecs, qint64 lastMsecs)
+        : m_first(firstMsecs)
+        , m_span(qMax<qint64>(1, lastMsecs - firstMsecs))
+        , m_lastPercent(-1)
+    {
+    }
+
+    // 返回需要通知的百分比，与上次相同时返回-1
+    int update(qint64 msecs)
+    {
+        const int percent = static_cast<int>(qBound<qint64>(0, (msecs - m_first) * 100 / m_span, 100));
+        if (percent <= m_lastPercent) {
+            return -1;
+        }
+        m_lastPercent = percent;
+        return percent;
+    }
+
+private:
+    qint64 m_first;
+    qint64 m_span;
+    int m_lastPercent;
+};
+
+} // namespace
+
+KlineGenerator::KlineGenerator(QObject *parent) : QObject(parent), m_cumulativeVolume(false)
 {
     // 设置线程池最大线程数
     m_threadPool.setMaxThreadCount(QThread::idealThreadCount());
-    
-    // 初始化各个周期的缓存
-    m_klineCache[AppData::M1] = new QCache<QString, QVector<AppData::MarketData>>();
-    m_klineCache[AppData::M5] = new QCache<QString, QVector<AppData::MarketData>>();
-    m_klineCache[AppData::M15] = new QCache<QString, QVector<AppData::MarketData>>();
-    m_klineCache[AppData::M30] = new QCache<QString, QVector<AppData::MarketData>>();
-    m_klineCache[AppData::H1] = new QCache<QString, QVector<AppData::MarketData>>();
-    m_klineCache[AppData::H4] = new QCache<QString, QVector<AppData::MarketData>>();
-    m_klineCache[AppData::D1] = new QCache<QString, QVector<AppData::MarketData>>();
-    m_klineCache[AppData::W1] = new QCache<QString, QVector<AppData::MarketData>>();
-    
-    // 设置各个缓存的最大容量
-    m_klineCache[AppData::M1]->setMaxCost(m_cacheSize);
-    m_klineCache[AppData::M5]->setMaxCost(m_cacheSize);
-    m_klineCache[AppData::M15]->setMaxCost(m_cacheSize);
-    m_klineCache[AppData::M30]->setMaxCost(m_cacheSize);
-    m_klineCache[AppData::H1]->setMaxCost(m_cacheSize);
-    m_klineCache[AppData::H4]->setMaxCost(m_cacheSize);
-    m_klineCache[AppData::D1]->setMaxCost(m_cacheSize);
-    m_klineCache[AppData::W1]->setMaxCost(m_cacheSize);
 }
 
 KlineGenerator::~KlineGenerator()
 {
     // 等待所有线程完成
     m_threadPool.waitForDone();
-    
-    // 清除所有缓存并释放内存
-    clearCache();
-    
-    // 删除所有QCache对象
-    qDeleteAll(m_klineCache);
-    m_klineCache.clear();
 }
 
 QVector<AppData::MarketData> KlineGenerator::generateKlineFromTicks(
@@ -59,45 +80,56 @@ QVector<AppData::MarketData> KlineGenerator::generateKlineFromTicks(
         return QVector<AppData::MarketData>();
     }
     
-    // 获取数据的时间范围和交易对
-    QDateTime startTime = tickData.first().timestamp;
-    QDateTime endTime = tickData.last().timestamp;
-    QString symbol = tickData.first().symbol;
-    
-    // 生成缓存键
-    QString cacheKey = generateCacheKey(symbol, startTime, endTime, timeFrame);
+    const int intervalSeconds = getTimeFrameSeconds(timeFrame);
+    const AppData::MarketData *begin = tickData.constData();
+    const AppData::MarketData *end = begin + tickData.size();
     
-    // 如果不强制重新生成，尝试从缓存获取
-    if (!forceRegenerate) {
-        QMutexLocker locker(&m_cacheMutex);
-        if (m_klineCache.contains(timeFrame) && m_klineCache[timeFrame] && m_klineCache[timeFrame]->contains(cacheKey)) {
-            emit logMessage(tr(u8"从缓存获取%1周期K线数据").arg(timeFrame), 0);
-            return *m_klineCache[timeFrame]->object(cacheKey);
-        }
+    return generateWithCache(tickData.first().symbol, timeFrame,
+                             begin->timestamp.toMSecsSinceEpoch(),
+                             (end - 1)->timestamp.toMSecsSinceEpoch(),
+                             forceRegenerate,
+                             tr("开始从tick数据生成%1周期K线").arg(timeFrame),
+                             [this, begin, end, intervalSeconds](qint64 afterMs) {
+        // 只合成时间晚于afterMs的tick
+        const AppData::MarketData *from = std::upper_bound(begin, end, afterMs,
+                                                           [](qint64 value, const AppData::MarketData &tick) {
+                                                               return value < tick.timestamp.toMSecsSinceEpoch();
+                                                           });
+        return aggregateTicksToKline(from, end, intervalSeconds);
+    });
+}
+
+QVector<AppData::MarketData> KlineGenerator::generateKlineFromView(
+    const BarView &view,
+    AppData::TimeFrame timeFrame,
+    bool forceRegenerate)
+{
+    // 检查数据是否为空
+    if (view.isEmpty()) {
+        emit logMessage(tr("无法生成K线：视图数据为空"), 1);
+        return QVector<AppData::MarketData>();
     }
     
-    // 计算时间间隔（秒）
-    int intervalSeconds = getTimeFrameSeconds(timeFrame);
-    
-    // 聚合tick数据生成K线
-    QElapsedTimer timer;
-    timer.start();
-    
-    emit logMessage(tr("开始从tick数据生成%1周期K线").arg(timeFrame), 0);
-    QVector<AppData::MarketData> klineData = aggregateTicksToKline(tickData, intervalSeconds);
-    
-    emit logMessage(tr("生成%1周期K线完成，耗时%2毫秒，共%3条K线")
-                   .arg(timeFrame)
-                   .arg(timer.elapsed())
-                   .arg(klineData.size()), 0);
-    
-    // 缓存结果
-    QMutexLocker locker(&m_cacheMutex);
-    if (m_klineCache.contains(timeFrame) && m_klineCache[timeFrame]) {
-        m_klineCache[timeFrame]->insert(cacheKey, new QVector<AppData::MarketData>(klineData), 1);
+    // 如果是tick级别数据，直接展开视图
+    if (timeFrame == AppData::Tick) {
+        QVector<AppData::MarketData> result(static_cast<int>(view.size()));
+        for (int i = 0; i < result.size(); ++i) {
+            view.fillMarketData(i, result[i]);
+        }
+        return result;
     }
     
-    return klineData;
+    const int intervalSeconds = getTimeFrameSeconds(timeFrame);
+    return generateWithCache(view.symbol(), timeFrame,
+                             view.firstTimestamp(), view.lastTimestamp(),
+                             forceRegenerate,
+                             tr("开始从视图数据生成%1周期K线").arg(timeFrame),
+                             [this, &view, intervalSeconds](qint64 afterMs) {
+        if (afterMs == std::numeric_limits<qint64>::min()) {
+            return aggregateViewToKline(view, intervalSeconds);
+        }
+        return aggregateViewToKline(view.slice(afterMs + 1, view.lastTimestamp()), intervalSeconds);
+    });
 }
 
 QVector<AppData::MarketData> KlineGenerator::generateKlineFromKline(
@@ -123,45 +155,176 @@ QVector<AppData::MarketData> KlineGenerator::generateKlineFromKline(
         emit logMessage(tr("目标周期不是源周期的整数倍，可能导致不准确的结果"), 1);
     }
     
-    // 获取数据的时间范围和交易对
-    QDateTime startTime = sourceData.first().timestamp;
-    QDateTime endTime = sourceData.last().timestamp;
-    QString symbol = sourceData.first().symbol;
+    // 计算源和目标时间间隔（秒）
+    const int sourceInterval = getTimeFrameSeconds(sourceTimeFrame);
+    const int targetInterval = getTimeFrameSeconds(targetTimeFrame);
+    
+    return generateWithCache(sourceData.first().symbol, targetTimeFrame,
+                             sourceData.first().timestamp.toMSecsSinceEpoch(),
+                             sourceData.last().timestamp.toMSecsSinceEpoch(),
+                             forceRegenerate,
+                             tr("开始从%1周期生成%2周期K线").arg(sourceTimeFrame).arg(targetTimeFrame),
+                             [this, &sourceData, sourceInterval, targetInterval](qint64 afterMs) {
+        if (afterMs == std::numeric_limits<qint64>::min()) {
+            return aggregateKlineToHigherTimeframe(sourceData, sourceInterval, targetInterval);
+        }
+        // 只合成起始时间晚于afterMs的源K线
+        auto from = std::upper_bound(sourceData.constBegin(), sourceData.constEnd(), afterMs,
+                                     [](qint64 value, const AppData::MarketData &kline) {
+                                         return value < kline.timestamp.toMSecsSinceEpoch();
+                                     });
+        return aggregateKlineToHigherTimeframe(sourceData.mid(static_cast<int>(from - sourceData.constBegin())),
+                                               sourceInterval, targetInterval);
+    });
+}
+
+QVector<AppData::MarketData> KlineGenerator::generateBarsFromTicks(
+    const QVector<AppData::MarketData> &tickData,
+    const BarSpec &spec,
+    bool forceRegenerate)
+{
+    if (spec.isTimeBar()) {
+        return generateKlineFromTicks(tickData, spec.timeFrame(), forceRegenerate);
+    }
+    
+    if (!spec.isValid()) {
+        emit logMessage(tr("无法生成K线：无效的K线规格"), 1);
+        return QVector<AppData::MarketData>();
+    }
+    
+    if (tickData.isEmpty()) {
+        emit logMessage(tr("无法生成K线：tick数据为空"), 1);
+        return QVector<AppData::MarketData>();
+    }
+    
+    const AppData::MarketData *begin = tickData.constData();
+    const AppData::MarketData *end = begin + tickData.size();
+    
+    return generateWithCache(tickData.first().symbol, spec,
+                             begin->timestamp.toMSecsSinceEpoch(),
+                             (end - 1)->timestamp.toMSecsSinceEpoch(),
+                             forceRegenerate,
+                             tr("开始从tick数据生成%1K线").arg(spec.name()),
+                             [this, begin, end, spec](qint64) {
+        return aggregateTicksToBars(begin, end, spec);
+    });
+}
+
+QVector<AppData::MarketData> KlineGenerator::generateBarsFromView(
+    const BarView &view,
+    const BarSpec &spec,
+    bool forceRegenerate)
+{
+    if (spec.isTimeBar()) {
+        return generateKlineFromView(view, spec.timeFrame(), forceRegenerate);
+    }
+    
+    if (!spec.isValid()) {
+        emit logMessage(tr("无法生成K线：无效的K线规格"), 1);
+        return QVector<AppData::MarketData>();
+    }
+    
+    if (view.isEmpty()) {
+        emit logMessage(tr("无法生成K线：视图数据为空"), 1);
+        return QVector<AppData::MarketData>();
+    }
+    
+    return generateWithCache(view.symbol(), spec,
+                             view.firstTimestamp(), view.lastTimestamp(),
+                             forceRegenerate,
+                             tr("开始从视图数据生成%1K线").arg(spec.name()),
+                             [this, &view, spec](qint64) {
+        return aggregateViewToBars(view, spec);
+    });
+}
+
+KlineSlice KlineGenerator::cachedKlines(
+    const QString &symbol,
+    AppData::TimeFrame timeFrame,
+    qint64 startMs,
+    qint64 endMs)
+{
+    KlineSlice slice;
+    QMutexLocker locker(&m_cacheMutex);
+    m_klineCache.find(symbol, timeFrame, startMs, endMs,
+                      barStartMs(startMs, timeFrame), barStartMs(endMs, timeFrame), slice);
+    return slice;
+}
+
+QVector<AppData::MarketData> KlineGenerator::generateWithCache(
+    const QString &symbol,
+    const BarSpec &spec,
+    qint64 firstMs,
+    qint64 lastMs,
+    bool forceRegenerate,
+    const QString &startMessage,
+    const std::function<QVector<AppData::MarketData>(qint64)> &aggregate)
+{
+    // 信息驱动K线记在KUnknown下，键中带上规格和源数据起始时间
+    const AppData::TimeFrame timeFrame = spec.timeFrame();
+    const QString key = spec.isTimeBar()
+        ? symbol
+        : QString("%1@%2@%3").arg(symbol, spec.name()).arg(firstMs);
+    const QString label = spec.isTimeBar() ? QString::number(timeFrame) : spec.name();
+    
+    // 截取缓存用所属K线的起始时间；覆盖范围和增量合成仍按源数据时间判断
+    const qint64 firstBarMs = barStartMs(firstMs, spec);
+    const qint64 lastBarMs = barStartMs(lastMs, spec);
     
-    // 生成缓存键
-    QString cacheKey = generateCacheKey(symbol, startTime, endTime, targetTimeFrame);
+    qint64 coveredToMs = 0;
+    bool extendable = false;
     
-    // 如果不强制重新生成，尝试从缓存获取
+    // 如果不强制重新生成，尝试从缓存获取。日志在释放缓存锁之后发出，
+    // 直连的槽函数可能再次调用本对象的缓存接口
     if (!forceRegenerate) {
-        QMutexLocker locker(&m_cacheMutex);
-        if (m_klineCache.contains(targetTimeFrame) && m_klineCache[targetTimeFrame] && m_klineCache[targetTimeFrame]->contains(cacheKey)) {
-            emit logMessage(tr("从缓存获取%1周期K线数据").arg(targetTimeFrame), 0);
-            return *m_klineCache[targetTimeFrame]->object(cacheKey);
+        KlineSlice slice;
+        bool hit = false;
+        {
+            QMutexLocker locker(&m_cacheMutex);
+            hit = m_klineCache.find(key, timeFrame, firstMs, lastMs, firstBarMs, lastBarMs, slice);
+            extendable = !hit && spec.isTimeBar()
+                         && m_klineCache.coveredUntil(key, timeFrame, firstMs, coveredToMs);
+        }
+        if (hit) {
+            emit logMessage(tr("从缓存获取%1周期K线数据").arg(label), 0);
+            return slice.toVector();
         }
     }
     
-    // 计算源和目标时间间隔（秒）
-    int sourceInterval = getTimeFrameSeconds(sourceTimeFrame);
-    int targetInterval = getTimeFrameSeconds(targetTimeFrame);
-    
-    // 聚合低周期K线生成高周期K线
     QElapsedTimer timer;
     timer.start();
     
-    emit logMessage(tr("开始从%1周期生成%2周期K线").arg(sourceTimeFrame).arg(targetTimeFrame), 0);
-    QVector<AppData::MarketData> klineData = aggregateKlineToHigherTimeframe(
-        sourceData, sourceInterval, targetInterval);
+    // 缓存已覆盖开头部分时，只合成之后追加的数据并接到缓存末尾
+    if (extendable) {
+        const QVector<AppData::MarketData> tail = aggregate(coveredToMs);
+        
+        KlineSlice slice;
+        bool extended = false;
+        {
+            QMutexLocker locker(&m_cacheMutex);
+            extended = m_klineCache.extend(key, timeFrame, coveredToMs, lastMs, tail)
+                       && m_klineCache.find(key, timeFrame, firstMs, lastMs, firstBarMs, lastBarMs, slice);
+        }
+        if (extended) {
+            emit logMessage(tr("增量生成%1周期K线完成，耗时%2毫秒，新增%3条K线")
+                           .arg(label)
+                           .arg(timer.elapsed())
+                           .arg(tail.size()), 0);
+            return slice.toVector();
+        }
+    }
+    
+    emit logMessage(startMessage, 0);
+    QVector<AppData::MarketData> klineData = aggregate(std::numeric_limits<qint64>::min());
     
     emit logMessage(tr("生成%1周期K线完成，耗时%2毫秒，共%3条K线")
-                   .arg(targetTimeFrame)
+                   .arg(label)
                    .arg(timer.elapsed())
                    .arg(klineData.size()), 0);
     
     // 缓存结果
     QMutexLocker locker(&m_cacheMutex);
-    if (m_klineCache.contains(targetTimeFrame) && m_klineCache[targetTimeFrame]) {
-        m_klineCache[targetTimeFrame]->insert(cacheKey, new QVector<AppData::MarketData>(klineData), 1);
-    }
+    m_klineCache.insert(key, timeFrame, firstMs, lastMs, klineData);
     
     return klineData;
 }
@@ -174,190 +337,535 @@ void KlineGenerator::preGenerateKlines(
         return;
     }
     
-    emit logMessage(tr("开始预生成多个周期的K线数据"), 0);
+    // 需要生成的周期，去重后按周期长度从小到大排列，低周期作为高周期的数据源
+    QVector<AppData::TimeFrame> levels;
+    for (const auto &timeFrame : timeFrames) {
+        if (timeFrame != AppData::Tick && timeFrame != AppData::KUnknown && !levels.contains(timeFrame)) {
+            levels.append(timeFrame);
+        }
+    }
+    if (levels.isEmpty()) {
+        return;
+    }
+    std::sort(levels.begin(), levels.end(), [this](AppData::TimeFrame a, AppData::TimeFrame b) {
+        return getTimeFrameSeconds(a) < getTimeFrameSeconds(b);
+    });
     
-    // 创建任务列表
-    QList<QFuture<void>> tasks;
+    emit logMessage(tr("开始预生成多个周期的K线数据"), 0);
+    QElapsedTimer timer;
+    timer.start();
     
-    // 为每个周期创建一个任务
-    for (const auto &timeFrame : timeFrames) {
-        if (timeFrame == AppData::Tick) {
-            continue; // 跳过tick级别
+    // 按品种划分：同一品种的tick通常是连续的，直接引用原数组；
+    // 多个品种按时间交错时，每个品种只复制一次
+    QVector<QPair<const AppData::MarketData *, const AppData::MarketData *>> symbolRanges;
+    QVector<QVector<AppData::MarketData>> gathered;
+    {
+        QHash<QString, int> seen;
+        bool interleaved = false;
+        const AppData::MarketData *runBegin = tickData.constData();
+        const AppData::MarketData *dataEnd = tickData.constData() + tickData.size();
+        for (const AppData::MarketData *it = runBegin + 1; it <= dataEnd; ++it) {
+            if (it != dataEnd && it->symbolId == runBegin->symbolId && it->symbol == runBegin->symbol) {
+                continue;
+            }
+            if (seen.contains(runBegin->symbol)) {
+                interleaved = true;
+                break;
+            }
+            seen.insert(runBegin->symbol, symbolRanges.size());
+            symbolRanges.append(qMakePair(runBegin, it));
+            runBegin = it;
         }
         
-        // 使用QtConcurrent并行处理
-        QFuture<void> future = QtConcurrent::run(&m_threadPool, [this, tickData, timeFrame]() {
-            generateKlineFromTicks(tickData, timeFrame, true);
-            emit generationProgress(100, timeFrame);
-        });
+        if (interleaved) {
+            seen.clear();
+            symbolRanges.clear();
+            for (const auto &tick : tickData) {
+                auto found = seen.constFind(tick.symbol);
+                int index = found != seen.constEnd() ? found.value() : -1;
+                if (index < 0) {
+                    index = gathered.size();
+                    seen.insert(tick.symbol, index);
+                    gathered.append(QVector<AppData::MarketData>());
+                }
+                gathered[index].append(tick);
+            }
+            for (const auto &ticks : gathered) {
+                symbolRanges.append(qMakePair(ticks.constData(), ticks.constData() + ticks.size()));
+            }
+        }
+    }
+    
+    // 每个品种再按最高周期的边界切分时间段。各周期（无论按epoch还是按交易时段对齐）逐级整除，
+    // 最高周期的边界也是所有低周期的边界，因此各时间段可以独立合成后直接拼接
+    const int coarsestSeconds = getTimeFrameSeconds(levels.last());
+    const int chunkTicks = qMax(kMinPreGenerateChunkTicks,
+                                tickData.size() / qMax(1, m_threadPool.maxThreadCount() * 4));
+    
+    QVector<int> chunkCounts;
+    QList<QFuture<QVector<QVector<AppData::MarketData>>>> tasks;
+    for (const auto &range : symbolRanges) {
+        int chunks = 0;
+        const AppData::MarketData *chunkBegin = range.first;
+        while (chunkBegin != range.second) {
+            const AppData::MarketData *chunkEnd = range.second;
+            if (range.second - chunkBegin > chunkTicks) {
+                // 从目标位置向后移动到下一个最高周期边界（K线序号随时间单调不减）
+                const qint64 cutKey = bucketKey((chunkBegin + chunkTicks)->timestamp.toMSecsSinceEpoch(), coarsestSeconds);
+                chunkEnd = std::partition_point(chunkBegin + chunkTicks, range.second,
+                                                [this, cutKey, coarsestSeconds](const AppData::MarketData &tick) {
+                                                    return bucketKey(tick.timestamp.toMSecsSinceEpoch(), coarsestSeconds) <= cutKey;
+                                                });
+            }
+            
+            tasks.append(QtConcurrent::run(&m_threadPool, [this, chunkBegin, chunkEnd, levels]() {
+                return cascadeTicksToKlines(chunkBegin, chunkEnd, levels);
+            }));
+            ++chunks;
+            chunkBegin = chunkEnd;
+        }
+        chunkCounts.append(chunks);
+    }
+    
+    // 按品种拼接各时间段的结果并写入缓存，缓存范围与generateKlineFromTicks一致
+    int taskIndex = 0;
+    for (int s = 0; s < symbolRanges.size(); ++s) {
+        QVector<QVector<AppData::MarketData>> klines(levels.size());
+        for (int c = 0; c < chunkCounts[s]; ++c) {
+            const QVector<QVector<AppData::MarketData>> part = tasks[taskIndex++].result();
+            for (int i = 0; i < levels.size(); ++i) {
+                klines[i] += part[i];
+            }
+        }
         
-        tasks.append(future);
+        const AppData::MarketData &first = *symbolRanges[s].first;
+        const AppData::MarketData &last = *(symbolRanges[s].second - 1);
+        QMutexLocker locker(&m_cacheMutex);
+        for (int i = 0; i < levels.size(); ++i) {
+            m_klineCache.insert(first.symbol, levels[i],
+                                first.timestamp.toMSecsSinceEpoch(),
+                                last.timestamp.toMSecsSinceEpoch(),
+                                klines[i]);
+        }
     }
     
-    // 等待所有任务完成（非阻塞，可以在UI线程中调用）
-    for (int i = 0; i < tasks.size(); ++i) {
-        tasks[i].waitForFinished();
+    for (const auto &timeFrame : levels) {
+        emit generationProgress(100, timeFrame);
     }
     
-    emit logMessage(tr("所有周期K线数据预生成完成"), 0);
+    emit logMessage(tr("所有周期K线数据预生成完成，耗时%1毫秒，共%2个品种、%3个任务")
+                   .arg(timer.elapsed())
+                   .arg(symbolRanges.size())
+                   .arg(tasks.size()), 0);
+}
+
+QVector<QVector<AppData::MarketData>> KlineGenerator::cascadeTicksToKlines(
+    const AppData::MarketData *begin,
+    const AppData::MarketData *end,
+    const QVector<AppData::TimeFrame> &levels)
+{
+    QVector<QVector<AppData::MarketData>> result(levels.size());
+    for (int i = 0; i < levels.size(); ++i) {
+        const int interval = getTimeFrameSeconds(levels[i]);
+        
+        // 从能整除的最高一级已生成周期合成，只有最低一级需要遍历tick
+        int source = i - 1;
+        while (source >= 0 && !isMultipleTimeframe(levels[source], levels[i])) {
+            --source;
+        }
+        
+        if (source >= 0) {
+            result[i] = aggregateKlineToHigherTimeframe(result[source],
+                                                        getTimeFrameSeconds(levels[source]),
+                                                        interval);
+        } else {
+            result[i] = aggregateTicksToKline(begin, end, interval);
+        }
+    }
+    return result;
 }
 
 void KlineGenerator::clearCache(AppData::TimeFrame timeFrame)
 {
-    QMutexLocker locker(&m_cacheMutex);
+    {
+        QMutexLocker locker(&m_cacheMutex);
+        m_klineCache.clear(timeFrame);
+    }
     
     if (timeFrame == AppData::KUnknown) {
-        // 清除所有缓存
-        for (auto it = m_klineCache.begin(); it != m_klineCache.end(); ++it) {
-            if (it.value()) {
-                it.value()->clear();
-            }
-        }
         emit logMessage(tr("已清除所有K线缓存"), 0);
     } else {
-        // 清除指定周期的缓存
-        if (m_klineCache.contains(timeFrame) && m_klineCache[timeFrame]) {
-            m_klineCache[timeFrame]->clear();
-            emit logMessage(tr("已清除%1周期K线缓存").arg(timeFrame), 0);
-        }
+        emit logMessage(tr("已清除%1周期K线缓存").arg(timeFrame), 0);
     }
 }
 
 QString KlineGenerator::getCacheStatus() const
 {
+    static const AppData::TimeFrame timeFrames[] = {
+        AppData::M1, AppData::M5, AppData::M15, AppData::M30,
+        AppData::H1, AppData::H4, AppData::D1, AppData::W1
+    };
+    
     QMutexLocker locker(&m_cacheMutex);
     
-    QString status = tr("K线缓存状态:\n");
+    QString status = tr("K线缓存状态: %1/%2 KB\n")
+                     .arg(m_klineCache.totalBytes() / 1024)
+                     .arg(m_klineCache.maxBytes() / 1024);
     
-    for (auto it = m_klineCache.begin(); it != m_klineCache.end(); ++it) {
-        AppData::TimeFrame tf = it.key();
-        if (it.value()) {
-            int count = it.value()->count();
-            int maxCount = it.value()->maxCost();
-            status += tr("  %1周期: %2/%3\n").arg(tf).arg(count).arg(maxCount);
-        } else {
-            status += tr("  %1周期: 未初始化\n").arg(tf);
-        }
+    for (AppData::TimeFrame tf : timeFrames) {
+        const KlineCache::Stats stats = m_klineCache.stats(tf);
+        status += tr("  %1周期: %2段，%3条K线，%4 KB\n")
+                  .arg(tf)
+                  .arg(stats.segments)
+                  .arg(stats.bars)
+                  .arg(stats.bytes / 1024);
     }
     
+    // 信息驱动K线记在KUnknown下
+    const KlineCache::Stats infoStats = m_klineCache.stats(AppData::KUnknown);
+    status += tr("  信息驱动K线: %1段，%2条K线，%3 KB\n")
+              .arg(infoStats.segments)
+              .arg(infoStats.bars)
+              .arg(infoStats.bytes / 1024);
+    
     return status;
 }
 
-void KlineGenerator::setCacheSize(int size)
+void KlineGenerator::setCacheMemoryLimit(qint64 bytes)
 {
-    if (size <= 0) {
+    if (bytes <= 0) {
         return;
     }
     
-    QMutexLocker locker(&m_cacheMutex);
-    m_cacheSize = size;
-    
-    // 更新所有缓存的大小
-    for (auto it = m_klineCache.begin(); it != m_klineCache.end(); ++it) {
-        it.value()->setMaxCost(size);
+    {
+        QMutexLocker locker(&m_cacheMutex);
+        m_klineCache.setMaxBytes(bytes);
     }
     
-    emit logMessage(tr("K线缓存大小已设置为%1").arg(size), 0);
+    emit logMessage(tr("K线缓存内存上限已设置为%1 KB").arg(bytes / 1024), 0);
 }
 
-QString KlineGenerator::generateCacheKey(
-    const QString &symbol,
-    const QDateTime &startTime,
-    const QDateTime &endTime,
-    AppData::TimeFrame timeFrame) const
+qint64 KlineGenerator::cacheMemoryLimit() const
 {
-    // 生成唯一的缓存键
-    QString keyStr = QString("%1_%2_%3_%4")
-                    .arg(symbol)
-                    .arg(startTime.toString(Qt::ISODate))
-                    .arg(endTime.toString(Qt::ISODate))
-                    .arg(timeFrame);
+    QMutexLocker locker(&m_cacheMutex);
+    return m_klineCache.maxBytes();
+}
+
+void KlineGenerator::setTradingSession(const TradingSession &session)
+{
+    m_tradingSession = session;
     
-    // 使用MD5哈希生成固定长度的键
-    QByteArray hash = QCryptographicHash::hash(keyStr.toUtf8(), QCryptographicHash::Md5);
-    return hash.toHex();
+    // 对齐方式改变后，已缓存的K线和未完成的K线都不再有效
+    clearCache();
+    m_openBars.clear();
+}
+
+const TradingSession &KlineGenerator::tradingSession() const
+{
+    return m_tradingSession;
+}
+
+void KlineGenerator::setStreamingTimeFrames(const QVector<AppData::TimeFrame> &timeFrames)
+{
+    m_streamingFrames.clear();
+    for (AppData::TimeFrame timeFrame : timeFrames) {
+        StreamingFrame frame;
+        frame.timeFrame = timeFrame;
+        frame.intervalSeconds = getTimeFrameSeconds(timeFrame);
+        m_streamingFrames.append(frame);
+    }
+    m_openBars.clear();
+    m_streamingVolumes.clear();
+}
+
+QVector<AppData::TimeFrame> KlineGenerator::streamingTimeFrames() const
+{
+    QVector<AppData::TimeFrame> timeFrames;
+    for (const StreamingFrame &frame : m_streamingFrames) {
+        timeFrames.append(frame.timeFrame);
+    }
+    return timeFrames;
+}
+
+void KlineGenerator::setStreamingInfoBars(const QVector<BarSpec> &specs)
+{
+    m_streamingInfoBars.clear();
+    for (const BarSpec &spec : specs) {
+        if (!spec.isTimeBar() && spec.isValid()) {
+            m_streamingInfoBars.append(spec);
+        }
+    }
+    m_barBuilders.clear();
+}
+
+QVector<BarSpec> KlineGenerator::streamingInfoBars() const
+{
+    return m_streamingInfoBars;
+}
+
+void KlineGenerator::setStreamingCumulativeVolume(bool cumulative)
+{
+    m_cumulativeVolume = cumulative;
+    m_streamingVolumes.clear();
+}
+
+bool KlineGenerator::currentBar(quint32 symbolId, AppData::TimeFrame timeFrame, AppData::Bar &bar) const
+{
+    const int frameCount = m_streamingFrames.size();
+    for (int i = 0; i < frameCount; ++i) {
+        if (m_streamingFrames[i].timeFrame != timeFrame) {
+            continue;
+        }
+        const qint64 index = static_cast<qint64>(symbolId) * frameCount + i;
+        if (index >= m_openBars.size() || m_openBars[static_cast<int>(index)].tickCount == 0) {
+            return false;
+        }
+        bar = m_openBars[static_cast<int>(index)];
+        return true;
+    }
+    return false;
+}
+
+bool KlineGenerator::currentInfoBar(quint32 symbolId, const BarSpec &spec, AppData::Bar &bar) const
+{
+    const int specCount = m_streamingInfoBars.size();
+    const int i = m_streamingInfoBars.indexOf(spec);
+    if (i < 0) {
+        return false;
+    }
+    const qint64 index = static_cast<qint64>(symbolId) * specCount + i;
+    if (index >= m_barBuilders.size() || !m_barBuilders[static_cast<int>(index)].hasOpenBar()) {
+        return false;
+    }
+    bar = m_barBuilders[static_cast<int>(index)].openBar();
+    return true;
+}
+
+void KlineGenerator::flushStreamingBars()
+{
+    const int frameCount = m_streamingFrames.size();
+    for (int index = 0; index < m_openBars.size(); ++index) {
+        if (m_openBars[index].tickCount == 0) {
+            continue;
+        }
+        // 先复制再重置，槽函数中可以安全地继续调用processTick
+        const AppData::Bar closed = m_openBars[index];
+        m_openBars[index].tickCount = 0;
+        emit barClosed(closed, m_streamingFrames[index % frameCount].timeFrame);
+    }
+
+    // 砖形图未走完一个砖高时不输出，继续累计
+    const int specCount = m_streamingInfoBars.size();
+    for (int index = 0; index < m_barBuilders.size(); ++index) {
+        AppData::Bar closed;
+        if (m_barBuilders[index].flush(closed)) {
+            emit infoBarClosed(closed, m_streamingInfoBars[index % specCount]);
+        }
+    }
+}
+
+void KlineGenerator::processTick(const AppData::MarketData &tick)
+{
+    const int frameCount = m_streamingFrames.size();
+    const int specCount = m_streamingInfoBars.size();
+    if (frameCount == 0 && specCount == 0) {
+        return;
+    }
+
+    quint32 symbolId = tick.symbolId;
+    if (symbolId == SymbolTable::kInvalidId) {
+        symbolId = SymbolTable::instance()->intern(tick.symbol);
+    }
+
+    // 实时行情的close可能是昨收价，优先使用最新价，与历史tick（price等于close）一致
+    const double price = tick.price > 0 ? tick.price : tick.close;
+    if (price <= 0) {
+        return;
+    }
+
+    double volume = tick.volume;
+    double amount = tick.amount;
+    if (m_cumulativeVolume) {
+        if (static_cast<int>(symbolId) >= m_streamingVolumes.size()) {
+            m_streamingVolumes.resize(static_cast<int>(symbolId) + 1);
+        }
+        StreamingVolume &last = m_streamingVolumes[static_cast<int>(symbolId)];
+        // 第一个tick没有基准，不计入成交量；累计值变小说明交易日切换，从零重新累计
+        volume = !last.valid ? 0.0 : (tick.volume >= last.volume ? tick.volume - last.volume : tick.volume);
+        amount = !last.valid ? 0.0 : (tick.amount >= last.amount ? tick.amount - last.amount : tick.amount);
+        last.volume = tick.volume;
+        last.amount = tick.amount;
+        last.valid = true;
+    }
+
+    const int base = static_cast<int>(symbolId) * frameCount;
+    if (base + frameCount > m_openBars.size()) {
+        m_openBars.resize(base + frameCount);
+    }
+
+    const qint64 msecs = tick.timestamp.toMSecsSinceEpoch();
+    for (int i = 0; i < frameCount; ++i) {
+        const StreamingFrame frame = m_streamingFrames[i];
+        // 与批量合成相同的对齐方式，保证结果一致
+        const qint64 barStart = bucketStartMs(bucketKey(msecs, frame.intervalSeconds), frame.intervalSeconds);
+
+        // 在副本上修改再写回，槽函数即使重入processTick导致m_openBars扩容也不受影响
+        AppData::Bar bar = m_openBars[base + i];
+        if (bar.tickCount > 0 && barStart != bar.timestamp) {
+            if (barStart < bar.timestamp) {
+                continue;
+            }
+            m_openBars[base + i].tickCount = 0;
+            emit barClosed(bar, frame.timeFrame);
+            bar.tickCount = 0;
+        }
+
+        if (bar.tickCount == 0) {
+            bar.timestamp = barStart;
+            bar.symbolId = symbolId;
+            bar.open = price;
+            bar.high = price;
+            bar.low = price;
+            bar.volume = 0.0;
+            bar.amount = 0.0;
+        }
+
+        bar.high = qMax(bar.high, price);
+        bar.low = qMin(bar.low, price);
+        bar.close = price;
+        bar.volume += volume;
+        bar.amount += amount;
+        bar.openInterest = tick.openInterest;
+        ++bar.tickCount;
+
+        m_openBars[base + i] = bar;
+        emit barUpdated(bar, frame.timeFrame);
+    }
+
+    if (specCount == 0) {
+        return;
+    }
+
+    // 信息驱动K线与批量合成使用同一个合成器
+    const int specBase = static_cast<int>(symbolId) * specCount;
+    if (specBase + specCount > m_barBuilders.size()) {
+        const int oldSize = m_barBuilders.size();
+        m_barBuilders.resize(specBase + specCount);
+        for (int index = oldSize; index < m_barBuilders.size(); ++index) {
+            m_barBuilders[index] = BarBuilder(m_streamingInfoBars[index % specCount]);
+        }
+    }
+
+    for (int i = 0; i < specCount; ++i) {
+        // 先完成合成再发出信号，槽函数即使重入processTick导致m_barBuilders扩容也不受影响
+        m_closedBars.clear();
+        BarBuilder &builder = m_barBuilders[specBase + i];
+        builder.add(msecs, symbolId, price, volume, amount, tick.openInterest, m_closedBars);
+        const bool updated = builder.hasOpenBar();
+        const AppData::Bar openBar = builder.openBar();
+        const BarSpec spec = m_streamingInfoBars[i];
+
+        const QVector<AppData::Bar> closedBars = m_closedBars;
+        for (const AppData::Bar &closed : closedBars) {
+            emit infoBarClosed(closed, spec);
+        }
+        if (updated) {
+            emit infoBarUpdated(openBar, spec);
+        }
+    }
 }
 
 QVector<AppData::MarketData> KlineGenerator::aggregateTicksToKline(
     const QVector<AppData::MarketData> &tickData,
     int intervalSeconds)
+{
+    return aggregateTicksToKline(tickData.constData(), tickData.constData() + tickData.size(), intervalSeconds);
+}
+
+QVector<AppData::MarketData> KlineGenerator::aggregateTicksToKline(
+    const AppData::MarketData *begin,
+    const AppData::MarketData *end,
+    int intervalSeconds)
 {
     QVector<AppData::MarketData> result;
     
-    if (tickData.isEmpty()) {
+    if (begin == end) {
         return result;
     }
     
-    // 获取第一个tick的时间和交易对
-    QDateTime firstTickTime = tickData.first().timestamp;
-    QString symbol = tickData.first().symbol;
-    
-    // 对齐第一个K线的开始时间
-    QDateTime currentKlineStart = alignTimestamp(firstTickTime, intervalSeconds);
-    QDateTime currentKlineEnd = currentKlineStart.addSecs(intervalSeconds);
+    // 获取第一个tick的交易对，以及进度计算所需的时间范围
+    QString symbol = begin->symbol;
+    quint32 symbolId = begin->symbolId;
+    ProgressThrottle progress(begin->timestamp.toMSecsSinceEpoch(),
+                              (end - 1)->timestamp.toMSecsSinceEpoch());
     
     AppData::MarketData currentKline;
+    qint64 currentBucket = 0;
     bool klineStarted = false;
     
     // 遍历所有tick数据
-    for (const auto &tick : tickData) {
-        // 如果tick时间超出当前K线的结束时间，保存当前K线并开始新的K线
-        while (tick.timestamp >= currentKlineEnd) {
-            // 保存已完成的K线
-            if (klineStarted) {
-                result.append(currentKline);
-                emit generationProgress(
-                    static_cast<int>((currentKlineEnd.toMSecsSinceEpoch() - firstTickTime.toMSecsSinceEpoch()) * 100.0 / 
-                                    (tickData.last().timestamp.toMSecsSinceEpoch() - firstTickTime.toMSecsSinceEpoch())),
-                    static_cast<AppData::TimeFrame>(intervalSeconds)
-                );
-            }
-            
-            // 开始新的K线
-            currentKlineStart = currentKlineEnd;
-            currentKlineEnd = currentKlineStart.addSecs(intervalSeconds);
-            klineStarted = false;
-        }
+    for (const AppData::MarketData *it = begin; it != end; ++it) {
+        const AppData::MarketData &tick = *it;
+        
+        // 时间戳直接换算为周期序号，跨越隔夜、周末等空档无需逐个周期推进
+        const qint64 msecs = tick.timestamp.toMSecsSinceEpoch();
+        const qint64 bucket = bucketKey(msecs, intervalSeconds);
         
-        // 如果tick时间在当前K线范围内
-        if (tick.timestamp >= currentKlineStart && tick.timestamp < currentKlineEnd) {
-            if (!klineStarted) {
-                // 初始化新K线
-                currentKline = AppData::MarketData();
-                currentKline.symbol = symbol;
-                currentKline.timestamp = currentKlineStart;
-                currentKline.open = tick.close;
-                currentKline.high = tick.close;
-                currentKline.low = tick.close;
-                currentKline.volume = 0;
-                currentKline.amount = 0;
-                klineStarted = true;
+        if (klineStarted && bucket != currentBucket) {
+            // 时间早于当前K线的乱序tick忽略
+            if (bucket < currentBucket) {
+                continue;
             }
             
-            // 更新K线数据
-            currentKline.high = qMax(currentKline.high, tick.close);
-            currentKline.low = qMin(currentKline.low, tick.close);
-            currentKline.close = tick.close;
-            currentKline.volume += tick.volume;
-            currentKline.amount += tick.amount;
+            // 保存已完成的K线
+            result.append(std::move(currentKline));
+            klineStarted = false;
             
-            // 更新买卖盘数据（累计最后一个tick的买卖盘数据）
-            if (tick.bidPrice > 0) {
-                currentKline.bidPrice = tick.bidPrice;
-                currentKline.bidVolume += tick.bidVolume;
-            }
-            if (tick.askPrice > 0) {
-                currentKline.askPrice = tick.askPrice;
-                currentKline.askVolume += tick.askVolume;
+            const int percent = progress.update(msecs);
+            if (percent >= 0) {
+                emit generationProgress(percent, static_cast<AppData::TimeFrame>(intervalSeconds));
             }
         }
+        
+        if (!klineStarted) {
+            // 初始化新K线
+            currentKline = AppData::MarketData();
+            currentKline.symbol = symbol;
+            currentKline.symbolId = symbolId;
+            currentKline.timestamp = QDateTime::fromMSecsSinceEpoch(bucketStartMs(bucket, intervalSeconds));
+            currentKline.open = tick.close;
+            currentKline.high = tick.close;
+            currentKline.low = tick.close;
+            currentKline.volume = 0;
+            currentKline.amount = 0;
+            currentBucket = bucket;
+            klineStarted = true;
+        }
+        
+        // 更新K线数据
+        currentKline.high = qMax(currentKline.high, tick.close);
+        currentKline.low = qMin(currentKline.low, tick.close);
+        currentKline.close = tick.close;
+        currentKline.volume += tick.volume;
+        currentKline.amount += tick.amount;
+        
+        // 更新买卖盘数据（累计最后一个tick的买卖盘数据）
+        if (tick.bidPrice > 0) {
+            currentKline.bidPrice = tick.bidPrice;
+            currentKline.bidVolume += tick.bidVolume;
+        }
+        if (tick.askPrice > 0) {
+            currentKline.askPrice = tick.askPrice;
+            currentKline.askVolume += tick.askVolume;
+        }
     }
     
     // 保存最后一个未完成的K线
     if (klineStarted) {
-        result.append(currentKline);
+        result.append(std::move(currentKline));
     }
     
+    emit generationProgress(100, static_cast<AppData::TimeFrame>(intervalSeconds));
     return result;
 }
 
@@ -366,74 +874,152 @@ QVector<AppData::MarketData> KlineGenerator::aggregateKlineToHigherTimeframe(
     int sourceInterval,
     int targetInterval)
 {
+    Q_UNUSED(sourceInterval);
+    
     QVector<AppData::MarketData> result;
     
     if (klineData.isEmpty()) {
         return result;
     }
     
-    // 获取第一个K线的时间和交易对
-    QDateTime firstKlineTime = klineData.first().timestamp;
+    // 获取第一个K线的交易对，以及进度计算所需的时间范围
     QString symbol = klineData.first().symbol;
-    
-    // 对齐第一个高周期K线的开始时间
-    QDateTime currentKlineStart = alignTimestamp(firstKlineTime, targetInterval);
-    QDateTime currentKlineEnd = currentKlineStart.addSecs(targetInterval);
+    quint32 symbolId = klineData.first().symbolId;
+    ProgressThrottle progress(klineData.first().timestamp.toMSecsSinceEpoch(),
+                              klineData.last().timestamp.toMSecsSinceEpoch());
     
     AppData::MarketData currentKline;
+    qint64 currentBucket = 0;
     bool klineStarted = false;
     
     // 遍历所有低周期K线数据
     for (const auto &kline : klineData) {
-        // 如果K线时间超出当前高周期K线的结束时间，保存当前K线并开始新的K线
-        while (kline.timestamp >= currentKlineEnd) {
-            // 保存已完成的K线
-            if (klineStarted) {
-                result.append(currentKline);
-                emit generationProgress(
-                    static_cast<int>((currentKlineEnd.toMSecsSinceEpoch() - firstKlineTime.toMSecsSinceEpoch()) * 100.0 / 
-                                    (klineData.last().timestamp.toMSecsSinceEpoch() - firstKlineTime.toMSecsSinceEpoch())),
-                    static_cast<AppData::TimeFrame>(targetInterval)
-                );
+        // 时间戳直接换算为高周期序号，跨越空档无需逐个周期推进
+        const qint64 msecs = kline.timestamp.toMSecsSinceEpoch();
+        const qint64 bucket = bucketKey(msecs, targetInterval);
+        
+        if (klineStarted && bucket != currentBucket) {
+            // 时间早于当前K线的乱序数据忽略
+            if (bucket < currentBucket) {
+                continue;
             }
             
-            // 开始新的K线
-            currentKlineStart = currentKlineEnd;
-            currentKlineEnd = currentKlineStart.addSecs(targetInterval);
+            // 保存已完成的K线
+            result.append(std::move(currentKline));
             klineStarted = false;
+            
+            const int percent = progress.update(msecs);
+            if (percent >= 0) {
+                emit generationProgress(percent, static_cast<AppData::TimeFrame>(targetInterval));
+            }
         }
         
-        // 如果K线时间在当前高周期K线范围内
-        if (kline.timestamp >= currentKlineStart && kline.timestamp < currentKlineEnd) {
-            if (!klineStarted) {
-                // 初始化新K线
-                currentKline = AppData::MarketData();
-                currentKline.symbol = symbol;
-                currentKline.timestamp = currentKlineStart;
-                currentKline.open = kline.open;
-                currentKline.high = kline.high;
-                currentKline.low = kline.low;
-                currentKline.volume = 0;
-                currentKline.amount = 0;
-                klineStarted = true;
+        if (!klineStarted) {
+            // 初始化新K线
+            currentKline = AppData::MarketData();
+            currentKline.symbol = symbol;
+            currentKline.symbolId = symbolId;
+            currentKline.timestamp = QDateTime::fromMSecsSinceEpoch(bucketStartMs(bucket, targetInterval));
+            currentKline.open = kline.open;
+            currentKline.high = kline.high;
+            currentKline.low = kline.low;
+            currentKline.volume = 0;
+            currentKline.amount = 0;
+            currentBucket = bucket;
+            klineStarted = true;
+        }
+        
+        // 更新K线数据
+        currentKline.high = qMax(currentKline.high, kline.high);
+        currentKline.low = qMin(currentKline.low, kline.low);
+        currentKline.close = kline.close;
+        currentKline.volume += kline.volume;
+        currentKline.amount += kline.amount;
+        
+        // 更新买卖盘数据（累计最后一个K线的买卖盘数据）
+        if (kline.bidPrice > 0) {
+            currentKline.bidPrice = kline.bidPrice;
+            currentKline.bidVolume += kline.bidVolume;
+        }
+        if (kline.askPrice > 0) {
+            currentKline.askPrice = kline.askPrice;
+            currentKline.askVolume += kline.askVolume;
+        }
+    }
+    
+    // 保存最后一个未完成的K线
+    if (klineStarted) {
+        result.append(std::move(currentKline));
+    }
+    
+    emit generationProgress(100, static_cast<AppData::TimeFrame>(targetInterval));
+    return result;
+}
+
+QVector<AppData::MarketData> KlineGenerator::aggregateViewToKline(
+    const BarView &view,
+    int intervalSeconds)
+{
+    QVector<AppData::MarketData> result;
+    
+    if (view.isEmpty()) {
+        return result;
+    }
+    
+    const qint64 *timestamps = view.timestamps();
+    const double *opens = view.column(ColumnarStore::OpenColumn);
+    const double *highs = view.column(ColumnarStore::HighColumn);
+    const double *lows = view.column(ColumnarStore::LowColumn);
+    const double *closes = view.column(ColumnarStore::CloseColumn);
+    const double *volumes = view.column(ColumnarStore::VolumeColumn);
+    const double *amounts = view.column(ColumnarStore::AmountColumn);
+    const double *bidPrices = view.column(ColumnarStore::BidPriceColumn);
+    const double *bidVolumes = view.column(ColumnarStore::BidVolumeColumn);
+    const double *askPrices = view.column(ColumnarStore::AskPriceColumn);
+    const double *askVolumes = view.column(ColumnarStore::AskVolumeColumn);
+    
+    // 按列扫描：tick数据的open/high/low与close相同，因此同样适用于tick和低周期K线
+    AppData::MarketData currentKline;
+    qint64 currentBucket = 0;
+    bool klineStarted = false;
+    
+    for (qint64 i = 0; i < view.size(); ++i) {
+        // 时间戳直接整除得到所属周期，跨越空档无需逐个周期推进
+        const qint64 bucket = bucketKey(timestamps[i], intervalSeconds);
+        
+        if (!klineStarted || bucket != currentBucket) {
+            // 保存已完成的K线
+            if (klineStarted) {
+                result.append(currentKline);
             }
             
-            // 更新K线数据
-            currentKline.high = qMax(currentKline.high, kline.high);
-            currentKline.low = qMin(currentKline.low, kline.low);
-            currentKline.close = kline.close;
-            currentKline.volume += kline.volume;
-            currentKline.amount += kline.amount;
-            
-            // 更新买卖盘数据（累计最后一个K线的买卖盘数据）
-            if (kline.bidPrice > 0) {
-                currentKline.bidPrice = kline.bidPrice;
-                currentKline.bidVolume += kline.bidVolume;
-            }
-            if (kline.askPrice > 0) {
-                currentKline.askPrice = kline.askPrice;
-                currentKline.askVolume += kline.askVolume;
-            }
+            // 初始化新K线
+            currentKline = AppData::MarketData();
+            currentKline.symbol = view.symbol();
+            currentKline.symbolId = view.symbolId();
+            currentKline.timestamp = QDateTime::fromMSecsSinceEpoch(bucketStartMs(bucket, intervalSeconds));
+            currentKline.open = opens[i];
+            currentKline.high = highs[i];
+            currentKline.low = lows[i];
+            currentBucket = bucket;
+            klineStarted = true;
+        }
+        
+        // 更新K线数据
+        currentKline.high = qMax(currentKline.high, highs[i]);
+        currentKline.low = qMin(currentKline.low, lows[i]);
+        currentKline.close = closes[i];
+        currentKline.volume += volumes[i];
+        currentKline.amount += amounts[i];
+        
+        // 更新买卖盘数据
+        if (bidPrices[i] > 0) {
+            currentKline.bidPrice = bidPrices[i];
+            currentKline.bidVolume += bidVolumes[i];
+        }
+        if (askPrices[i] > 0) {
+            currentKline.askPrice = askPrices[i];
+            currentKline.askVolume += askVolumes[i];
         }
     }
     
@@ -442,6 +1028,97 @@ QVector<AppData::MarketData> KlineGenerator::aggregateKlineToHigherTimeframe(
         result.append(currentKline);
     }
     
+    emit generationProgress(100, static_cast<AppData::TimeFrame>(intervalSeconds));
+    return result;
+}
+
+QVector<AppData::MarketData> KlineGenerator::aggregateTicksToBars(
+    const AppData::MarketData *begin,
+    const AppData::MarketData *end,
+    const BarSpec &spec)
+{
+    QVector<AppData::MarketData> result;
+    
+    if (begin == end) {
+        return result;
+    }
+    
+    const QString symbol = begin->symbol;
+    const quint32 symbolId = begin->symbolId;
+    ProgressThrottle progress(begin->timestamp.toMSecsSinceEpoch(),
+                              (end - 1)->timestamp.toMSecsSinceEpoch());
+    
+    BarBuilder builder(spec);
+    QVector<AppData::Bar> closed;
+    for (const AppData::MarketData *it = begin; it != end; ++it) {
+        const AppData::MarketData &tick = *it;
+        if (tick.close <= 0) {
+            continue;
+        }
+        
+        const qint64 msecs = tick.timestamp.toMSecsSinceEpoch();
+        closed.clear();
+        if (builder.add(msecs, symbolId, tick.close, tick.volume, tick.amount, tick.openInterest, closed) == 0) {
+            continue;
+        }
+        for (const AppData::Bar &bar : closed) {
+            result.append(BarSeries::toMarketData(bar, symbol));
+        }
+        
+        const int percent = progress.update(msecs);
+        if (percent >= 0) {
+            emit generationProgress(percent, AppData::KUnknown);
+        }
+    }
+    
+    // 保存最后一个未完成的K线
+    AppData::Bar last;
+    if (builder.flush(last)) {
+        result.append(BarSeries::toMarketData(last, symbol));
+    }
+    
+    emit generationProgress(100, AppData::KUnknown);
+    return result;
+}
+
+QVector<AppData::MarketData> KlineGenerator::aggregateViewToBars(
+    const BarView &view,
+    const BarSpec &spec)
+{
+    QVector<AppData::MarketData> result;
+    
+    if (view.isEmpty()) {
+        return result;
+    }
+    
+    const qint64 *timestamps = view.timestamps();
+    const double *closes = view.column(ColumnarStore::CloseColumn);
+    const double *volumes = view.column(ColumnarStore::VolumeColumn);
+    const double *amounts = view.column(ColumnarStore::AmountColumn);
+    
+    // 按列扫描，与aggregateTicksToBars相同的合成规则（列式存储不含持仓量）
+    BarBuilder builder(spec);
+    QVector<AppData::Bar> closed;
+    for (qint64 i = 0; i < view.size(); ++i) {
+        if (closes[i] <= 0) {
+            continue;
+        }
+        closed.clear();
+        if (builder.add(timestamps[i], view.symbolId(), closes[i], volumes[i], amounts[i], 0.0, closed) == 0) {
+            continue;
+        }
+        for (const AppData::Bar &bar : closed) {
+            result.append(BarSeries::toMarketData(bar, view.symbol()));
+        }
+    }
+    
+    // 保存最后一个未完成的K线
+    AppData::Bar last;
+    if (builder.flush(last)) {
+        result.append(BarSeries::toMarketData(last, view.symbol()));
+    }
+    
+    emit generationProgress(100, AppData::KUnknown);
     return result;
 }
 
@@ -476,9 +1153,32 @@ QDateTime KlineGenerator::alignTimestamp(
     int intervalSeconds) const
 {
     // 将时间戳对齐到周期的起始时间
-    qint64 msecs = timestamp.toMSecsSinceEpoch();
-    qint64 intervalMsecs = intervalSeconds * 1000LL;
-    qint64 alignedMsecs = (msecs / intervalMsecs) * intervalMsecs;
+    qint64 alignedMsecs = bucketStartMs(bucketKey(timestamp.toMSecsSinceEpoch(), intervalSeconds), intervalSeconds);
     
     return QDateTime::fromMSecsSinceEpoch(alignedMsecs);
 }
+
+qint64 KlineGenerator::bucketKey(qint64 msecs, int intervalSeconds) const
+{
+    if (m_tradingSession.isValid()) {
+        return m_tradingSession.bucketKey(msecs, intervalSeconds);
+    }
+    return bucketIndex(msecs, intervalSeconds * 1000LL);
+}
+
+qint64 KlineGenerator::barStartMs(qint64 msecs, const BarSpec &spec) const
+{
+    if (!spec.isTimeBar()) {
+        return msecs;
+    }
+    const int intervalSeconds = getTimeFrameSeconds(spec.timeFrame());
+    return bucketStartMs(bucketKey(msecs, intervalSeconds), intervalSeconds);
+}
+
+qint64 KlineGenerator::bucketStartMs(qint64 key, int intervalSeconds) const
+{
+    if (m_tradingSession.isValid()) {
+        return m_tradingSession.bucketStartMs(key, intervalSeconds);
+    }
+    return key * intervalSeconds * 1000LL;
+}
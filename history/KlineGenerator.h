@@ -2,10 +2,12 @@
 #define KLINEGENERATOR_H
 
 #include "../AppData.h"
+#include "BarBuilder.h"
+#include "KlineCache.h"
+#include "TradingSession.h"
 #include <QObject>
 #include <QVector>
 #include <QMap>
-#include <QCache>
 #include <QMutex>
 #include <QDateTime>
 #include <QThread>
@@ -13,6 +15,9 @@
 #include <QFuture>
 #include <QtConcurrent>
 #include <QScopedPointer>
+#include <functional>
+
+class BarView;
 
 /**
  * @brief K线生成器类，负责将tick级数据转换为指定周期的K线数据
@@ -38,6 +43,20 @@ public:
         AppData::TimeFrame timeFrame,
         bool forceRegenerate = false);
 
+    /**
+     * @brief 直接在列式存储视图上生成指定周期的K线数据
+     *
+     * 按列遍历内存映射的视图，不构造中间的MarketData对象
+     * @param view 列式存储视图（tick或低周期K线）
+     * @param timeFrame 目标时间周期
+     * @param forceRegenerate 是否强制重新生成（忽略缓存）
+     * @return 生成的K线数据
+     */
+    QVector<AppData::MarketData> generateKlineFromView(
+        const BarView &view,
+        AppData::TimeFrame timeFrame,
+        bool forceRegenerate = false);
+
     /**
      * @brief 从低周期K线生成高周期K线数据
      * @param sourceData 源K线数据
@@ -52,8 +71,38 @@ public:
         AppData::TimeFrame targetTimeFrame,
         bool forceRegenerate = false);
 
+    /**
+     * @brief 从tick数据生成指定规格的K线数据
+     *
+     * 时间K线等同于generateKlineFromTicks()；信息驱动K线由BarBuilder逐笔合成，
+     * 按品种、规格和源数据起始时间缓存（信息驱动K线的切分与起点有关）
+     * @param tickData tick级别数据
+     * @param spec K线规格
+     * @param forceRegenerate 是否强制重新生成（忽略缓存）
+     * @return 生成的K线数据，最后一根可能未完成
+     */
+    QVector<AppData::MarketData> generateBarsFromTicks(
+        const QVector<AppData::MarketData> &tickData,
+        const BarSpec &spec,
+        bool forceRegenerate = false);
+
+    /**
+     * @brief 直接在列式存储的tick视图上生成指定规格的K线数据
+     * @param view 列式存储视图（tick）
+     * @param spec K线规格
+     * @param forceRegenerate 是否强制重新生成（忽略缓存）
+     * @return 生成的K线数据，最后一根可能未完成
+     */
+    QVector<AppData::MarketData> generateBarsFromView(
+        const BarView &view,
+        const BarSpec &spec,
+        bool forceRegenerate = false);
+
     /**
      * @brief 预生成并缓存多个周期的K线数据
+     *
+     * 级联合成：只有最低周期遍历tick，更高的周期由下一级K线合成（如M1→M5→M15→…→W1）。
+     * 并行度来自按品种和按最高周期边界切分的时间段，而不是按周期，tick数据不会被复制
      * @param tickData tick级别数据
      * @param timeFrames 需要预生成的时间周期列表
      */
@@ -74,10 +123,116 @@ public:
     QString getCacheStatus() const;
 
     /**
-     * @brief 设置缓存大小（每个周期可缓存的K线数据集数量）
-     * @param size 缓存大小
+     * @brief 设置缓存的内存上限，超出时淘汰最久未使用的时间段
+     * @param bytes 字节数
+     */
+    void setCacheMemoryLimit(qint64 bytes);
+
+    /**
+     * @brief 获取缓存的内存上限
+     * @return 字节数
+     */
+    qint64 cacheMemoryLimit() const;
+
+    /**
+     * @brief 从缓存中取出[startMs, endMs]范围内的K线，不拷贝数据
+     *
+     * 该范围须完全落在此前生成过的某一段数据内，否则返回空切片
+     * @param symbol 交易品种代码
+     * @param timeFrame 时间周期
+     * @param startMs 开始时间(epoch毫秒)
+     * @param endMs 结束时间(epoch毫秒)
+     * @return K线切片
+     */
+    KlineSlice cachedKlines(
+        const QString &symbol,
+        AppData::TimeFrame timeFrame,
+        qint64 startMs,
+        qint64 endMs);
+
+    /**
+     * @brief 设置交易时段，之后的K线按交易所口径对齐（午休不占用分钟，日线按交易日，
+     *        夜盘归属下一交易日）；无效的时段表示按epoch对齐。
+     *
+     * 会清除缓存和所有未完成的K线，不应在预生成过程中调用
+     * @param session 交易时段
+     */
+    void setTradingSession(const TradingSession &session);
+
+    /**
+     * @brief 获取交易时段
+     * @return 交易时段
+     */
+    const TradingSession &tradingSession() const;
+
+    /**
+     * @brief 设置增量合成的K线周期，同时丢弃所有未完成的K线
+     * @param timeFrames 需要同时合成的时间周期列表
+     */
+    void setStreamingTimeFrames(const QVector<AppData::TimeFrame> &timeFrames);
+
+    /**
+     * @brief 获取增量合成的K线周期
+     * @return 时间周期列表
+     */
+    QVector<AppData::TimeFrame> streamingTimeFrames() const;
+
+    /**
+     * @brief 设置增量合成的信息驱动K线，同时丢弃这些K线未完成的部分
+     *
+     * 与时间K线共用processTick()，完成和更新通过infoBarClosed/infoBarUpdated通知
+     * @param specs 信息驱动K线的规格列表，时间K线和无效规格被忽略
+     */
+    void setStreamingInfoBars(const QVector<BarSpec> &specs);
+
+    /**
+     * @brief 获取增量合成的信息驱动K线规格
+     * @return 规格列表
+     */
+    QVector<BarSpec> streamingInfoBars() const;
+
+    /**
+     * @brief 设置tick中的成交量/成交额是否为累计值
+     *
+     * 实时行情（onLineMarket_A的当日累计、onLineMarket_OKB的24小时累计）给出的是累计量，
+     * 此时按相邻两个tick的差值计入K线；历史tick数据为逐笔量，保持默认的false
+     * @param cumulative 是否为累计值
+     */
+    void setStreamingCumulativeVolume(bool cumulative);
+
+    /**
+     * @brief 获取指定品种和周期当前未完成的K线
+     * @param symbolId 交易品种ID
+     * @param timeFrame 时间周期
+     * @param bar 输出的K线
+     * @return 是否存在未完成的K线
+     */
+    bool currentBar(quint32 symbolId, AppData::TimeFrame timeFrame, AppData::Bar &bar) const;
+
+    /**
+     * @brief 获取指定品种和规格当前未完成的信息驱动K线
+     * @param symbolId 交易品种ID
+     * @param spec K线规格
+     * @param bar 输出的K线
+     * @return 是否存在未完成的K线
+     */
+    bool currentInfoBar(quint32 symbolId, const BarSpec &spec, AppData::Bar &bar) const;
+
+    /**
+     * @brief 结束所有未完成的K线（如收盘或断线时），逐根发出barClosed
+     */
+    void flushStreamingBars();
+
+public slots:
+    /**
+     * @brief 将一个tick并入各周期当前未完成的K线
+     *
+     * 每个tick的工作量只与周期数有关，除首次出现新品种时扩容外不分配内存。
+     * 时间早于当前K线的迟到tick会被忽略。可直接连接onLineMarket::newMarketData，
+     * 增量合成的状态不加锁，需在同一线程中调用
+     * @param tick tick数据
      */
-    void setCacheSize(int size);
+    void processTick(const AppData::MarketData &tick);
 
 signals:
     /**
@@ -94,20 +249,57 @@ signals:
      */
     void logMessage(const QString &message, int level = 0);
 
-private:
     /**
-     * @brief 生成缓存键
-     * @param symbol 交易对符号
-     * @param startTime 开始时间
-     * @param endTime 结束时间
+     * @brief 未完成的K线被tick更新
+     * @param bar 更新后的K线
      * @param timeFrame 时间周期
-     * @return 缓存键
      */
-    QString generateCacheKey(
+    void barUpdated(const AppData::Bar &bar, AppData::TimeFrame timeFrame);
+
+    /**
+     * @brief K线完成（下一个周期的首个tick到达或flushStreamingBars时）
+     * @param bar 完成的K线
+     * @param timeFrame 时间周期
+     */
+    void barClosed(const AppData::Bar &bar, AppData::TimeFrame timeFrame);
+
+    /**
+     * @brief 未完成的信息驱动K线被tick更新
+     * @param bar 更新后的K线
+     * @param spec K线规格
+     */
+    void infoBarUpdated(const AppData::Bar &bar, const BarSpec &spec);
+
+    /**
+     * @brief 信息驱动K线完成（达到阈值或flushStreamingBars时），可经BarSpec::toCandle()交给策略
+     * @param bar 完成的K线
+     * @param spec K线规格
+     */
+    void infoBarClosed(const AppData::Bar &bar, const BarSpec &spec);
+
+private:
+    /**
+     * @brief 先查缓存，未命中时合成并写入缓存
+     *
+     * 时间K线在缓存已覆盖源数据开头的一段时，只合成之后新增的部分并接到缓存末尾；
+     * 信息驱动K线的切分与起点有关，按源数据起始时间分别缓存，不做增量合成
+     * @param symbol 交易品种代码
+     * @param spec 目标K线规格
+     * @param firstMs 源数据第一条的时间
+     * @param lastMs 源数据最后一条的时间
+     * @param forceRegenerate 是否强制重新生成
+     * @param startMessage 全量合成前输出的日志
+     * @param aggregate 合成时间晚于参数的源数据，参数为qint64最小值时合成全部数据
+     * @return K线数据
+     */
+    QVector<AppData::MarketData> generateWithCache(
         const QString &symbol,
-        const QDateTime &startTime,
-        const QDateTime &endTime,
-        AppData::TimeFrame timeFrame) const;
+        const BarSpec &spec,
+        qint64 firstMs,
+        qint64 lastMs,
+        bool forceRegenerate,
+        const QString &startMessage,
+        const std::function<QVector<AppData::MarketData>(qint64)> &aggregate);
 
     /**
      * @brief 将tick数据聚合为K线
@@ -119,6 +311,30 @@ private:
         const QVector<AppData::MarketData> &tickData,
         int interval);
 
+    /**
+     * @brief 将[begin, end)范围内的tick数据聚合为K线
+     * @param begin 起始tick
+     * @param end 结束tick（不包含）
+     * @param intervalSeconds 时间间隔（秒）
+     * @return 聚合后的K线数据
+     */
+    QVector<AppData::MarketData> aggregateTicksToKline(
+        const AppData::MarketData *begin,
+        const AppData::MarketData *end,
+        int intervalSeconds);
+
+    /**
+     * @brief 在一段tick数据上级联生成多个周期的K线
+     * @param begin 起始tick
+     * @param end 结束tick（不包含）
+     * @param levels 按周期长度升序排列的时间周期
+     * @return 与levels一一对应的K线数据
+     */
+    QVector<QVector<AppData::MarketData>> cascadeTicksToKlines(
+        const AppData::MarketData *begin,
+        const AppData::MarketData *end,
+        const QVector<AppData::TimeFrame> &levels);
+
     /**
      * @brief 将低周期K线聚合为高周期K线
      * @param klineData 低周期K线数据
@@ -131,6 +347,38 @@ private:
         int sourceInterval,
         int targetInterval);
 
+    /**
+     * @brief 将列式存储视图聚合为K线
+     * @param view 列式存储视图
+     * @param intervalSeconds 时间间隔（秒）
+     * @return 聚合后的K线数据
+     */
+    QVector<AppData::MarketData> aggregateViewToKline(
+        const BarView &view,
+        int intervalSeconds);
+
+    /**
+     * @brief 将[begin, end)范围内的tick数据合成为信息驱动K线
+     * @param begin 起始tick
+     * @param end 结束tick（不包含）
+     * @param spec K线规格
+     * @return 合成的K线数据
+     */
+    QVector<AppData::MarketData> aggregateTicksToBars(
+        const AppData::MarketData *begin,
+        const AppData::MarketData *end,
+        const BarSpec &spec);
+
+    /**
+     * @brief 将列式存储的tick视图合成为信息驱动K线
+     * @param view 列式存储视图
+     * @param spec K线规格
+     * @return 合成的K线数据
+     */
+    QVector<AppData::MarketData> aggregateViewToBars(
+        const BarView &view,
+        const BarSpec &spec);
+
     /**
      * @brief 获取时间周期对应的秒数
      * @param timeFrame 时间周期
@@ -158,18 +406,78 @@ private:
         const QDateTime &timestamp,
         int intervalSeconds) const;
 
+    /**
+     * @brief 时间戳所属K线的序号，设置了交易时段时按交易所口径，否则按epoch对齐
+     * @param msecs epoch毫秒
+     * @param intervalSeconds 周期秒数
+     * @return K线序号，随时间单调不减
+     */
+    qint64 bucketKey(qint64 msecs, int intervalSeconds) const;
+
+    /**
+     * @brief 源数据时间所属K线的起始时间
+     *
+     * 时间K线按bucketKey()对齐；信息驱动K线以首笔成交时间为起始，返回原值
+     * @param msecs epoch毫秒
+     * @param spec K线规格
+     * @return epoch毫秒
+     */
+    qint64 barStartMs(qint64 msecs, const BarSpec &spec) const;
+
+    /**
+     * @brief K线序号对应的起始时间
+     * @param key bucketKey()返回的序号
+     * @param intervalSeconds 周期秒数
+     * @return epoch毫秒
+     */
+    qint64 bucketStartMs(qint64 key, int intervalSeconds) const;
+
 private:
-    // 缓存不同周期的K线数据，键为缓存键，值为K线数据
-    QMap<AppData::TimeFrame, QCache<QString, QVector<AppData::MarketData>>*> m_klineCache;
-    
-    // 缓存大小
-    int m_cacheSize;
+    // 按品种和周期缓存的K线时间段
+    KlineCache m_klineCache;
     
     // 线程池，用于并行生成K线
     QThreadPool m_threadPool;
     
     // 互斥锁，保护缓存访问
     mutable QMutex m_cacheMutex;
+
+    // 交易时段，无效时按epoch对齐
+    TradingSession m_tradingSession;
+
+    // 增量合成的周期
+    struct StreamingFrame {
+        AppData::TimeFrame timeFrame;
+        int intervalSeconds;
+    };
+
+    // 累计成交量模式下每个品种上一个tick的累计值
+    struct StreamingVolume {
+        double volume;
+        double amount;
+        bool valid;
+
+        StreamingVolume() : volume(0.0), amount(0.0), valid(false) {}
+    };
+
+    QVector<StreamingFrame> m_streamingFrames;
+
+    // 未完成的K线，按 品种ID * 周期数 + 周期序号 索引，tickCount为0表示没有未完成的K线
+    QVector<AppData::Bar> m_openBars;
+
+    // 按品种ID索引
+    QVector<StreamingVolume> m_streamingVolumes;
+
+    // 增量合成的信息驱动K线
+    QVector<BarSpec> m_streamingInfoBars;
+
+    // 信息驱动K线的合成器，按 品种ID * 规格数 + 规格序号 索引
+    QVector<BarBuilder> m_barBuilders;
+
+    // 合成器输出的完成K线，复用以避免每个tick分配内存
+    QVector<AppData::Bar> m_closedBars;
+
+    bool m_cumulativeVolume;
 };
 
 #endif // KLINEGENERATOR_H
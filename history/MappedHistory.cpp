@@ -0,0 +1,198 @@
+﻿#include "MappedHistory.h"
+#include "../global/SymbolTable.h"
+#include <QtGlobal>
+#include <algorithm>
+#include <cstring>
+
+#if defined(Q_OS_UNIX)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#if defined(Q_OS_UNIX)
+// 对[begin, end)内完整的页调用madvise
+void adviseRange(const void *begin, const void *end, int advice)
+{
+    static const quintptr pageSize = static_cast<quintptr>(sysconf(_SC_PAGESIZE));
+    quintptr first = reinterpret_cast<quintptr>(begin) & ~(pageSize - 1);
+    quintptr last = reinterpret_cast<quintptr>(end) & ~(pageSize - 1);
+    if (last > first) {
+        madvise(reinterpret_cast<void *>(first), last - first, advice);
+    }
+}
+#endif
+
+} // namespace
+
+BarView::BarView()
+    : m_symbolId(0)
+    , m_timestamps(nullptr)
+    , m_size(0)
+{
+    std::fill(std::begin(m_columns), std::end(m_columns), nullptr);
+}
+
+BarView BarView::slice(qint64 startMs, qint64 endMs) const
+{
+    const qint64 *first = std::lower_bound(m_timestamps, m_timestamps + m_size, startMs);
+    const qint64 *last = std::upper_bound(first, m_timestamps + m_size, endMs);
+    return mid(first - m_timestamps, last - first);
+}
+
+BarView BarView::mid(qint64 offset, qint64 count) const
+{
+    offset = qBound<qint64>(0, offset, m_size);
+    count = qBound<qint64>(0, count, m_size - offset);
+
+    BarView result;
+    result.m_symbol = m_symbol;
+    result.m_symbolId = m_symbolId;
+    result.m_size = count;
+    if (count > 0) {
+        result.m_timestamps = m_timestamps + offset;
+        for (int c = 0; c < ColumnarStore::ColumnCount - 1; ++c) {
+            result.m_columns[c] = m_columns[c] + offset;
+        }
+    }
+    return result;
+}
+
+void BarView::fillMarketData(qint64 i, AppData::MarketData &data) const
+{
+    data.symbol = m_symbol;
+    data.symbolId = m_symbolId;
+    data.timestamp = QDateTime::fromMSecsSinceEpoch(m_timestamps[i]);
+    data.open = m_columns[ColumnarStore::OpenColumn - 1][i];
+    data.high = m_columns[ColumnarStore::HighColumn - 1][i];
+    data.low = m_columns[ColumnarStore::LowColumn - 1][i];
+    data.close = m_columns[ColumnarStore::CloseColumn - 1][i];
+    data.price = data.close;
+    data.volume = m_columns[ColumnarStore::VolumeColumn - 1][i];
+    data.amount = m_columns[ColumnarStore::AmountColumn - 1][i];
+    data.bidPrice = m_columns[ColumnarStore::BidPriceColumn - 1][i];
+    data.bidVolume = m_columns[ColumnarStore::BidVolumeColumn - 1][i];
+    data.askPrice = m_columns[ColumnarStore::AskPriceColumn - 1][i];
+    data.askVolume = m_columns[ColumnarStore::AskVolumeColumn - 1][i];
+}
+
+AppData::MarketData BarView::marketData(qint64 i) const
+{
+    AppData::MarketData data;
+    fillMarketData(i, data);
+    return data;
+}
+
+MappedHistory::MappedHistory()
+    : m_data(nullptr)
+    , m_mappedSize(0)
+{
+    std::memset(&m_header, 0, sizeof(m_header));
+}
+
+MappedHistory::~MappedHistory()
+{
+    close();
+}
+
+bool MappedHistory::open(const QString &filePath)
+{
+    close();
+
+    if (!ColumnarStore::readHeader(filePath, m_header)) {
+        return false;
+    }
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    m_mappedSize = ColumnarStore::columnOffset(m_header, ColumnarStore::ColumnCount);
+    m_data = m_file.map(0, m_mappedSize);
+    if (!m_data) {
+        m_file.close();
+        return false;
+    }
+
+    // 建立整个文件的视图，各列指针直接指向映射区域
+    m_fullView = BarView();
+    m_fullView.m_symbol = QString::fromUtf8(m_header.symbol,
+                                            static_cast<int>(qstrnlen(m_header.symbol, sizeof(m_header.symbol))));
+    m_fullView.m_symbolId = SymbolTable::instance()->intern(m_fullView.m_symbol);
+    m_fullView.m_size = m_header.rowCount;
+    m_fullView.m_timestamps = reinterpret_cast<const qint64 *>(
+        m_data + ColumnarStore::columnOffset(m_header, ColumnarStore::TimestampColumn));
+    for (int c = ColumnarStore::OpenColumn; c < ColumnarStore::ColumnCount; ++c) {
+        m_fullView.m_columns[c - 1] = reinterpret_cast<const double *>(
+            m_data + ColumnarStore::columnOffset(m_header, c));
+    }
+
+    return true;
+}
+
+void MappedHistory::close()
+{
+    if (m_data) {
+        m_file.unmap(m_data);
+        m_data = nullptr;
+    }
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    m_mappedSize = 0;
+    m_fullView = BarView();
+}
+
+bool MappedHistory::isOpen() const
+{
+    return m_data != nullptr;
+}
+
+const ColumnarStore::FileHeader &MappedHistory::header() const
+{
+    return m_header;
+}
+
+QString MappedHistory::filePath() const
+{
+    return m_file.fileName();
+}
+
+BarView MappedHistory::view() const
+{
+    return m_fullView;
+}
+
+BarView MappedHistory::view(qint64 startMs, qint64 endMs) const
+{
+    return m_fullView.slice(startMs, endMs);
+}
+
+void MappedHistory::adviseSequential() const
+{
+#if defined(Q_OS_UNIX)
+    if (m_data) {
+        adviseRange(m_data, m_data + m_mappedSize, MADV_SEQUENTIAL);
+    }
+#endif
+}
+
+void MappedHistory::releaseBefore(const BarView &view, qint64 row) const
+{
+#if defined(Q_OS_UNIX)
+    // 只读共享映射的页被丢弃后如再次访问会从文件重新读入，因此只影响性能不影响正确性
+    if (!m_data || view.isEmpty() || row <= 0) {
+        return;
+    }
+    row = qMin(row, view.size());
+    adviseRange(view.m_timestamps, view.m_timestamps + row, MADV_DONTNEED);
+    for (int c = 0; c < ColumnarStore::ColumnCount - 1; ++c) {
+        adviseRange(view.m_columns[c], view.m_columns[c] + row, MADV_DONTNEED);
+    }
+#else
+    Q_UNUSED(view);
+    Q_UNUSED(row);
+#endif
+}
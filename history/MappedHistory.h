@@ -0,0 +1,145 @@
+﻿#ifndef MAPPEDHISTORY_H
+#define MAPPEDHISTORY_H
+
+#include "ColumnarStore.h"
+#include "../AppData.h"
+#include <QFile>
+#include <QString>
+
+/**
+ * @brief 列式存储上的只读时间范围视图
+ *
+ * 视图直接指向内存映射文件中的各列，不拷贝数据，也不构造MarketData对象。
+ * 视图本身不持有映射，其生命周期不能超过创建它的MappedHistory。
+ * 与ColumnarStore::read()相同，按时间截取的范围为闭区间[startMs, endMs]。
+ */
+class BarView
+{
+public:
+    BarView();
+
+    // 行数
+    qint64 size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+
+    // 交易品种代码
+    const QString &symbol() const { return m_symbol; }
+
+    // 交易品种ID
+    quint32 symbolId() const { return m_symbolId; }
+
+    // 按行访问各列
+    qint64 timestamp(qint64 i) const { return m_timestamps[i]; }
+    double open(qint64 i) const { return m_columns[ColumnarStore::OpenColumn - 1][i]; }
+    double high(qint64 i) const { return m_columns[ColumnarStore::HighColumn - 1][i]; }
+    double low(qint64 i) const { return m_columns[ColumnarStore::LowColumn - 1][i]; }
+    double close(qint64 i) const { return m_columns[ColumnarStore::CloseColumn - 1][i]; }
+    double volume(qint64 i) const { return m_columns[ColumnarStore::VolumeColumn - 1][i]; }
+    double amount(qint64 i) const { return m_columns[ColumnarStore::AmountColumn - 1][i]; }
+
+    // 获取整列的连续数组（column不能为TimestampColumn）
+    const qint64 *timestamps() const { return m_timestamps; }
+    const double *column(ColumnarStore::Column column) const { return m_columns[column - 1]; }
+
+    // 第一行/最后一行的时间戳
+    qint64 firstTimestamp() const { return m_size > 0 ? m_timestamps[0] : 0; }
+    qint64 lastTimestamp() const { return m_size > 0 ? m_timestamps[m_size - 1] : 0; }
+
+    /**
+     * @brief 获取[startMs, endMs]时间范围的子视图
+     * @param startMs 开始时间(毫秒，包含)
+     * @param endMs 结束时间(毫秒，包含)
+     * @return 子视图
+     */
+    BarView slice(qint64 startMs, qint64 endMs) const;
+
+    /**
+     * @brief 获取按行号截取的子视图
+     * @param offset 起始行
+     * @param count 行数
+     * @return 子视图
+     */
+    BarView mid(qint64 offset, qint64 count) const;
+
+    /**
+     * @brief 将一行数据填充到已有的MarketData对象中
+     *
+     * 反复复用同一个对象可避免逐行分配内存（symbol为隐式共享，不会拷贝字符串）
+     */
+    void fillMarketData(qint64 i, AppData::MarketData &data) const;
+
+    // 构造一行MarketData
+    AppData::MarketData marketData(qint64 i) const;
+
+private:
+    friend class MappedHistory;
+
+    QString m_symbol;
+    quint32 m_symbolId;
+    const qint64 *m_timestamps;
+    const double *m_columns[ColumnarStore::ColumnCount - 1];
+    qint64 m_size;
+};
+
+/**
+ * @brief 基于内存映射的列式历史数据读取器
+ *
+ * 通过QFile::map映射整个存储文件，按时间戳列二分查找得到时间范围视图。
+ * 数据页由操作系统按需换入，已遍历的部分可通过releaseBefore()交还，
+ * 使超大文件的回测常驻内存远小于文件大小。
+ */
+class MappedHistory
+{
+public:
+    MappedHistory();
+    ~MappedHistory();
+
+    // 打开并映射存储文件
+    bool open(const QString &filePath);
+
+    // 取消映射并关闭文件
+    void close();
+
+    // 是否已打开
+    bool isOpen() const;
+
+    // 文件头
+    const ColumnarStore::FileHeader &header() const;
+
+    // 文件路径
+    QString filePath() const;
+
+    // 整个文件的视图
+    BarView view() const;
+
+    /**
+     * @brief 获取[startMs, endMs]时间范围的视图
+     * @param startMs 开始时间(毫秒，包含)
+     * @param endMs 结束时间(毫秒，包含)
+     * @return 视图，范围内无数据时为空视图
+     */
+    BarView view(qint64 startMs, qint64 endMs) const;
+
+    /**
+     * @brief 提示操作系统将按顺序访问映射区域
+     */
+    void adviseSequential() const;
+
+    /**
+     * @brief 通知操作系统视图中第row行之前的数据不再需要，可以回收对应的物理页
+     * @param view 由本对象创建的视图
+     * @param row 视图内的行号
+     */
+    void releaseBefore(const BarView &view, qint64 row) const;
+
+private:
+    Q_DISABLE_COPY(MappedHistory)
+
+    QFile m_file;
+    uchar *m_data;
+    qint64 m_mappedSize;
+    ColumnarStore::FileHeader m_header;
+    BarView m_fullView;
+};
+
+#endif // MAPPEDHISTORY_H
@@ -0,0 +1,180 @@
+﻿#include "MarketEventStream.h"
+#include <algorithm>
+
+namespace {
+
+// 每遍历这么多行，就把已遍历部分对应的物理页交还给操作系统
+const qint64 kReleaseInterval = 1 << 16;
+
+// 小顶堆比较：时间戳较晚的元素下沉，时间戳相同时先添加的数据源优先
+struct Later {
+    template <typename Entry>
+    bool operator()(const Entry &a, const Entry &b) const
+    {
+        return a.timestamp != b.timestamp ? a.timestamp > b.timestamp : a.source > b.source;
+    }
+};
+
+} // namespace
+
+MappedEventSource::MappedEventSource(std::shared_ptr<MappedHistory> history, const BarView &view)
+    : m_history(history)
+    , m_view(view)
+    , m_index(0)
+{
+}
+
+bool MappedEventSource::atEnd() const
+{
+    return m_index >= m_view.size();
+}
+
+qint64 MappedEventSource::timestamp() const
+{
+    return m_view.timestamp(m_index);
+}
+
+void MappedEventSource::fill(AppData::MarketData &data)
+{
+    m_view.fillMarketData(m_index, data);
+}
+
+void MappedEventSource::advance()
+{
+    ++m_index;
+    if (m_history && m_index % kReleaseInterval == 0) {
+        m_history->releaseBefore(m_view, m_index);
+    }
+}
+
+qint64 MappedEventSource::size() const
+{
+    return m_view.size();
+}
+
+VectorEventSource::VectorEventSource(QVector<AppData::MarketData> data)
+    : m_data(std::move(data))
+    , m_index(0)
+    , m_size(m_data.size())
+    , m_timestamp(0)
+{
+    if (!m_data.isEmpty()) {
+        m_timestamp = m_data.first().timestamp.toMSecsSinceEpoch();
+    }
+}
+
+bool VectorEventSource::atEnd() const
+{
+    return m_index >= m_size;
+}
+
+qint64 VectorEventSource::timestamp() const
+{
+    return m_timestamp;
+}
+
+void VectorEventSource::fill(AppData::MarketData &data)
+{
+    // 每行只会被取出一次，直接移出
+    data = std::move(m_data[m_index]);
+}
+
+void VectorEventSource::advance()
+{
+    if (++m_index < m_size) {
+        m_timestamp = m_data[m_index].timestamp.toMSecsSinceEpoch();
+    } else {
+        // 遍历结束后释放内存
+        m_data = QVector<AppData::MarketData>();
+    }
+}
+
+qint64 VectorEventSource::size() const
+{
+    return m_size;
+}
+
+MarketEventStream::MarketEventStream()
+    : m_size(0)
+    , m_consumed(0)
+{
+}
+
+void MarketEventStream::addSource(std::shared_ptr<MarketEventSource> source)
+{
+    if (!source) {
+        return;
+    }
+
+    m_size += source->size();
+    m_sources.append(source);
+    push(m_sources.size() - 1);
+}
+
+void MarketEventStream::addView(std::shared_ptr<MappedHistory> history, const BarView &view)
+{
+    addSource(std::make_shared<MappedEventSource>(history, view));
+}
+
+void MarketEventStream::addData(QVector<AppData::MarketData> data)
+{
+    addSource(std::make_shared<VectorEventSource>(std::move(data)));
+}
+
+bool MarketEventStream::next(AppData::MarketData &data)
+{
+    if (m_heap.empty()) {
+        return false;
+    }
+
+    std::pop_heap(m_heap.begin(), m_heap.end(), Later());
+    const int source = m_heap.back().source;
+    m_heap.pop_back();
+
+    MarketEventSource &cursor = *m_sources[source];
+    cursor.fill(data);
+    cursor.advance();
+    push(source);
+
+    ++m_consumed;
+    return true;
+}
+
+bool MarketEventStream::atEnd() const
+{
+    return m_heap.empty();
+}
+
+qint64 MarketEventStream::size() const
+{
+    return m_size;
+}
+
+qint64 MarketEventStream::consumed() const
+{
+    return m_consumed;
+}
+
+int MarketEventStream::sourceCount() const
+{
+    return m_sources.size();
+}
+
+void MarketEventStream::clear()
+{
+    m_sources.clear();
+    m_heap.clear();
+    m_size = 0;
+    m_consumed = 0;
+}
+
+void MarketEventStream::push(int source)
+{
+    const MarketEventSource &cursor = *m_sources[source];
+    if (cursor.atEnd()) {
+        return;
+    }
+
+    m_heap.push_back({cursor.timestamp(), source});
+    std::push_heap(m_heap.begin(), m_heap.end(), Later());
+}
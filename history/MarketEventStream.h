@@ -0,0 +1,136 @@
+﻿#ifndef MARKETEVENTSTREAM_H
+#define MARKETEVENTSTREAM_H
+
+#include "MappedHistory.h"
+#include "../AppData.h"
+#include <QVector>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief 单个品种的行情游标
+ *
+ * 按时间升序逐行提供行情数据，由MarketEventStream按时间戳归并。
+ */
+class MarketEventSource
+{
+public:
+    virtual ~MarketEventSource() {}
+
+    // 是否已遍历完
+    virtual bool atEnd() const = 0;
+
+    // 当前行的时间戳(毫秒)
+    virtual qint64 timestamp() const = 0;
+
+    // 将当前行填充到data中
+    virtual void fill(AppData::MarketData &data) = 0;
+
+    // 移动到下一行
+    virtual void advance() = 0;
+
+    // 总行数
+    virtual qint64 size() const = 0;
+};
+
+/**
+ * @brief 内存映射视图上的行情游标，已遍历的数据页会定期交还给操作系统
+ */
+class MappedEventSource : public MarketEventSource
+{
+public:
+    MappedEventSource(std::shared_ptr<MappedHistory> history, const BarView &view);
+
+    bool atEnd() const override;
+    qint64 timestamp() const override;
+    void fill(AppData::MarketData &data) override;
+    void advance() override;
+    qint64 size() const override;
+
+private:
+    std::shared_ptr<MappedHistory> m_history;
+    BarView m_view;
+    qint64 m_index;
+};
+
+/**
+ * @brief 内存中已加载数据上的行情游标，数据在被取出时移出
+ */
+class VectorEventSource : public MarketEventSource
+{
+public:
+    explicit VectorEventSource(QVector<AppData::MarketData> data);
+
+    bool atEnd() const override;
+    qint64 timestamp() const override;
+    void fill(AppData::MarketData &data) override;
+    void advance() override;
+    qint64 size() const override;
+
+private:
+    QVector<AppData::MarketData> m_data;
+    int m_index;
+    int m_size;
+    qint64 m_timestamp;
+};
+
+/**
+ * @brief 多品种行情事件流
+ *
+ * 用最小堆按时间戳归并各品种的游标，每次next()只取出一行。
+ * 不需要把所有品种的数据合并成一个大数组再排序；以内存映射视图为数据源时，
+ * 常驻内存只与品种数量有关，与数据行数无关。
+ * 时间戳相同的行按添加数据源的顺序输出。
+ */
+class MarketEventStream
+{
+public:
+    MarketEventStream();
+
+    // 添加数据源
+    void addSource(std::shared_ptr<MarketEventSource> source);
+
+    // 添加内存映射视图数据源
+    void addView(std::shared_ptr<MappedHistory> history, const BarView &view);
+
+    // 添加已加载到内存的数据源（数据需按时间升序排列）
+    void addData(QVector<AppData::MarketData> data);
+
+    /**
+     * @brief 取出时间戳最小的一行
+     * @param data 输出数据，可反复复用同一个对象
+     * @return 是否取到数据，事件流结束时返回false
+     */
+    bool next(AppData::MarketData &data);
+
+    // 是否已结束
+    bool atEnd() const;
+
+    // 所有数据源的总行数
+    qint64 size() const;
+
+    // 已取出的行数
+    qint64 consumed() const;
+
+    // 数据源数量
+    int sourceCount() const;
+
+    // 清空所有数据源
+    void clear();
+
+private:
+    // 堆元素
+    struct Entry {
+        qint64 timestamp;
+        int source;
+    };
+
+    void push(int source);
+
+    QVector<std::shared_ptr<MarketEventSource>> m_sources;
+    std::vector<Entry> m_heap;
+    qint64 m_size;
+    qint64 m_consumed;
+};
+
+#endif // MARKETEVENTSTREAM_H
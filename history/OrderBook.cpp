@@ -0,0 +1,212 @@
+﻿#include "OrderBook.h"
+
+bool OrderBook::StopAbove::operator()(const StopEntry &a, const StopEntry &b) const
+{
+    // 触发价低的先出堆，相同触发价先提交的先出堆
+    return a.triggerPrice != b.triggerPrice ? a.triggerPrice > b.triggerPrice : a.sequence > b.sequence;
+}
+
+bool OrderBook::StopBelow::operator()(const StopEntry &a, const StopEntry &b) const
+{
+    // 触发价高的先出堆，相同触发价先提交的先出堆
+    return a.triggerPrice != b.triggerPrice ? a.triggerPrice < b.triggerPrice : a.sequence > b.sequence;
+}
+
+OrderBook::OrderBook()
+    : m_nextSequence(0)
+    , m_staleStops(0)
+{
+}
+
+void OrderBook::add(const AppData::Order &order)
+{
+    remove(order.orderId);
+
+    const quint64 sequence = ++m_nextSequence;
+    Entry entry;
+    entry.order = order;
+    entry.hasLevel = false;
+
+    if (order.type == AppData::Market) {
+        m_marketOrders.append(sequence);
+    } else if (order.type == AppData::Limit) {
+        if (order.direction == AppData::Long) {
+            entry.level = m_buyLimits.insert(std::make_pair(order.price, sequence));
+            entry.hasLevel = true;
+        } else if (order.direction == AppData::Short) {
+            entry.level = m_sellLimits.insert(std::make_pair(order.price, sequence));
+            entry.hasLevel = true;
+        }
+    } else if (order.type == AppData::Stop) {
+        if (order.direction == AppData::Long) {
+            m_buyStops.push({order.stopPrice, sequence});
+        } else if (order.direction == AppData::Short) {
+            m_sellStops.push({order.stopPrice, sequence});
+        }
+    }
+    // 其他类型的订单暂不撮合，只保留在活动订单中以便撤单和查询
+
+    m_entries.insert(sequence, entry);
+    m_sequences.insert(order.orderId, sequence);
+}
+
+bool OrderBook::remove(const QString &orderId)
+{
+    auto it = m_sequences.find(orderId);
+    if (it == m_sequences.end()) {
+        return false;
+    }
+
+    const quint64 sequence = it.value();
+    m_sequences.erase(it);
+
+    auto entry = m_entries.find(sequence);
+    if (entry != m_entries.end()) {
+        if (entry->hasLevel) {
+            if (entry->order.direction == AppData::Long) {
+                m_buyLimits.erase(entry->level);
+            } else {
+                m_sellLimits.erase(entry->level);
+            }
+        }
+        // 市价单和止损单在出队/出堆时跳过
+        const bool isStop = entry->order.type == AppData::Stop;
+        m_entries.erase(entry);
+        if (isStop && ++m_staleStops > 64 && m_staleStops > m_entries.size()) {
+            compactStops();
+        }
+    }
+    return true;
+}
+
+bool OrderBook::contains(const QString &orderId) const
+{
+    return m_sequences.contains(orderId);
+}
+
+int OrderBook::size() const
+{
+    return m_entries.size();
+}
+
+bool OrderBook::isEmpty() const
+{
+    return m_entries.isEmpty();
+}
+
+QVector<AppData::Order> OrderBook::orders() const
+{
+    QVector<AppData::Order> result;
+    result.reserve(m_entries.size());
+    for (const auto &entry : m_entries) {
+        result.append(entry.order);
+    }
+    return result;
+}
+
+void OrderBook::match(const AppData::MarketData &data, QVector<Fill> &fills)
+{
+    if (m_entries.isEmpty()) {
+        return;
+    }
+
+    // 市价单立即以收盘价成交
+    if (!m_marketOrders.isEmpty()) {
+        const QVector<quint64> marketOrders = m_marketOrders;
+        m_marketOrders.clear();
+        for (quint64 sequence : marketOrders) {
+            if (m_entries.contains(sequence)) {
+                takeFill(sequence, data.close, fills);
+            }
+        }
+    }
+
+    // 买入限价单：价格不低于最低价即成交，从最高价开始
+    while (!m_buyLimits.empty()) {
+        auto level = std::prev(m_buyLimits.end());
+        if (level->first < data.low) {
+            break;
+        }
+        const double price = level->first;
+        const quint64 sequence = level->second;
+        m_buyLimits.erase(level);
+        m_entries[sequence].hasLevel = false;
+        takeFill(sequence, price, fills);
+    }
+
+    // 卖出限价单：价格不高于最高价即成交，从最低价开始
+    while (!m_sellLimits.empty()) {
+        auto level = m_sellLimits.begin();
+        if (level->first > data.high) {
+            break;
+        }
+        const double price = level->first;
+        const quint64 sequence = level->second;
+        m_sellLimits.erase(level);
+        m_entries[sequence].hasLevel = false;
+        takeFill(sequence, price, fills);
+    }
+
+    // 买入止损单：最高价达到触发价即以触发价成交
+    while (!m_buyStops.empty() && m_buyStops.top().triggerPrice <= data.high) {
+        const StopEntry stop = m_buyStops.top();
+        m_buyStops.pop();
+        if (m_entries.contains(stop.sequence)) {
+            takeFill(stop.sequence, stop.triggerPrice, fills);
+        } else {
+            --m_staleStops;
+        }
+    }
+
+    // 卖出止损单：最低价达到触发价即以触发价成交
+    while (!m_sellStops.empty() && m_sellStops.top().triggerPrice >= data.low) {
+        const StopEntry stop = m_sellStops.top();
+        m_sellStops.pop();
+        if (m_entries.contains(stop.sequence)) {
+            takeFill(stop.sequence, stop.triggerPrice, fills);
+        } else {
+            --m_staleStops;
+        }
+    }
+}
+
+void OrderBook::clear()
+{
+    m_entries.clear();
+    m_sequences.clear();
+    m_marketOrders.clear();
+    m_buyLimits.clear();
+    m_sellLimits.clear();
+    m_buyStops = decltype(m_buyStops)();
+    m_sellStops = decltype(m_sellStops)();
+    m_staleStops = 0;
+}
+
+void OrderBook::compactStops()
+{
+    std::vector<StopEntry> buyStops;
+    std::vector<StopEntry> sellStops;
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        const AppData::Order &order = it->order;
+        if (order.type != AppData::Stop) {
+            continue;
+        }
+        if (order.direction == AppData::Long) {
+            buyStops.push_back({order.stopPrice, it.key()});
+        } else if (order.direction == AppData::Short) {
+            sellStops.push_back({order.stopPrice, it.key()});
+        }
+    }
+
+    m_buyStops = decltype(m_buyStops)(StopAbove(), std::move(buyStops));
+    m_sellStops = decltype(m_sellStops)(StopBelow(), std::move(sellStops));
+    m_staleStops = 0;
+}
+
+void OrderBook::takeFill(quint64 sequence, double fillPrice, QVector<Fill> &fills)
+{
+    auto entry = m_entries.find(sequence);
+    fills.append(qMakePair(entry->order, fillPrice));
+    m_sequences.remove(entry->order.orderId);
+    m_entries.erase(entry);
+}
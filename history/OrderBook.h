@@ -0,0 +1,98 @@
+﻿#ifndef ORDERBOOK_H
+#define ORDERBOOK_H
+
+#include "../AppData.h"
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include <QVector>
+#include <functional>
+#include <map>
+#include <queue>
+#include <vector>
+
+/**
+ * @brief 回测用的单品种订单簿
+ *
+ * 限价单按价格排序存放，止损单按触发价放在堆中，每条行情只访问价格被穿越的订单：
+ *   - 买入限价单：价格 >= 最低价时成交，从最高价向下遍历
+ *   - 卖出限价单：价格 <= 最高价时成交，从最低价向上遍历
+ *   - 买入止损单：最高价 >= 触发价时成交，触发价小顶堆
+ *   - 卖出止损单：最低价 <= 触发价时成交，触发价大顶堆
+ * 撤单时限价单直接从有序表中删除，止损单采用延迟删除，出堆时跳过已撤销的订单。
+ * 每条行情的撮合开销为 O(成交数 + log n)。
+ */
+class OrderBook
+{
+public:
+    // 成交的订单及成交价
+    typedef QPair<AppData::Order, double> Fill;
+
+    OrderBook();
+
+    // 添加订单，订单ID已存在时替换原订单
+    void add(const AppData::Order &order);
+
+    // 撤销订单，订单不存在时返回false
+    bool remove(const QString &orderId);
+
+    // 是否包含订单
+    bool contains(const QString &orderId) const;
+
+    // 活动订单数量
+    int size() const;
+    bool isEmpty() const;
+
+    // 所有活动订单
+    QVector<AppData::Order> orders() const;
+
+    /**
+     * @brief 用一条行情撮合，成交的订单按成交顺序追加到fills并移出订单簿
+     * @param data 行情数据
+     * @param fills 输出的成交列表
+     */
+    void match(const AppData::MarketData &data, QVector<Fill> &fills);
+
+    // 清空订单簿
+    void clear();
+
+private:
+    typedef std::multimap<double, quint64> PriceLevels;
+
+    // 止损单堆元素
+    struct StopEntry {
+        double triggerPrice;
+        quint64 sequence;
+    };
+    struct StopAbove {
+        bool operator()(const StopEntry &a, const StopEntry &b) const;
+    };
+    struct StopBelow {
+        bool operator()(const StopEntry &a, const StopEntry &b) const;
+    };
+
+    // 活动订单
+    struct Entry {
+        AppData::Order order;
+        PriceLevels::iterator level;    // 限价单在有序表中的位置
+        bool hasLevel;
+    };
+
+    // 取出订单加入成交列表
+    void takeFill(quint64 sequence, double fillPrice, QVector<Fill> &fills);
+
+    // 已撤销的止损单过多时重建止损堆
+    void compactStops();
+
+    quint64 m_nextSequence;
+    int m_staleStops;                       // 止损堆中已撤销的元素数量
+    QHash<quint64, Entry> m_entries;        // 按序号索引的活动订单
+    QHash<QString, quint64> m_sequences;    // 订单ID到序号
+    QVector<quint64> m_marketOrders;        // 市价单，按提交顺序
+    PriceLevels m_buyLimits;                // 买入限价单
+    PriceLevels m_sellLimits;               // 卖出限价单
+    std::priority_queue<StopEntry, std::vector<StopEntry>, StopAbove> m_buyStops;   // 买入止损单，触发价小顶堆
+    std::priority_queue<StopEntry, std::vector<StopEntry>, StopBelow> m_sellStops;  // 卖出止损单，触发价大顶堆
+};
+
+#endif // ORDERBOOK_H
@@ -1,8 +1,19 @@
 #include "Strategy.h"
+#include "../global/SymbolTable.h"
+#include <atomic>
+
+namespace {
+
+// 进程内策略实例的序号，作为订单ID前缀的一部分
+std::atomic<quint64> g_strategyIndex(0);
+
+} // namespace
 
 Strategy::Strategy(QObject *parent)
     : QObject(parent)
     , m_isBacktest(false)
+    , m_strategyIndex(++g_strategyIndex)
+    , m_orderSequence(0)
 {
 }
 
@@ -84,6 +95,8 @@ AppData::Order Strategy::buyMarket(const QString &symbol, double quantity)
 {
     AppData::Order order;
     order.symbol = symbol;
+    order.symbolId = SymbolTable::instance()->intern(symbol);
+    order.orderId = nextOrderId();
     order.direction = AppData::Long;
     order.type = AppData::Market;
     order.quantity = quantity;
@@ -101,6 +114,8 @@ AppData::Order Strategy::sellMarket(const QString &symbol, double quantity)
 {
     AppData::Order order;
     order.symbol = symbol;
+    order.symbolId = SymbolTable::instance()->intern(symbol);
+    order.orderId = nextOrderId();
     order.direction = AppData::Short;
     order.type = AppData::Market;
     order.quantity = quantity;
@@ -118,6 +133,8 @@ AppData::Order Strategy::buyLimit(const QString &symbol, double price, double qu
 {
     AppData::Order order;
     order.symbol = symbol;
+    order.symbolId = SymbolTable::instance()->intern(symbol);
+    order.orderId = nextOrderId();
     order.direction = AppData::Long;
     order.type = AppData::Limit;
     order.price = price;
@@ -136,6 +153,8 @@ AppData::Order Strategy::sellLimit(const QString &symbol, double price, double q
 {
     AppData::Order order;
     order.symbol = symbol;
+    order.symbolId = SymbolTable::instance()->intern(symbol);
+    order.orderId = nextOrderId();
     order.direction = AppData::Short;
     order.type = AppData::Limit;
     order.price = price;
@@ -154,6 +173,8 @@ AppData::Order Strategy::buyStop(const QString &symbol, double stopPrice, double
 {
     AppData::Order order;
     order.symbol = symbol;
+    order.symbolId = SymbolTable::instance()->intern(symbol);
+    order.orderId = nextOrderId();
     order.direction = AppData::Long;
     order.type = AppData::Stop;
     order.stopPrice = stopPrice;
@@ -172,6 +193,8 @@ AppData::Order Strategy::sellStop(const QString &symbol, double stopPrice, doubl
 {
     AppData::Order order;
     order.symbol = symbol;
+    order.symbolId = SymbolTable::instance()->intern(symbol);
+    order.orderId = nextOrderId();
     order.direction = AppData::Short;
     order.type = AppData::Stop;
     order.stopPrice = stopPrice;
@@ -186,6 +209,13 @@ AppData::Order Strategy::sellStop(const QString &symbol, double stopPrice, doubl
     return order;
 }
 
+QString Strategy::nextOrderId()
+{
+    // 订单ID在进程内唯一，使策略可以用下单返回的订单撤单。策略名称可能相同或为空，
+    // 前缀中带上策略实例序号，同一引擎中的多个策略不会互相覆盖订单
+    return QString("%1#%2_%3").arg(m_name).arg(m_strategyIndex).arg(++m_orderSequence);
+}
+
 bool Strategy::cancelOrder(const QString &orderId)
 {
     if (m_cancelOrderCallback) {
@@ -199,14 +229,22 @@ QVector<AppData::Position> Strategy::getPositions() const
 {
     QVector<AppData::Position> positions;
     for (const auto &position : m_positions) {
-        positions.append(position);
+        // 跳过未使用的下标
+        if (position.symbolId != SymbolTable::kInvalidId) {
+            positions.append(position);
+        }
     }
     return positions;
 }
 
 AppData::Position Strategy::getPosition(const QString &symbol) const
 {
-    return m_positions.value(symbol);
+    return getPosition(SymbolTable::instance()->find(symbol));
+}
+
+AppData::Position Strategy::getPosition(quint32 symbolId) const
+{
+    return m_positions.value(static_cast<int>(symbolId));
 }
 
 QVector<AppData::Order> Strategy::getActiveOrders() const
@@ -240,7 +278,19 @@ void Strategy::setAccount(const AppData::Account &account)
 
 void Strategy::addPosition(const AppData::Position &position)
 {
-    m_positions[position.symbol] = position;
+    quint32 symbolId = position.symbolId;
+    if (symbolId == SymbolTable::kInvalidId) {
+        symbolId = SymbolTable::instance()->intern(position.symbol);
+    }
+    if (symbolId == SymbolTable::kInvalidId) {
+        return;
+    }
+
+    if (static_cast<int>(symbolId) >= m_positions.size()) {
+        m_positions.resize(static_cast<int>(symbolId) + 1);
+    }
+    m_positions[static_cast<int>(symbolId)] = position;
+    m_positions[static_cast<int>(symbolId)].symbolId = symbolId;
 }
 
 void Strategy::addOrder(const AppData::Order &order)
@@ -75,6 +75,7 @@ public:
     // 查询接口
     QVector<AppData::Position> getPositions() const;
     AppData::Position getPosition(const QString &symbol) const;
+    AppData::Position getPosition(quint32 symbolId) const;
     QVector<AppData::Order> getActiveOrders() const;
     AppData::Order getOrder(const QString &orderId) const;
     AppData::Account getAccount() const;
@@ -104,8 +105,13 @@ protected:
     bool m_isBacktest;               // 是否为回测模式
     QMap<QString, QVariant> m_parameters; // 策略参数
     AppData::Account m_account;      // 账户信息
-    QMap<QString, AppData::Position> m_positions; // 持仓信息
+    QVector<AppData::Position> m_positions; // 持仓信息，按品种ID(SymbolTable)索引
     QMap<QString, AppData::Order> m_orders;       // 订单信息
+    quint64 m_strategyIndex;         // 策略实例序号，订单ID前缀
+    quint64 m_orderSequence;         // 订单ID序号
+
+    // 生成新的订单ID
+    QString nextOrderId();
 
     // 回测引擎回调函数
     std::function<void(const AppData::Order&)> m_orderCallback;
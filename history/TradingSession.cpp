@@ -0,0 +1,449 @@
+﻿#include "TradingSession.h"
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+
+namespace {
+
+const qint64 kMinutesPerDay = 1440;
+const qint64 kMsecsPerMinute = 60 * 1000LL;
+const qint64 kMsecsPerDay = kMinutesPerDay * kMsecsPerMinute;
+
+// 1970-01-01的儒略日
+const qint64 kEpochJulianDay = 2440588;
+
+// 向下取整的整数除法
+inline qint64 floorDiv(qint64 value, qint64 divisor)
+{
+    qint64 result = value / divisor;
+    if (value < 0 && value % divisor != 0) {
+        --result;
+    }
+    return result;
+}
+
+} // namespace
+
+TradingCalendar::TradingCalendar()
+    : m_weekendsClosed(true)
+{
+}
+
+void TradingCalendar::setWeekendsClosed(bool closed)
+{
+    m_weekendsClosed = closed;
+}
+
+bool TradingCalendar::weekendsClosed() const
+{
+    return m_weekendsClosed;
+}
+
+void TradingCalendar::addHoliday(const QDate &date)
+{
+    if (date.isValid()) {
+        m_holidays.insert(dayNumber(date));
+    }
+}
+
+void TradingCalendar::setHolidays(const QVector<QDate> &dates)
+{
+    m_holidays.clear();
+    for (const QDate &date : dates) {
+        addHoliday(date);
+    }
+}
+
+QVector<QDate> TradingCalendar::holidays() const
+{
+    QVector<qint64> days;
+    days.reserve(m_holidays.size());
+    for (qint64 day : m_holidays) {
+        days.append(day);
+    }
+    std::sort(days.begin(), days.end());
+
+    QVector<QDate> dates;
+    dates.reserve(days.size());
+    for (qint64 day : days) {
+        dates.append(date(day));
+    }
+    return dates;
+}
+
+bool TradingCalendar::loadHolidays(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith("#")) {
+            continue;
+        }
+        addHoliday(QDate::fromString(line, Qt::ISODate));
+    }
+    return true;
+}
+
+bool TradingCalendar::isTradingDay(qint64 day) const
+{
+    if (m_weekendsClosed && weekday(day) >= 5) {
+        return false;
+    }
+    return m_holidays.isEmpty() || !m_holidays.contains(day);
+}
+
+bool TradingCalendar::isTradingDay(const QDate &date) const
+{
+    return isTradingDay(dayNumber(date));
+}
+
+qint64 TradingCalendar::nextTradingDay(qint64 day) const
+{
+    // 节假日是有限的，循环次数有上限
+    do {
+        ++day;
+    } while (!isTradingDay(day));
+    return day;
+}
+
+qint64 TradingCalendar::previousTradingDay(qint64 day) const
+{
+    do {
+        --day;
+    } while (!isTradingDay(day));
+    return day;
+}
+
+int TradingCalendar::weekday(qint64 day)
+{
+    // 1970-01-01是星期四
+    return static_cast<int>(((day % 7) + 7 + 3) % 7);
+}
+
+qint64 TradingCalendar::dayNumber(const QDate &date)
+{
+    return date.toJulianDay() - kEpochJulianDay;
+}
+
+QDate TradingCalendar::date(qint64 day)
+{
+    return QDate::fromJulianDay(day + kEpochJulianDay);
+}
+
+TradingSession::TradingSession()
+    : m_utcOffsetMinutes(0)
+    , m_firstDayMinute(0)
+{
+}
+
+TradingSession::TradingSession(const QVector<Period> &periods,
+                               int utcOffsetMinutes,
+                               const TradingCalendar &calendar)
+    : m_periods(periods)
+    , m_utcOffsetMinutes(utcOffsetMinutes)
+    , m_calendar(calendar)
+    , m_firstDayMinute(0)
+{
+    buildTables();
+}
+
+TradingSession TradingSession::forExchange(AppData::ExchangeType exchange)
+{
+    const int beijing = 8 * 60;
+
+    switch (exchange) {
+    case AppData::SSE:
+    case AppData::SZSE:
+    case AppData::BSE:
+    case AppData::CFFEX:
+        // 9:30-11:30, 13:00-15:00
+        return TradingSession({ Period(570, 690), Period(780, 900) }, beijing);
+    case AppData::SHFE:
+    case AppData::DCE:
+    case AppData::CZCE:
+    case AppData::INE:
+        // 夜盘21:00-23:00，日盘9:00-10:15, 10:30-11:30, 13:30-15:00
+        return TradingSession({ Period(1260, 1380, true),
+                                Period(540, 615), Period(630, 690), Period(810, 900) },
+                              beijing);
+    case AppData::OKX:
+    case AppData::Binance:
+    case AppData::Other:
+    default: {
+        // 全天连续交易，按UTC日期划分交易日
+        TradingCalendar calendar;
+        calendar.setWeekendsClosed(false);
+        return TradingSession({ Period(0, 1440) }, 0, calendar);
+    }
+    }
+}
+
+bool TradingSession::isValid() const
+{
+    return !m_tradingMinutes.isEmpty();
+}
+
+QString TradingSession::signature() const
+{
+    if (!isValid()) {
+        return QString();
+    }
+
+    QStringList periods;
+    for (const Period &period : m_periods) {
+        periods.append(QString("%1-%2%3").arg(period.startMinute).arg(period.endMinute).arg(period.night ? "n" : ""));
+    }
+
+    QStringList holidays;
+    for (const QDate &date : m_calendar.holidays()) {
+        holidays.append(date.toString("yyyyMMdd"));
+    }
+
+    return QString("%1;utc%2;%3;%4")
+        .arg(periods.join(","))
+        .arg(m_utcOffsetMinutes)
+        .arg(m_calendar.weekendsClosed() ? "5d" : "7d")
+        .arg(holidays.join(","));
+}
+
+const QVector<TradingSession::Period> &TradingSession::periods() const
+{
+    return m_periods;
+}
+
+int TradingSession::utcOffsetMinutes() const
+{
+    return m_utcOffsetMinutes;
+}
+
+int TradingSession::tradingMinutes() const
+{
+    return m_tradingMinutes.size();
+}
+
+const TradingCalendar &TradingSession::calendar() const
+{
+    return m_calendar;
+}
+
+TradingCalendar &TradingSession::calendar()
+{
+    return m_calendar;
+}
+
+void TradingSession::setCalendar(const TradingCalendar &calendar)
+{
+    m_calendar = calendar;
+}
+
+void TradingSession::buildTables()
+{
+    m_tradingMinutes.clear();
+    m_clockMinutes = QVector<ClockMinute>(static_cast<int>(kMinutesPerDay));
+
+    // 展开所有交易分钟，并标记本地时间中属于交易时段的分钟
+    QVector<bool> occupied(static_cast<int>(kMinutesPerDay), false);
+    for (const Period &period : m_periods) {
+        for (int minute = period.startMinute; minute < period.endMinute; ++minute) {
+            const int clock = static_cast<int>(((minute % kMinutesPerDay) + kMinutesPerDay) % kMinutesPerDay);
+            if (occupied[clock]) {
+                continue;
+            }
+
+            TradingMinute tradingMinute;
+            tradingMinute.clockMinute = static_cast<qint16>(clock);
+            if (!period.night) {
+                tradingMinute.kind = DayMinute;
+            } else {
+                tradingMinute.kind = minute < kMinutesPerDay ? NightEveningMinute : NightMorningMinute;
+            }
+
+            ClockMinute &entry = m_clockMinutes[clock];
+            entry.tradingMinute = static_cast<qint16>(m_tradingMinutes.size());
+            entry.trading = true;
+            switch (tradingMinute.kind) {
+            case DayMinute:
+                entry.dateShift = 0;
+                entry.nextTradingDay = false;
+                break;
+            case NightEveningMinute:
+                entry.dateShift = 0;
+                entry.nextTradingDay = true;
+                break;
+            default:
+                // 零点后的夜盘归属前一自然日之后的第一个交易日
+                entry.dateShift = -1;
+                entry.nextTradingDay = true;
+                break;
+            }
+
+            occupied[clock] = true;
+            m_tradingMinutes.append(tradingMinute);
+        }
+    }
+
+    if (m_tradingMinutes.isEmpty()) {
+        m_clockMinutes.clear();
+        return;
+    }
+
+    // 夜盘排在日盘之前，第一个日盘分钟的序号即夜盘分钟数
+    m_firstDayMinute = 0;
+    while (m_firstDayMinute < m_tradingMinutes.size()
+           && m_tradingMinutes[m_firstDayMinute].kind != DayMinute) {
+        ++m_firstDayMinute;
+    }
+    if (m_firstDayMinute == m_tradingMinutes.size()) {
+        m_firstDayMinute = 0;
+    }
+
+    // 非交易分钟归入距离最近的交易分钟，距离相同时向前归入
+    for (int clock = 0; clock < kMinutesPerDay; ++clock) {
+        if (occupied[clock]) {
+            continue;
+        }
+
+        int backward = 1;
+        while (!occupied[(clock - backward + kMinutesPerDay) % kMinutesPerDay]) {
+            ++backward;
+        }
+        int forward = 1;
+        while (!occupied[(clock + forward) % kMinutesPerDay]) {
+            ++forward;
+        }
+
+        ClockMinute entry;
+        int dateShift = 0;
+        if (backward <= forward) {
+            const int target = static_cast<int>((clock - backward + kMinutesPerDay) % kMinutesPerDay);
+            entry = m_clockMinutes[target];
+            // 向前跨过零点：目标分钟在前一自然日
+            if (target > clock) {
+                dateShift = -1;
+            }
+        } else {
+            const int target = static_cast<int>((clock + forward) % kMinutesPerDay);
+            entry = m_clockMinutes[target];
+            // 向后跨过零点：目标分钟在后一自然日
+            if (target < clock) {
+                dateShift = 1;
+            }
+        }
+        entry.dateShift = static_cast<qint8>(entry.dateShift + dateShift);
+        entry.trading = false;
+        m_clockMinutes[clock] = entry;
+    }
+}
+
+qint64 TradingSession::locate(qint64 msecs, int &tradingMinute, bool *trading) const
+{
+    const qint64 localMs = msecs + m_utcOffsetMinutes * kMsecsPerMinute;
+    const qint64 localDay = floorDiv(localMs, kMsecsPerDay);
+    const ClockMinute &minute = m_clockMinutes[static_cast<int>((localMs - localDay * kMsecsPerDay) / kMsecsPerMinute)];
+
+    // 日盘归属当日，夜盘归属其开始日期之后的第一个交易日
+    const qint64 day = localDay + minute.dateShift;
+    if (m_calendar.isTradingDay(day)) {
+        tradingMinute = minute.tradingMinute;
+        if (trading) {
+            *trading = minute.trading;
+        }
+        return minute.nextTradingDay ? m_calendar.nextTradingDay(day) : day;
+    }
+
+    // 非交易日的数据（如周末的零星成交回报）并入下一交易日日盘的第一分钟，
+    // 位于上一交易日夜盘之后，保证序号随时间单调
+    tradingMinute = m_firstDayMinute;
+    if (trading) {
+        *trading = false;
+    }
+    return m_calendar.nextTradingDay(day);
+}
+
+qint64 TradingSession::minuteStartMs(qint64 tradingDay, int tradingMinute) const
+{
+    const TradingMinute &minute = m_tradingMinutes[tradingMinute];
+
+    // 夜盘发生在前一交易日的晚上
+    qint64 day = tradingDay;
+    if (minute.kind != DayMinute) {
+        day = m_calendar.previousTradingDay(tradingDay);
+        if (minute.kind == NightMorningMinute) {
+            ++day;
+        }
+    }
+    return day * kMsecsPerDay + minute.clockMinute * kMsecsPerMinute
+           - m_utcOffsetMinutes * kMsecsPerMinute;
+}
+
+bool TradingSession::isTradingTime(qint64 msecs) const
+{
+    if (!isValid()) {
+        return false;
+    }
+
+    int tradingMinute = 0;
+    bool trading = false;
+    locate(msecs, tradingMinute, &trading);
+    return trading;
+}
+
+qint64 TradingSession::tradingDay(qint64 msecs) const
+{
+    if (!isValid()) {
+        return floorDiv(msecs + m_utcOffsetMinutes * kMsecsPerMinute, kMsecsPerDay);
+    }
+
+    int tradingMinute = 0;
+    return locate(msecs, tradingMinute);
+}
+
+qint64 TradingSession::bucketKey(qint64 msecs, int intervalSeconds) const
+{
+    if (!isValid() || intervalSeconds < 60 || intervalSeconds % 60 != 0) {
+        return floorDiv(msecs, intervalSeconds * 1000LL);
+    }
+
+    int tradingMinute = 0;
+    const qint64 day = locate(msecs, tradingMinute);
+
+    const int intervalMinutes = intervalSeconds / 60;
+    if (intervalMinutes == 7 * kMinutesPerDay) {
+        // 周线：交易日所在自然周的星期一
+        return day - TradingCalendar::weekday(day);
+    }
+    if (intervalMinutes >= kMinutesPerDay) {
+        return day;
+    }
+
+    const qint64 bucketsPerDay = (m_tradingMinutes.size() + intervalMinutes - 1) / intervalMinutes;
+    return day * bucketsPerDay + tradingMinute / intervalMinutes;
+}
+
+qint64 TradingSession::bucketStartMs(qint64 key, int intervalSeconds) const
+{
+    if (!isValid() || intervalSeconds < 60 || intervalSeconds % 60 != 0) {
+        return key * intervalSeconds * 1000LL;
+    }
+
+    const int intervalMinutes = intervalSeconds / 60;
+    if (intervalMinutes == 7 * kMinutesPerDay) {
+        // 本周第一个交易日的开盘时间
+        const qint64 day = m_calendar.isTradingDay(key) ? key : m_calendar.nextTradingDay(key);
+        return minuteStartMs(day, 0);
+    }
+    if (intervalMinutes >= kMinutesPerDay) {
+        return minuteStartMs(key, 0);
+    }
+
+    const qint64 bucketsPerDay = (m_tradingMinutes.size() + intervalMinutes - 1) / intervalMinutes;
+    const qint64 day = floorDiv(key, bucketsPerDay);
+    const int firstMinute = static_cast<int>((key - day * bucketsPerDay) * intervalMinutes);
+    return minuteStartMs(day, firstMinute);
+}
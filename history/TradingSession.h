@@ -0,0 +1,202 @@
+﻿#ifndef TRADINGSESSION_H
+#define TRADINGSESSION_H
+
+#include "../AppData.h"
+#include <QDate>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief 交易日历
+ *
+ * 按交易所本地日期判断是否为交易日。日期以1970-01-01起的天数表示，
+ * 便于在K线合成的热点路径中直接做整数运算。
+ */
+class TradingCalendar
+{
+public:
+    TradingCalendar();
+
+    // 周末是否休市（数字货币交易所全年无休）
+    void setWeekendsClosed(bool closed);
+    bool weekendsClosed() const;
+
+    // 添加/设置节假日
+    void addHoliday(const QDate &date);
+    void setHolidays(const QVector<QDate> &dates);
+
+    // 按日期升序排列的节假日
+    QVector<QDate> holidays() const;
+
+    /**
+     * @brief 从文本文件加载节假日，每行一个yyyy-MM-dd日期，#开头的行为注释
+     * @param filePath 文件路径
+     * @return 是否成功
+     */
+    bool loadHolidays(const QString &filePath);
+
+    // 是否为交易日
+    bool isTradingDay(qint64 day) const;
+    bool isTradingDay(const QDate &date) const;
+
+    // 严格晚于/早于day的第一个交易日
+    qint64 nextTradingDay(qint64 day) const;
+    qint64 previousTradingDay(qint64 day) const;
+
+    // 星期几，0表示星期一
+    static int weekday(qint64 day);
+
+    // QDate与天数的换算
+    static qint64 dayNumber(const QDate &date);
+    static QDate date(qint64 day);
+
+private:
+    QSet<qint64> m_holidays;
+    bool m_weekendsClosed;
+};
+
+/**
+ * @brief 交易时段模板
+ *
+ * 描述一个交易日内的各交易时段（含夜盘），并据此把时间戳映射到交易所口径的K线：
+ * 分钟级周期按交易日内的交易分钟数计数（午休不占用分钟），日线按交易日
+ * （夜盘归属下一交易日），周线按交易日所在的自然周。
+ *
+ * 构造时把一天1440个本地分钟预先映射为交易分钟序号和交易日规则，
+ * 因此每个时间戳的计算量为常数。不在交易时段内的时间（集合竞价、收盘后
+ * 的成交回报等）归入距离最近的交易分钟，距离相同时归入之前的分钟。
+ */
+class TradingSession
+{
+public:
+    /**
+     * @brief 交易时段
+     *
+     * 日盘的分钟数以交易日当天0点为起点；夜盘以夜盘开始的自然日0点为起点，
+     * 跨零点的部分超过1440（如次日02:30为1590）
+     */
+    struct Period {
+        int startMinute;    // 开始分钟（包含）
+        int endMinute;      // 结束分钟（不包含）
+        bool night;         // 是否为夜盘（归属下一交易日）
+
+        Period(int start = 0, int end = 0, bool isNight = false)
+            : startMinute(start), endMinute(end), night(isNight) {}
+    };
+
+    // 构造无效的时段，K线按epoch对齐
+    TradingSession();
+
+    /**
+     * @brief 构造交易时段
+     * @param periods 按交易日内顺序排列的交易时段（夜盘在前）
+     * @param utcOffsetMinutes 交易所所在时区相对UTC的分钟数
+     * @param calendar 交易日历
+     */
+    TradingSession(const QVector<Period> &periods,
+                   int utcOffsetMinutes,
+                   const TradingCalendar &calendar = TradingCalendar());
+
+    /**
+     * @brief 获取交易所的默认交易时段
+     *
+     * 期货夜盘按21:00-23:00处理，夜盘更长的品种（如SHFE贵金属、INE原油）
+     * 需自行构造时段。默认日历只包含周末，节假日需通过calendar()加载
+     * @param exchange 交易所
+     * @return 交易时段
+     */
+    static TradingSession forExchange(AppData::ExchangeType exchange);
+
+    bool isValid() const;
+
+    // 交易时段
+    const QVector<Period> &periods() const;
+
+    // 时区偏移(分钟)
+    int utcOffsetMinutes() const;
+
+    // 每个交易日的交易分钟数
+    int tradingMinutes() const;
+
+    // 交易日历
+    const TradingCalendar &calendar() const;
+    TradingCalendar &calendar();
+    void setCalendar(const TradingCalendar &calendar);
+
+    /**
+     * @brief 时段、时区和日历的文本描述，相同描述的时段对齐结果相同，
+     *        可用于区分按不同时段合成的派生数据；无效的时段返回空字符串
+     * @return 描述文本
+     */
+    QString signature() const;
+
+    // 时间戳是否在交易时段内
+    bool isTradingTime(qint64 msecs) const;
+
+    // 时间戳所属的交易日（1970-01-01起的天数）
+    qint64 tradingDay(qint64 msecs) const;
+
+    /**
+     * @brief 时间戳所属K线的序号，随时间单调不减，可用于判断是否进入新的K线
+     *
+     * 周期不足一分钟或不是整分钟时按epoch对齐
+     * @param msecs epoch毫秒
+     * @param intervalSeconds 周期秒数（86400为日线，604800为周线）
+     * @return K线序号
+     */
+    qint64 bucketKey(qint64 msecs, int intervalSeconds) const;
+
+    /**
+     * @brief K线序号对应的起始时间，即K线内第一个交易分钟的开始时间
+     * @param key bucketKey()返回的序号
+     * @param intervalSeconds 周期秒数
+     * @return epoch毫秒
+     */
+    qint64 bucketStartMs(qint64 key, int intervalSeconds) const;
+
+private:
+    // 交易分钟所在的部分
+    enum MinuteKind {
+        DayMinute,              // 日盘
+        NightEveningMinute,     // 夜盘零点前
+        NightMorningMinute      // 夜盘零点后
+    };
+
+    // 交易日内的一个交易分钟
+    struct TradingMinute {
+        qint16 clockMinute;     // 本地时间自0点起的分钟数
+        qint8 kind;             // MinuteKind
+    };
+
+    // 一天中一个本地分钟的映射
+    struct ClockMinute {
+        qint16 tradingMinute;   // 所属交易分钟的序号
+        qint8 dateShift;        // 交易日 = (nextTradingDay ? 下一交易日 : 当日)(本地日期 + dateShift)
+        bool nextTradingDay;
+        bool trading;           // 是否在交易时段内
+    };
+
+    void buildTables();
+
+    /**
+     * @brief 定位时间戳所属的交易日和交易分钟
+     * @param msecs epoch毫秒
+     * @param tradingMinute 输出的交易分钟序号
+     * @param trading 输出是否在交易时段内，可为空
+     * @return 交易日（1970-01-01起的天数）
+     */
+    qint64 locate(qint64 msecs, int &tradingMinute, bool *trading = nullptr) const;
+
+    // 交易日内第tradingMinute个交易分钟的开始时间(epoch毫秒)
+    qint64 minuteStartMs(qint64 tradingDay, int tradingMinute) const;
+
+    QVector<Period> m_periods;
+    int m_utcOffsetMinutes;
+    TradingCalendar m_calendar;
+    QVector<TradingMinute> m_tradingMinutes;
+    QVector<ClockMinute> m_clockMinutes;    // 1440项
+    int m_firstDayMinute;                   // 第一个日盘交易分钟的序号
+};
+
+#endif // TRADINGSESSION_H
@@ -0,0 +1,85 @@
+﻿#include "ATR.h"
+#include <cmath>
+#include "IndicatorKernels.h"
+#include "../AppData.h"
+
+ATR::ATR(int period, QObject *parent)
+    : IndicatorBase(AppData::ATR, parent),
+      m_period(qMax(1, period)),
+      m_barCount(0),
+      m_prevClose(0.0),
+      m_atr(0.0)
+{
+    addSeries(&m_values);
+}
+
+void ATR::calculate(const QVector<AppData::MarketData> &data)
+{
+    m_values.clear();
+    m_barCount = 0;
+    m_prevClose = 0.0;
+    m_atr = 0.0;
+    
+    if (data.size() < m_period) {
+        for (const auto &bar : data) {
+            append(bar);
+        }
+        return;
+    }
+    
+    // 整段计算交给批量内核，结果去掉预热期
+    const QVector<double> highs = highPrices(data);
+    const QVector<double> lows = lowPrices(data);
+    const QVector<double> closes = closePrices(data);
+    QVector<double> buffer(data.size());
+    IndicatorKernels::atr(highs.constData(), lows.constData(), closes.constData(),
+                          data.size(), m_period, buffer.data());
+    m_values.assign(buffer.constData() + m_period - 1, buffer.size() - m_period + 1);
+    
+    m_barCount = data.size();
+    m_prevClose = closes.last();
+    m_atr = buffer.last();
+    emit indicatorUpdated();
+}
+
+void ATR::update(const AppData::MarketData &newData)
+{
+    append(newData);
+    emit indicatorUpdated();
+}
+
+void ATR::append(const AppData::MarketData &bar)
+{
+    // 与IndicatorKernels::atr的运算顺序相同，第一根没有昨收，取最高价减最低价
+    double trueRange = bar.high - bar.low;
+    if (m_barCount > 0) {
+        trueRange = qMax(trueRange, qMax(std::fabs(bar.high - m_prevClose), std::fabs(bar.low - m_prevClose)));
+    }
+    m_prevClose = bar.close;
+    
+    if (++m_barCount <= m_period) {
+        m_atr += trueRange;
+        if (m_barCount < m_period) {
+            return;
+        }
+        m_atr /= m_period;
+    } else {
+        m_atr = IndicatorKernels::wilderStep(m_atr, trueRange, m_period);
+    }
+    m_values.append(m_atr);
+}
+
+QString ATR::name() const
+{
+    return QString("ATR(%1)").arg(m_period);
+}
+
+SeriesView ATR::values() const
+{
+    return m_values.view();
+}
+
+double ATR::lastValue() const
+{
+    return m_values.isEmpty() ? 0.0 : m_values.last();
+}
@@ -0,0 +1,39 @@
+﻿#ifndef ATR_H
+#define ATR_H
+
+#include "IndicatorBase.h"
+
+// 平均真实波幅：首个值为前period个真实波幅的平均，之后按Wilder平滑
+class ATR : public IndicatorBase
+{
+    Q_OBJECT
+public:
+    explicit ATR(int period = 14, QObject *parent = nullptr);
+    
+    // 计算指标值
+    void calculate(const QVector<AppData::MarketData> &data) override;
+    
+    // 实时更新指标
+    void update(const AppData::MarketData &newData) override;
+    
+    // 获取指标名称
+    QString name() const override;
+    
+    // 获取计算结果
+    SeriesView values() const override;
+    
+    // 获取最新值
+    double lastValue() const override;
+
+private:
+    // 并入一根K线，前period根只累计真实波幅
+    void append(const AppData::MarketData &bar);
+
+    int m_period;
+    IndicatorSeries m_values;
+    int m_barCount;
+    double m_prevClose;
+    double m_atr;               // 前period根期间为真实波幅之和
+};
+
+#endif // ATR_H
@@ -1,12 +1,16 @@
 ﻿#include "BollingerBands.h"
-#include <cmath>
+#include "IndicatorKernels.h"
 #include "../AppData.h"
 
 BollingerBands::BollingerBands(int period, double multiplier, QObject *parent)
     : IndicatorBase(AppData::BOLL, parent),
       m_period(period), 
-      m_multiplier(multiplier)
+      m_multiplier(multiplier),
+      m_window(period)
 {
+    addSeries(&m_upperBand);
+    addSeries(&m_middleBand);
+    addSeries(&m_lowerBand);
 }
 
 void BollingerBands::calculate(const QVector<AppData::MarketData> &data)
@@ -14,48 +18,62 @@ void BollingerBands::calculate(const QVector<AppData::MarketData> &data)
     m_upperBand.clear();
     m_middleBand.clear();
     m_lowerBand.clear();
+    m_window.reset();
     
-    if (data.size() < m_period) return;
-    
-    for (int i = m_period - 1; i < data.size(); ++i) {
-        // 计算中轨(简单移动平均)
-        double sum = 0.0;
-        for (int j = 0; j < m_period; ++j) {
-            sum += data[i - j].close;
-        }
-        double middle = sum / m_period;
-        m_middleBand.append(middle);
-        
-        // 计算标准差
-        double variance = 0.0;
-        for (int j = 0; j < m_period; ++j) {
-            variance += std::pow(data[i - j].close - middle, 2);
+    const QVector<double> closes = closePrices(data);
+    if (closes.size() < m_period) {
+        for (double close : closes) {
+            m_window.push(close);
         }
-        double stddev = std::sqrt(variance / m_period);
-        
-        // 计算上下轨
-        m_upperBand.append(middle + m_multiplier * stddev);
-        m_lowerBand.append(middle - m_multiplier * stddev);
+        return;
     }
     
+    // 整段计算交给批量内核，结果去掉窗口未满的部分
+    QVector<double> upper(closes.size());
+    QVector<double> middle(closes.size());
+    QVector<double> lower(closes.size());
+    IndicatorKernels::bollinger(closes.constData(), closes.size(), m_period, m_multiplier,
+                                middle.data(), upper.data(), lower.data());
+    const int count = closes.size() - m_period + 1;
+    m_upperBand.assign(upper.constData() + m_period - 1, count);
+    m_middleBand.assign(middle.constData() + m_period - 1, count);
+    m_lowerBand.assign(lower.constData() + m_period - 1, count);
+
+    // 恢复滑动窗口的状态，之后的实时更新与整段重新计算逐位一致
+    m_window.restore(closes.constData(), closes.size());
+    
     emit indicatorUpdated();
 }
 
 void BollingerBands::update(const AppData::MarketData &newData)
 {
-    // 需要维护一个数据窗口来实时更新布林带
-    // 实际实现中需要保存足够的历史数据
+    append(newData.close);
     emit indicatorUpdated();
 }
 
+void BollingerBands::append(double close)
+{
+    m_window.push(close);
+    if (!m_window.isFull()) {
+        return;
+    }
+    
+    // 中轨为简单移动平均，上下轨为中轨加减若干倍总体标准差
+    const double middle = m_window.mean();
+    const double stddev = m_window.stddev();
+    m_middleBand.append(middle);
+    m_upperBand.append(middle + m_multiplier * stddev);
+    m_lowerBand.append(middle - m_multiplier * stddev);
+}
+
 QString BollingerBands::name() const
 {
     return QString("BollingerBands(%1,%2)").arg(m_period).arg(m_multiplier);
 }
 
-QVector<double> BollingerBands::values() const
+SeriesView BollingerBands::values() const
 {
-    return m_middleBand; // 默认返回中轨值
+    return m_middleBand.view(); // 默认返回中轨值
 }
 
 double BollingerBands::lastValue() const
@@ -63,17 +81,17 @@ double BollingerBands::lastValue() const
     return m_middleBand.isEmpty() ? 0.0 : m_middleBand.last();
 }
 
-QVector<double> BollingerBands::upperBand() const
+SeriesView BollingerBands::upperBand() const
 {
-    return m_upperBand;
+    return m_upperBand.view();
 }
 
-QVector<double> BollingerBands::middleBand() const
+SeriesView BollingerBands::middleBand() const
 {
-    return m_middleBand;
+    return m_middleBand.view();
 }
 
-QVector<double> BollingerBands::lowerBand() const
+SeriesView BollingerBands::lowerBand() const
 {
-    return m_lowerBand;
+    return m_lowerBand.view();
 }
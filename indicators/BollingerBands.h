@@ -2,6 +2,7 @@
 #define BOLLINGERBANDS_H
 
 #include "IndicatorBase.h"
+#include "RollingWindow.h"
 
 class BollingerBands : public IndicatorBase
 {
@@ -19,26 +20,30 @@ public:
     QString name() const override;
     
     // 获取计算结果
-    QVector<double> values() const override;
+    SeriesView values() const override;
     
     // 获取最新值
     double lastValue() const override;
 
     // 获取上轨线
-    QVector<double> upperBand() const;
+    SeriesView upperBand() const;
     
     // 获取中轨线
-    QVector<double> middleBand() const;
+    SeriesView middleBand() const;
     
     // 获取下轨线
-    QVector<double> lowerBand() const;
+    SeriesView lowerBand() const;
 
 private:
+    // 并入一根K线的收盘价，窗口满后才产生指标值
+    void append(double close);
+
     int m_period;
     double m_multiplier;
-    QVector<double> m_upperBand;
-    QVector<double> m_middleBand;
-    QVector<double> m_lowerBand;
+    RollingWindow m_window;
+    IndicatorSeries m_upperBand;
+    IndicatorSeries m_middleBand;
+    IndicatorSeries m_lowerBand;
 };
 
 #endif // BOLLINGERBANDS_H
\ No newline at end of file
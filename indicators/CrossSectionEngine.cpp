@@ -0,0 +1,541 @@
+﻿#include "CrossSectionEngine.h"
+#include "IndicatorKernels.h"
+#include <QFuture>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+// 每个并行任务处理的品种数
+const int kSymbolsPerBlock = 512;
+
+} // namespace
+
+CrossSectionEngine::Study::Study()
+    : kind(SmaStudy), period(1), slowPeriod(1), signalPeriod(1), multiplier(0.0)
+{
+}
+
+CrossSectionEngine::CrossSectionEngine(const QStringList &symbols, QObject *parent)
+    : QObject(parent), m_symbols(symbols), m_closes(symbols.size()), m_traded(symbols.size(), 0),
+      m_barCount(0), m_maxLookback(0), m_threadCount(0)
+{
+    for (int i = 0; i < m_symbols.size(); ++i) {
+        m_symbolIndex.insert(m_symbols[i], i);
+    }
+}
+
+CrossSectionEngine::~CrossSectionEngine()
+{
+}
+
+int CrossSectionEngine::symbolCount() const
+{
+    return m_symbols.size();
+}
+
+QStringList CrossSectionEngine::symbols() const
+{
+    return m_symbols;
+}
+
+int CrossSectionEngine::symbolIndex(const QString &symbol) const
+{
+    return m_symbolIndex.value(symbol, -1);
+}
+
+void CrossSectionEngine::setMaxLookback(int bars)
+{
+    m_maxLookback = qMax(0, bars);
+    for (auto &closes : m_closes) {
+        closes.setMaxLookback(m_maxLookback);
+    }
+    for (auto &field : m_fields) {
+        for (auto &series : field.series) {
+            series.setMaxLookback(m_maxLookback);
+        }
+    }
+}
+
+int CrossSectionEngine::maxLookback() const
+{
+    return m_maxLookback;
+}
+
+void CrossSectionEngine::setThreadCount(int threadCount)
+{
+    m_threadCount = qMax(0, threadCount);
+    if (m_threadCount > 0) {
+        m_threadPool.setMaxThreadCount(m_threadCount);
+    }
+}
+
+int CrossSectionEngine::sma(int period)
+{
+    Study study;
+    study.kind = SmaStudy;
+    study.period = qMax(1, period);
+    return addStudy(study, QString("SMA(%1)").arg(study.period), QStringList());
+}
+
+int CrossSectionEngine::ema(int period)
+{
+    Study study;
+    study.kind = EmaStudy;
+    study.period = qMax(1, period);
+    return addStudy(study, QString("EMA(%1)").arg(study.period), QStringList());
+}
+
+int CrossSectionEngine::rsi(int period)
+{
+    Study study;
+    study.kind = RsiStudy;
+    study.period = qMax(1, period);
+    return addStudy(study, QString("RSI(%1)").arg(study.period), QStringList());
+}
+
+CrossSectionEngine::MacdFields CrossSectionEngine::macd(int fastPeriod, int slowPeriod, int signalPeriod)
+{
+    Study study;
+    study.kind = MacdStudy;
+    study.period = fastPeriod;
+    study.slowPeriod = slowPeriod;
+    study.signalPeriod = signalPeriod;
+    const int first = addStudy(study, QString("MACD(%1,%2,%3)").arg(fastPeriod).arg(slowPeriod).arg(signalPeriod),
+                               QStringList() << "DIF" << "DEA" << "HIST");
+    return MacdFields{first, first + 1, first + 2};
+}
+
+CrossSectionEngine::BandFields CrossSectionEngine::bollinger(int period, double multiplier)
+{
+    Study study;
+    study.kind = BollingerStudy;
+    study.period = qMax(1, period);
+    study.multiplier = multiplier;
+    const int first = addStudy(study, QString("BOLL(%1,%2)").arg(study.period).arg(multiplier),
+                               QStringList() << "MIDDLE" << "UPPER" << "LOWER");
+    return BandFields{first, first + 1, first + 2};
+}
+
+int CrossSectionEngine::addStudy(Study study, const QString &name, const QStringList &outputs)
+{
+    const auto existing = m_studyIndex.constFind(name);
+    if (existing != m_studyIndex.constEnd()) {
+        return m_studies[existing.value()].fields.first();
+    }
+
+    const int symbolCount = m_symbols.size();
+    const int studyIndex = m_studies.size();
+    study.count.fill(0, symbolCount);
+    study.stateA.fill(0.0, symbolCount);
+    study.stateB.fill(0.0, symbolCount);
+    study.stateC.fill(0.0, symbolCount);
+    if (study.kind == SmaStudy || study.kind == BollingerStudy) {
+        study.windows.fill(RollingWindow(study.period), symbolCount);
+    }
+
+    // 单输出的指标字段名即指标名，多输出的为“指标名.输出名”
+    const QStringList names = outputs.isEmpty() ? QStringList(name) : outputs;
+    for (const QString &output : names) {
+        Field field;
+        field.name = outputs.isEmpty() ? name : name + "." + output;
+        field.study = studyIndex;
+        field.series.fill(IndicatorSeries(m_maxLookback), symbolCount);
+        study.fields.append(m_fields.size());
+        m_fieldIndex.insert(field.name, m_fields.size());
+        m_fields.append(field);
+    }
+
+    m_studies.append(study);
+    m_studyIndex.insert(name, studyIndex);
+
+    // 已有K线时按保存的收盘价补算
+    if (m_barCount > 0) {
+        Study &added = m_studies[studyIndex];
+        forEachBlock([this, &added](int begin, int end) {
+            for (int symbol = begin; symbol < end; ++symbol) {
+                const SeriesView closes = m_closes[symbol].view();
+                calculateStudy(added, symbol, closes.data(), closes.size());
+            }
+        });
+    }
+
+    return m_studies[studyIndex].fields.first();
+}
+
+int CrossSectionEngine::fieldCount() const
+{
+    return m_fields.size();
+}
+
+QString CrossSectionEngine::fieldName(int field) const
+{
+    return isValidField(field) ? m_fields[field].name : QString();
+}
+
+int CrossSectionEngine::findField(const QString &name) const
+{
+    return m_fieldIndex.value(name, -1);
+}
+
+void CrossSectionEngine::calculate(const QVector<double> &closes, int barCount)
+{
+    reset();
+
+    const int symbolCount = m_symbols.size();
+    if (barCount <= 0 || closes.size() < symbolCount * barCount) {
+        return;
+    }
+
+    forEachBlock([this, &closes, barCount](int begin, int end) {
+        QVector<double> traded;
+        traded.reserve(barCount);
+        for (int symbol = begin; symbol < end; ++symbol) {
+            // 去掉停牌的K线，得到该品种连续的收盘价序列
+            const double *row = closes.constData() + static_cast<qint64>(symbol) * barCount;
+            traded.clear();
+            for (int i = 0; i < barCount; ++i) {
+                if (!std::isnan(row[i])) {
+                    traded.append(row[i]);
+                }
+            }
+
+            for (auto &study : m_studies) {
+                calculateStudy(study, symbol, traded.constData(), traded.size());
+            }
+            m_closes[symbol].assign(traded.constData(), traded.size());
+            m_traded[symbol] = !std::isnan(row[barCount - 1]);
+        }
+    });
+    m_barCount = barCount;
+
+    emit updated();
+}
+
+void CrossSectionEngine::update(const QVector<double> &closes)
+{
+    if (closes.size() < m_symbols.size()) {
+        return;
+    }
+
+    forEachBlock([this, &closes](int begin, int end) {
+        for (int symbol = begin; symbol < end; ++symbol) {
+            const double close = closes[symbol];
+            const bool traded = !std::isnan(close);
+            m_traded[symbol] = traded;
+            if (!traded) {
+                continue;
+            }
+            m_closes[symbol].append(close);
+            for (auto &study : m_studies) {
+                appendStudy(study, symbol, close);
+            }
+        }
+    });
+    ++m_barCount;
+
+    emit updated();
+}
+
+void CrossSectionEngine::reset()
+{
+    for (auto &closes : m_closes) {
+        closes.clear();
+    }
+    for (auto &field : m_fields) {
+        for (auto &series : field.series) {
+            series.clear();
+        }
+    }
+    for (auto &study : m_studies) {
+        study.count.fill(0);
+        study.stateA.fill(0.0);
+        study.stateB.fill(0.0);
+        study.stateC.fill(0.0);
+        for (auto &window : study.windows) {
+            window.reset();
+        }
+    }
+    m_traded.fill(0);
+    m_barCount = 0;
+}
+
+void CrossSectionEngine::calculateStudy(Study &study, int symbol, const double *closes, int count)
+{
+    IndicatorSeries *outputs[3] = {};
+    for (int i = 0; i < study.fields.size(); ++i) {
+        outputs[i] = &m_fields[study.fields[i]].series[symbol];
+        outputs[i]->clear();
+    }
+    study.count[symbol] = 0;
+    study.stateA[symbol] = 0.0;
+    study.stateB[symbol] = 0.0;
+    study.stateC[symbol] = 0.0;
+    if (!study.windows.isEmpty()) {
+        study.windows[symbol].reset();
+    }
+
+    // 批量内核的输出从第一个有效值开始存入序列，随后恢复递推状态，之后的update()与整段计算逐位一致
+    const int period = study.period;
+    switch (study.kind) {
+    case SmaStudy:
+        if (count >= period) {
+            QVector<double> buffer(count);
+            IndicatorKernels::sma(closes, count, period, buffer.data());
+            outputs[0]->assign(buffer.constData() + period - 1, count - period + 1);
+            study.windows[symbol].restore(closes, count);
+            study.count[symbol] = count;
+            return;
+        }
+        break;
+    case EmaStudy:
+        if (count > 0) {
+            QVector<double> buffer(count);
+            IndicatorKernels::ema(closes, count, period, buffer.data());
+            outputs[0]->assign(buffer.constData(), count);
+            study.stateA[symbol] = buffer.last();
+            study.count[symbol] = count;
+            return;
+        }
+        break;
+    case RsiStudy:
+        if (count > period) {
+            QVector<double> buffer(count);
+            IndicatorKernels::rsi(closes, count, period, buffer.data(),
+                                  &study.stateA[symbol], &study.stateB[symbol]);
+            outputs[0]->assign(buffer.constData() + period, count - period);
+            study.stateC[symbol] = closes[count - 1];
+            study.count[symbol] = count;
+            return;
+        }
+        break;
+    case MacdStudy:
+        if (count > 0) {
+            QVector<double> buffer(count * 3);
+            double *dif = buffer.data();
+            double *dea = dif + count;
+            double *hist = dea + count;
+            IndicatorKernels::macd(closes, count, study.period, study.slowPeriod, study.signalPeriod,
+                                   dif, dea, hist, &study.stateA[symbol], &study.stateB[symbol]);
+            outputs[0]->assign(dif, count);
+            outputs[1]->assign(dea, count);
+            outputs[2]->assign(hist, count);
+            study.stateC[symbol] = dea[count - 1];
+            study.count[symbol] = count;
+            return;
+        }
+        break;
+    case BollingerStudy:
+        if (count >= period) {
+            QVector<double> buffer(count * 3);
+            double *middle = buffer.data();
+            double *upper = middle + count;
+            double *lower = upper + count;
+            IndicatorKernels::bollinger(closes, count, period, study.multiplier, middle, upper, lower);
+            const int warmup = period - 1;
+            outputs[0]->assign(middle + warmup, count - warmup);
+            outputs[1]->assign(upper + warmup, count - warmup);
+            outputs[2]->assign(lower + warmup, count - warmup);
+            study.windows[symbol].restore(closes, count);
+            study.count[symbol] = count;
+            return;
+        }
+        break;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        appendStudy(study, symbol, closes[i]);
+    }
+}
+
+void CrossSectionEngine::appendStudy(Study &study, int symbol, double close)
+{
+    const int count = ++study.count[symbol];
+    const int period = study.period;
+    IndicatorSeries &first = m_fields[study.fields.first()].series[symbol];
+
+    switch (study.kind) {
+    case SmaStudy: {
+        RollingWindow &window = study.windows[symbol];
+        window.push(close);
+        if (window.isFull()) {
+            first.append(window.mean());
+        }
+        break;
+    }
+    case EmaStudy: {
+        double &ema = study.stateA[symbol];
+        ema = count == 1 ? close : IndicatorKernels::emaStep(ema, close, IndicatorKernels::emaMultiplier(period));
+        first.append(ema);
+        break;
+    }
+    case RsiStudy: {
+        double &avgGain = study.stateA[symbol];
+        double &avgLoss = study.stateB[symbol];
+        double &lastClose = study.stateC[symbol];
+        if (count == 1) {
+            lastClose = close;
+            break;
+        }
+
+        const double change = close - lastClose;
+        const int changes = count - 1;
+        lastClose = close;
+        if (changes <= period) {
+            // 第period个涨跌额到来时由和得到初始平均涨跌幅
+            if (change > 0) {
+                avgGain += change;
+            } else {
+                avgLoss -= change;
+            }
+            if (changes < period) {
+                break;
+            }
+            avgGain /= period;
+            avgLoss /= period;
+        } else {
+            avgGain = IndicatorKernels::wilderStep(avgGain, change > 0 ? change : 0.0, period);
+            avgLoss = IndicatorKernels::wilderStep(avgLoss, change < 0 ? -change : 0.0, period);
+        }
+        first.append(IndicatorKernels::rsiValue(avgGain, avgLoss));
+        break;
+    }
+    case MacdStudy: {
+        double &emaFast = study.stateA[symbol];
+        double &emaSlow = study.stateB[symbol];
+        double &dea = study.stateC[symbol];
+        if (count == 1) {
+            emaFast = close;
+            emaSlow = close;
+        } else {
+            emaFast = IndicatorKernels::emaStep(emaFast, close, IndicatorKernels::emaMultiplier(study.period));
+            emaSlow = IndicatorKernels::emaStep(emaSlow, close, IndicatorKernels::emaMultiplier(study.slowPeriod));
+        }
+
+        const double dif = emaFast - emaSlow;
+        dea = count == 1
+            ? dif
+            : IndicatorKernels::emaStep(dea, dif, IndicatorKernels::emaMultiplier(study.signalPeriod));
+        first.append(dif);
+        m_fields[study.fields[1]].series[symbol].append(dea);
+        m_fields[study.fields[2]].series[symbol].append(dif - dea);
+        break;
+    }
+    case BollingerStudy: {
+        RollingWindow &window = study.windows[symbol];
+        window.push(close);
+        if (!window.isFull()) {
+            break;
+        }
+        const double middle = window.mean();
+        const double stddev = window.stddev();
+        first.append(middle);
+        m_fields[study.fields[1]].series[symbol].append(middle + study.multiplier * stddev);
+        m_fields[study.fields[2]].series[symbol].append(middle - study.multiplier * stddev);
+        break;
+    }
+    }
+}
+
+template <typename Function>
+void CrossSectionEngine::forEachBlock(Function function)
+{
+    const int symbolCount = m_symbols.size();
+    if (symbolCount <= kSymbolsPerBlock) {
+        function(0, symbolCount);
+        return;
+    }
+
+    // 各块只写入自己品种的状态和序列，块之间没有共享的可写数据
+    QThreadPool *pool = m_threadCount > 0 ? &m_threadPool : QThreadPool::globalInstance();
+    QVector<QFuture<void>> futures;
+    futures.reserve((symbolCount + kSymbolsPerBlock - 1) / kSymbolsPerBlock);
+    for (int begin = 0; begin < symbolCount; begin += kSymbolsPerBlock) {
+        const int end = qMin(begin + kSymbolsPerBlock, symbolCount);
+        futures.append(QtConcurrent::run(pool, [&function, begin, end]() {
+            function(begin, end);
+        }));
+    }
+    for (auto &future : futures) {
+        future.waitForFinished();
+    }
+}
+
+int CrossSectionEngine::barCount() const
+{
+    return m_barCount;
+}
+
+bool CrossSectionEngine::isTraded(int symbol) const
+{
+    return symbol >= 0 && symbol < m_traded.size() && m_traded[symbol];
+}
+
+SeriesView CrossSectionEngine::series(int field, int symbol) const
+{
+    if (!isValidField(field) || symbol < 0 || symbol >= m_symbols.size()) {
+        return SeriesView();
+    }
+    return m_fields[field].series[symbol].view();
+}
+
+SeriesView CrossSectionEngine::series(int field, const QString &symbol) const
+{
+    return series(field, symbolIndex(symbol));
+}
+
+double CrossSectionEngine::value(int field, int symbol, int barsAgo) const
+{
+    return series(field, symbol).value(barsAgo);
+}
+
+QVector<double> CrossSectionEngine::crossSection(int field) const
+{
+    QVector<double> values(m_symbols.size(), kNaN);
+    if (!isValidField(field)) {
+        return values;
+    }
+    const QVector<IndicatorSeries> &series = m_fields[field].series;
+    for (int symbol = 0; symbol < m_symbols.size(); ++symbol) {
+        if (m_traded[symbol] && !series[symbol].isEmpty()) {
+            values[symbol] = series[symbol].last();
+        }
+    }
+    return values;
+}
+
+QVector<CrossSectionEngine::RankedSymbol> CrossSectionEngine::rank(int field, Qt::SortOrder order, int top) const
+{
+    QVector<RankedSymbol> ranked;
+    const QVector<double> values = crossSection(field);
+    ranked.reserve(values.size());
+    for (int symbol = 0; symbol < values.size(); ++symbol) {
+        if (!std::isnan(values[symbol])) {
+            ranked.append(RankedSymbol{symbol, m_symbols[symbol], values[symbol]});
+        }
+    }
+
+    // 值相同时按品种编号排序，结果与线程数无关
+    auto before = [order](const RankedSymbol &a, const RankedSymbol &b) {
+        if (a.value != b.value) {
+            return order == Qt::DescendingOrder ? a.value > b.value : a.value < b.value;
+        }
+        return a.symbolIndex < b.symbolIndex;
+    };
+    if (top > 0 && top < ranked.size()) {
+        std::partial_sort(ranked.begin(), ranked.begin() + top, ranked.end(), before);
+        ranked.resize(top);
+    } else {
+        std::sort(ranked.begin(), ranked.end(), before);
+    }
+    return ranked;
+}
+
+bool CrossSectionEngine::isValidField(int field) const
+{
+    return field >= 0 && field < m_fields.size();
+}
@@ -0,0 +1,194 @@
+﻿#ifndef CROSSSECTIONENGINE_H
+#define CROSSSECTIONENGINE_H
+
+#include <QObject>
+#include <QHash>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include "IndicatorSeries.h"
+#include "RollingWindow.h"
+
+/**
+ * @brief 截面（多品种）指标引擎
+ *
+ * 为一组品种（如全部A股）同时计算相同的指标，替代每个品种、每个指标各一个IndicatorBase
+ * 对象的做法：没有逐对象的信号发送，所有品种的结果在一次计算中得到。
+ *
+ *   - 收盘价按品种×时间的矩阵保存，每个品种的序列在内存中连续；
+ *   - calculate()对每个品种调用IndicatorKernels的批量内核（按指令集向量化），
+ *     各品种按块分配到线程池并行计算；
+ *   - update()追加一根截面K线，各指标的递推状态按品种连续存放，每个品种O(1)，
+ *     品种数较多时同样按块并行；
+ *   - 单个品种的结果以SeriesView提供给策略，最新截面可按指标值排序供选股使用。
+ *
+ * 收盘价为NaN表示该品种在这根K线上没有成交（停牌），该品种的序列和递推状态都不推进，
+ * 与只用该品种自己的K线驱动一个指标对象的结果逐位一致；calculate()与逐根update()的结果也逐位一致。
+ *
+ * 各指标的输出以“字段”编号访问，同名字段只创建一次。在已有K线之后加入的指标按保存的
+ * 收盘价补算；设置了最大回看长度时只能从保留的收盘价开始补算。
+ */
+class CrossSectionEngine : public QObject
+{
+    Q_OBJECT
+public:
+    // MACD的三个输出字段
+    struct MacdFields {
+        int dif;
+        int dea;
+        int hist;
+    };
+
+    // 布林带的三个输出字段
+    struct BandFields {
+        int middle;
+        int upper;
+        int lower;
+    };
+
+    // 排序后的截面中的一项
+    struct RankedSymbol {
+        int symbolIndex;
+        QString symbol;
+        double value;
+    };
+
+    explicit CrossSectionEngine(const QStringList &symbols, QObject *parent = nullptr);
+    ~CrossSectionEngine() override;
+
+    // 品种
+    int symbolCount() const;
+    QStringList symbols() const;
+
+    // 品种编号，不存在时返回-1
+    int symbolIndex(const QString &symbol) const;
+
+    // 设置最大回看长度，收盘价和所有字段只保留最近bars个值；0表示不限长度（默认）
+    void setMaxLookback(int bars);
+    int maxLookback() const;
+
+    // 并行计算使用的线程数，0表示使用全局线程池（默认）
+    void setThreadCount(int threadCount);
+
+    // 以下函数加入指标并返回字段编号，名称相同的指标返回已有的字段
+    int sma(int period);
+    int ema(int period);
+    int rsi(int period = 14);
+    MacdFields macd(int fastPeriod = 12, int slowPeriod = 26, int signalPeriod = 9);
+    BandFields bollinger(int period = 20, double multiplier = 2.0);
+
+    // 字段数
+    int fieldCount() const;
+
+    // 字段名称，如"RSI(14)"、"MACD(12,26,9).DEA"
+    QString fieldName(int field) const;
+
+    // 按名称查找字段，不存在时返回-1
+    int findField(const QString &name) const;
+
+    /**
+     * @brief 清空后按收盘价矩阵整段计算
+     * @param closes 按品种连续存放的收盘价，第s个品种的第t根K线为closes[s * barCount + t]，NaN表示停牌
+     * @param barCount 每个品种的K线数
+     */
+    void calculate(const QVector<double> &closes, int barCount);
+
+    // 追加一根截面K线，closes按品种编号排列，NaN表示停牌
+    void update(const QVector<double> &closes);
+
+    // 清空收盘价和所有字段，指标保留
+    void reset();
+
+    // 已追加的截面K线数
+    int barCount() const;
+
+    // 品种在最新一根截面K线上是否有成交
+    bool isTraded(int symbol) const;
+
+    // 品种的字段序列（只读视图，下一次计算或更新前有效），只包含有成交的K线
+    SeriesView series(int field, int symbol) const;
+    SeriesView series(int field, const QString &symbol) const;
+
+    // 品种的字段在n根有成交的K线之前的值，0为最新值，没有值时为NaN
+    double value(int field, int symbol, int barsAgo = 0) const;
+
+    // 最新截面：每个品种的字段最新值，停牌或尚无值的品种为NaN
+    QVector<double> crossSection(int field) const;
+
+    /**
+     * @brief 按字段最新值排序的截面，用于选股
+     *
+     * 只包含最新一根K线有成交且字段有值的品种。
+     * @param order 默认从大到小
+     * @param top 只取前top个，0表示全部
+     */
+    QVector<RankedSymbol> rank(int field, Qt::SortOrder order = Qt::DescendingOrder, int top = 0) const;
+
+signals:
+    // 一次整段计算或一根截面K线的所有字段计算完成
+    void updated();
+
+private:
+    enum StudyKind {
+        SmaStudy,
+        EmaStudy,
+        RsiStudy,
+        MacdStudy,
+        BollingerStudy
+    };
+
+    // 一个指标在所有品种上的参数、递推状态和输出字段
+    struct Study {
+        StudyKind kind;
+        int period;
+        int slowPeriod;
+        int signalPeriod;
+        double multiplier;
+        QVector<int> fields;
+
+        // 每个品种一项的递推状态
+        QVector<int> count;             // 已并入的收盘价个数
+        QVector<double> stateA;         // EMA值、平均涨幅或快线EMA
+        QVector<double> stateB;         // 平均跌幅或慢线EMA
+        QVector<double> stateC;         // 上一根收盘价（RSI）或DEA
+        QVector<RollingWindow> windows; // SMA/布林带窗口
+
+        Study();
+    };
+
+    struct Field {
+        QString name;
+        int study;
+        QVector<IndicatorSeries> series;    // 每个品种一个序列
+    };
+
+    // 加入指标并创建outputs个字段，名称相同时返回已有指标的编号
+    int addStudy(Study study, const QString &name, const QStringList &outputs);
+
+    // 清空一个指标在品种上的状态和输出，再按该品种有成交的收盘价closes[0..count)整段计算
+    void calculateStudy(Study &study, int symbol, const double *closes, int count);
+
+    // 一个指标并入品种的一根收盘价
+    void appendStudy(Study &study, int symbol, double close);
+
+    // 把品种按块分配到线程池执行function(begin, end)，只有一块时在当前线程执行
+    template <typename Function>
+    void forEachBlock(Function function);
+
+    bool isValidField(int field) const;
+
+    QStringList m_symbols;
+    QHash<QString, int> m_symbolIndex;
+    QVector<Study> m_studies;
+    QHash<QString, int> m_studyIndex;       // 指标名称 -> 指标编号
+    QVector<Field> m_fields;
+    QHash<QString, int> m_fieldIndex;       // 字段名称 -> 字段编号
+    QVector<IndicatorSeries> m_closes;      // 每个品种有成交的收盘价
+    QVector<char> m_traded;                 // 最新一根截面K线上是否有成交
+    int m_barCount;
+    int m_maxLookback;
+    int m_threadCount;
+    QThreadPool m_threadPool;               // 指定线程数时使用的线程池
+};
+
+#endif // CROSSSECTIONENGINE_H
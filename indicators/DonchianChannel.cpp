@@ -0,0 +1,86 @@
+﻿#include "DonchianChannel.h"
+#include "../AppData.h"
+
+DonchianChannel::DonchianChannel(int period, QObject *parent)
+    : IndicatorBase(AppData::DONCHIAN, parent),
+      m_period(qMax(1, period)),
+      m_highest(m_period, MonotonicWindow::Max),
+      m_lowest(m_period, MonotonicWindow::Min)
+{
+    addSeries(&m_upperBand);
+    addSeries(&m_middleBand);
+    addSeries(&m_lowerBand);
+}
+
+void DonchianChannel::calculate(const QVector<AppData::MarketData> &data)
+{
+    m_upperBand.clear();
+    m_middleBand.clear();
+    m_lowerBand.clear();
+    m_highest.reset();
+    m_lowest.reset();
+    
+    // 单调队列逐根推进，整段计算为O(n)，与实时更新共用同一套状态
+    const int count = qMax(0, data.size() - m_period + 1);
+    m_upperBand.reserve(count);
+    m_middleBand.reserve(count);
+    m_lowerBand.reserve(count);
+    for (const auto &bar : data) {
+        append(bar);
+    }
+    
+    if (!m_middleBand.isEmpty()) {
+        emit indicatorUpdated();
+    }
+}
+
+void DonchianChannel::update(const AppData::MarketData &newData)
+{
+    append(newData);
+    emit indicatorUpdated();
+}
+
+void DonchianChannel::append(const AppData::MarketData &bar)
+{
+    m_highest.push(bar.high);
+    m_lowest.push(bar.low);
+    if (!m_highest.isFull()) {
+        return;
+    }
+    
+    const double upper = m_highest.value();
+    const double lower = m_lowest.value();
+    m_upperBand.append(upper);
+    m_middleBand.append((upper + lower) / 2.0);
+    m_lowerBand.append(lower);
+}
+
+QString DonchianChannel::name() const
+{
+    return QString("Donchian(%1)").arg(m_period);
+}
+
+SeriesView DonchianChannel::values() const
+{
+    return m_middleBand.view(); // 默认返回中轨值
+}
+
+double DonchianChannel::lastValue() const
+{
+    return m_middleBand.isEmpty() ? 0.0 : m_middleBand.last();
+}
+
+SeriesView DonchianChannel::upperBand() const
+{
+    return m_upperBand.view();
+}
+
+SeriesView DonchianChannel::middleBand() const
+{
+    return m_middleBand.view();
+}
+
+SeriesView DonchianChannel::lowerBand() const
+{
+    return m_lowerBand.view();
+}
@@ -0,0 +1,50 @@
+﻿#ifndef DONCHIANCHANNEL_H
+#define DONCHIANCHANNEL_H
+
+#include "IndicatorBase.h"
+#include "MonotonicWindow.h"
+
+// 唐奇安通道：上轨为区间最高价，下轨为区间最低价，中轨为两者的平均
+class DonchianChannel : public IndicatorBase
+{
+    Q_OBJECT
+public:
+    explicit DonchianChannel(int period = 20, QObject *parent = nullptr);
+    
+    // 计算指标值
+    void calculate(const QVector<AppData::MarketData> &data) override;
+    
+    // 实时更新指标
+    void update(const AppData::MarketData &newData) override;
+    
+    // 获取指标名称
+    QString name() const override;
+    
+    // 获取计算结果
+    SeriesView values() const override;
+    
+    // 获取最新值
+    double lastValue() const override;
+
+    // 获取上轨线
+    SeriesView upperBand() const;
+    
+    // 获取中轨线
+    SeriesView middleBand() const;
+    
+    // 获取下轨线
+    SeriesView lowerBand() const;
+
+private:
+    // 并入一根K线，窗口满后才产生指标值
+    void append(const AppData::MarketData &bar);
+
+    int m_period;
+    MonotonicWindow m_highest;
+    MonotonicWindow m_lowest;
+    IndicatorSeries m_upperBand;
+    IndicatorSeries m_middleBand;
+    IndicatorSeries m_lowerBand;
+};
+
+#endif // DONCHIANCHANNEL_H
@@ -1,7 +1,7 @@
 ﻿#include "IndicatorBase.h"
 
 IndicatorBase::IndicatorBase(AppData::IndicatorType type, QObject *parent)
-    : QObject(parent), m_type(type)
+    : QObject(parent), m_type(type), m_maxLookback(0)
 {
 }
 
@@ -13,3 +13,54 @@ AppData::IndicatorType IndicatorBase::type() const
 {
     return m_type;
 }
+
+double IndicatorBase::value(int barsAgo) const
+{
+    return values().value(barsAgo);
+}
+
+void IndicatorBase::setMaxLookback(int bars)
+{
+    m_maxLookback = qMax(0, bars);
+    for (IndicatorSeries *series : m_series) {
+        series->setMaxLookback(m_maxLookback);
+    }
+}
+
+int IndicatorBase::maxLookback() const
+{
+    return m_maxLookback;
+}
+
+void IndicatorBase::addSeries(IndicatorSeries *series)
+{
+    series->setMaxLookback(m_maxLookback);
+    m_series.append(series);
+}
+
+QVector<double> IndicatorBase::closePrices(const QVector<AppData::MarketData> &data)
+{
+    QVector<double> closes(data.size());
+    for (int i = 0; i < data.size(); ++i) {
+        closes[i] = data[i].close;
+    }
+    return closes;
+}
+
+QVector<double> IndicatorBase::highPrices(const QVector<AppData::MarketData> &data)
+{
+    QVector<double> highs(data.size());
+    for (int i = 0; i < data.size(); ++i) {
+        highs[i] = data[i].high;
+    }
+    return highs;
+}
+
+QVector<double> IndicatorBase::lowPrices(const QVector<AppData::MarketData> &data)
+{
+    QVector<double> lows(data.size());
+    for (int i = 0; i < data.size(); ++i) {
+        lows[i] = data[i].low;
+    }
+    return lows;
+}
@@ -3,6 +3,7 @@
 
 #include <QObject>
 #include <QVector>
+#include "IndicatorSeries.h"
 #include "../AppData.h"
 
 class IndicatorBase : public QObject
@@ -26,17 +27,34 @@ public:
     // 获取指标类型
     AppData::IndicatorType type() const;
     
-    // 获取计算结果
-    virtual QVector<double> values() const = 0;
+    // 获取计算结果（只读视图，下一次计算或更新前有效）
+    virtual SeriesView values() const = 0;
     
     // 获取最新值
     virtual double lastValue() const = 0;
 
+    // 获取n根K线之前的值，0为最新值，越界时为NaN
+    double value(int barsAgo = 0) const;
+
+    // 设置结果的最大回看长度，只保留最近bars个值；0表示不限长度（默认）
+    void setMaxLookback(int bars);
+    int maxLookback() const;
+
 signals:
     void indicatorUpdated();
 
 protected:
+    // 取出K线收盘价、最高价、最低价为连续数组，供批量计算使用
+    static QVector<double> closePrices(const QVector<AppData::MarketData> &data);
+    static QVector<double> highPrices(const QVector<AppData::MarketData> &data);
+    static QVector<double> lowPrices(const QVector<AppData::MarketData> &data);
+
+    // 登记结果序列，setMaxLookback()作用于所有登记的序列
+    void addSeries(IndicatorSeries *series);
+
     AppData::IndicatorType m_type;
+    QVector<IndicatorSeries *> m_series;
+    int m_maxLookback;
 };
 
 #endif // INDICATORBASE_H
@@ -0,0 +1,737 @@
+﻿#include "IndicatorKernels.h"
+#include <QtGlobal>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KQUANT_KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC/Clang需要为使用AVX2指令的函数单独指定目标，MSVC可直接使用内建函数
+#if defined(__GNUC__) || defined(__clang__)
+#define KQUANT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define KQUANT_TARGET_AVX2
+#endif
+
+namespace IndicatorKernels {
+
+namespace {
+
+const double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+// 区间不超过该长度时直接逐个比较（可向量化），否则使用与区间长度无关的van Herk/Gil-Werman算法
+const int kDirectExtremumPeriod = 16;
+
+// 与_mm_max_pd/_mm_min_pd相同：任一操作数为NaN时返回b，标量尾部与向量部分结果一致
+inline double maxPd(double a, double b)
+{
+    return a > b ? a : b;
+}
+
+inline double minPd(double a, double b)
+{
+    return a < b ? a : b;
+}
+
+Isa detectIsa()
+{
+#if defined(KQUANT_KERNELS_X86)
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return Avx2Isa;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return Sse2Isa;
+    }
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    const bool sse2 = (info[3] & (1 << 26)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    // 操作系统须保存YMM寄存器状态
+    if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6) {
+        __cpuidex(info, 7, 0);
+        if (info[1] & (1 << 5)) {
+            return Avx2Isa;
+        }
+    }
+    if (sse2) {
+        return Sse2Isa;
+    }
+#endif
+#endif
+    return ScalarIsa;
+}
+
+std::atomic<int> &activeIsaStorage()
+{
+    static std::atomic<int> isa(detectedIsa());
+    return isa;
+}
+
+void fillNaN(double *out, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        out[i] = kNaN;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 逐元素步骤的标量实现
+// ---------------------------------------------------------------------------
+
+// out[i] = in[i] - in[i - lag]，i从lag到n-1
+void lagDiffScalar(const double *in, int n, int lag, double *out)
+{
+    for (int i = lag; i < n; ++i) {
+        out[i] = in[i] - in[i - lag];
+    }
+}
+
+// data[i] /= divisor，用除法而不是乘倒数，与逐根更新的结果逐位一致
+void divideScalar(double *data, int n, double divisor)
+{
+    for (int i = 0; i < n; ++i) {
+        data[i] /= divisor;
+    }
+}
+
+// out[i] = a[i] - b[i]，out可以与a或b相同
+void subtractScalar(const double *a, const double *b, int n, double *out)
+{
+    for (int i = 0; i < n; ++i) {
+        out[i] = a[i] - b[i];
+    }
+}
+
+// 输入时upper为方差，输出时为上轨
+void bandsScalar(const double *middle, int n, double multiplier, double *upper, double *lower)
+{
+    for (int i = 0; i < n; ++i) {
+        const double offset = multiplier * std::sqrt(maxPd(upper[i], 0.0));
+        upper[i] = middle[i] + offset;
+        lower[i] = middle[i] - offset;
+    }
+}
+
+// 真实波幅，i从1到n-1
+void trueRangeScalar(const double *high, const double *low, const double *close, int n, double *out)
+{
+    for (int i = 1; i < n; ++i) {
+        const double range = high[i] - low[i];
+        const double up = std::fabs(high[i] - close[i - 1]);
+        const double down = std::fabs(low[i] - close[i - 1]);
+        out[i] = maxPd(range, maxPd(up, down));
+    }
+}
+
+// 逐个比较的区间最值，i从period-1到n-1
+void windowMaxScalar(const double *in, int n, int period, double *out)
+{
+    for (int i = period - 1; i < n; ++i) {
+        double value = in[i - period + 1];
+        for (int k = i - period + 2; k <= i; ++k) {
+            value = maxPd(value, in[k]);
+        }
+        out[i] = value;
+    }
+}
+
+void windowMinScalar(const double *in, int n, int period, double *out)
+{
+    for (int i = period - 1; i < n; ++i) {
+        double value = in[i - period + 1];
+        for (int k = i - period + 2; k <= i; ++k) {
+            value = minPd(value, in[k]);
+        }
+        out[i] = value;
+    }
+}
+
+#if defined(KQUANT_KERNELS_X86)
+
+// ---------------------------------------------------------------------------
+// SSE2实现，每次处理2个double
+// ---------------------------------------------------------------------------
+
+void lagDiffSse2(const double *in, int n, int lag, double *out)
+{
+    int i = lag;
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(out + i, _mm_sub_pd(_mm_loadu_pd(in + i), _mm_loadu_pd(in + i - lag)));
+    }
+    lagDiffScalar(in + i - lag, n - i + lag, lag, out + i - lag);
+}
+
+void divideSse2(double *data, int n, double divisor)
+{
+    const __m128d d = _mm_set1_pd(divisor);
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(data + i, _mm_div_pd(_mm_loadu_pd(data + i), d));
+    }
+    divideScalar(data + i, n - i, divisor);
+}
+
+void subtractSse2(const double *a, const double *b, int n, double *out)
+{
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(out + i, _mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+    }
+    subtractScalar(a + i, b + i, n - i, out + i);
+}
+
+void bandsSse2(const double *middle, int n, double multiplier, double *upper, double *lower)
+{
+    const __m128d k = _mm_set1_pd(multiplier);
+    const __m128d zero = _mm_setzero_pd();
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const __m128d mid = _mm_loadu_pd(middle + i);
+        const __m128d offset = _mm_mul_pd(k, _mm_sqrt_pd(_mm_max_pd(_mm_loadu_pd(upper + i), zero)));
+        _mm_storeu_pd(upper + i, _mm_add_pd(mid, offset));
+        _mm_storeu_pd(lower + i, _mm_sub_pd(mid, offset));
+    }
+    bandsScalar(middle + i, n - i, multiplier, upper + i, lower + i);
+}
+
+void trueRangeSse2(const double *high, const double *low, const double *close, int n, double *out)
+{
+    const __m128d sign = _mm_set1_pd(-0.0);
+    int i = 1;
+    for (; i + 2 <= n; i += 2) {
+        const __m128d h = _mm_loadu_pd(high + i);
+        const __m128d l = _mm_loadu_pd(low + i);
+        const __m128d prev = _mm_loadu_pd(close + i - 1);
+        const __m128d up = _mm_andnot_pd(sign, _mm_sub_pd(h, prev));
+        const __m128d down = _mm_andnot_pd(sign, _mm_sub_pd(l, prev));
+        _mm_storeu_pd(out + i, _mm_max_pd(_mm_sub_pd(h, l), _mm_max_pd(up, down)));
+    }
+    trueRangeScalar(high + i - 1, low + i - 1, close + i - 1, n - i + 1, out + i - 1);
+}
+
+void windowMaxSse2(const double *in, int n, int period, double *out)
+{
+    int i = period - 1;
+    for (; i + 2 <= n; i += 2) {
+        const double *window = in + i - period + 1;
+        __m128d value = _mm_loadu_pd(window);
+        for (int k = 1; k < period; ++k) {
+            value = _mm_max_pd(value, _mm_loadu_pd(window + k));
+        }
+        _mm_storeu_pd(out + i, value);
+    }
+    windowMaxScalar(in + i - period + 1, n - i + period - 1, period, out + i - period + 1);
+}
+
+void windowMinSse2(const double *in, int n, int period, double *out)
+{
+    int i = period - 1;
+    for (; i + 2 <= n; i += 2) {
+        const double *window = in + i - period + 1;
+        __m128d value = _mm_loadu_pd(window);
+        for (int k = 1; k < period; ++k) {
+            value = _mm_min_pd(value, _mm_loadu_pd(window + k));
+        }
+        _mm_storeu_pd(out + i, value);
+    }
+    windowMinScalar(in + i - period + 1, n - i + period - 1, period, out + i - period + 1);
+}
+
+// ---------------------------------------------------------------------------
+// AVX2实现，每次处理4个double
+// ---------------------------------------------------------------------------
+
+KQUANT_TARGET_AVX2 void lagDiffAvx2(const double *in, int n, int lag, double *out)
+{
+    int i = lag;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(out + i, _mm256_sub_pd(_mm256_loadu_pd(in + i), _mm256_loadu_pd(in + i - lag)));
+    }
+    lagDiffScalar(in + i - lag, n - i + lag, lag, out + i - lag);
+}
+
+KQUANT_TARGET_AVX2 void divideAvx2(double *data, int n, double divisor)
+{
+    const __m256d d = _mm256_set1_pd(divisor);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(data + i, _mm256_div_pd(_mm256_loadu_pd(data + i), d));
+    }
+    divideScalar(data + i, n - i, divisor);
+}
+
+KQUANT_TARGET_AVX2 void subtractAvx2(const double *a, const double *b, int n, double *out)
+{
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(out + i, _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    }
+    subtractScalar(a + i, b + i, n - i, out + i);
+}
+
+KQUANT_TARGET_AVX2 void bandsAvx2(const double *middle, int n, double multiplier, double *upper, double *lower)
+{
+    const __m256d k = _mm256_set1_pd(multiplier);
+    const __m256d zero = _mm256_setzero_pd();
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d mid = _mm256_loadu_pd(middle + i);
+        const __m256d offset = _mm256_mul_pd(k, _mm256_sqrt_pd(_mm256_max_pd(_mm256_loadu_pd(upper + i), zero)));
+        _mm256_storeu_pd(upper + i, _mm256_add_pd(mid, offset));
+        _mm256_storeu_pd(lower + i, _mm256_sub_pd(mid, offset));
+    }
+    bandsScalar(middle + i, n - i, multiplier, upper + i, lower + i);
+}
+
+KQUANT_TARGET_AVX2 void trueRangeAvx2(const double *high, const double *low, const double *close, int n, double *out)
+{
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    int i = 1;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d h = _mm256_loadu_pd(high + i);
+        const __m256d l = _mm256_loadu_pd(low + i);
+        const __m256d prev = _mm256_loadu_pd(close + i - 1);
+        const __m256d up = _mm256_andnot_pd(sign, _mm256_sub_pd(h, prev));
+        const __m256d down = _mm256_andnot_pd(sign, _mm256_sub_pd(l, prev));
+        _mm256_storeu_pd(out + i, _mm256_max_pd(_mm256_sub_pd(h, l), _mm256_max_pd(up, down)));
+    }
+    trueRangeScalar(high + i - 1, low + i - 1, close + i - 1, n - i + 1, out + i - 1);
+}
+
+KQUANT_TARGET_AVX2 void windowMaxAvx2(const double *in, int n, int period, double *out)
+{
+    int i = period - 1;
+    for (; i + 4 <= n; i += 4) {
+        const double *window = in + i - period + 1;
+        __m256d value = _mm256_loadu_pd(window);
+        for (int k = 1; k < period; ++k) {
+            value = _mm256_max_pd(value, _mm256_loadu_pd(window + k));
+        }
+        _mm256_storeu_pd(out + i, value);
+    }
+    windowMaxScalar(in + i - period + 1, n - i + period - 1, period, out + i - period + 1);
+}
+
+KQUANT_TARGET_AVX2 void windowMinAvx2(const double *in, int n, int period, double *out)
+{
+    int i = period - 1;
+    for (; i + 4 <= n; i += 4) {
+        const double *window = in + i - period + 1;
+        __m256d value = _mm256_loadu_pd(window);
+        for (int k = 1; k < period; ++k) {
+            value = _mm256_min_pd(value, _mm256_loadu_pd(window + k));
+        }
+        _mm256_storeu_pd(out + i, value);
+    }
+    windowMinScalar(in + i - period + 1, n - i + period - 1, period, out + i - period + 1);
+}
+
+#endif // KQUANT_KERNELS_X86
+
+// ---------------------------------------------------------------------------
+// 按当前指令集分派
+// ---------------------------------------------------------------------------
+
+void lagDiff(const double *in, int n, int lag, double *out)
+{
+    switch (activeIsa()) {
+#if defined(KQUANT_KERNELS_X86)
+    case Avx2Isa: lagDiffAvx2(in, n, lag, out); return;
+    case Sse2Isa: lagDiffSse2(in, n, lag, out); return;
+#endif
+    default: lagDiffScalar(in, n, lag, out); return;
+    }
+}
+
+void divide(double *data, int n, double divisor)
+{
+    switch (activeIsa()) {
+#if defined(KQUANT_KERNELS_X86)
+    case Avx2Isa: divideAvx2(data, n, divisor); return;
+    case Sse2Isa: divideSse2(data, n, divisor); return;
+#endif
+    default: divideScalar(data, n, divisor); return;
+    }
+}
+
+void subtract(const double *a, const double *b, int n, double *out)
+{
+    switch (activeIsa()) {
+#if defined(KQUANT_KERNELS_X86)
+    case Avx2Isa: subtractAvx2(a, b, n, out); return;
+    case Sse2Isa: subtractSse2(a, b, n, out); return;
+#endif
+    default: subtractScalar(a, b, n, out); return;
+    }
+}
+
+void bands(const double *middle, int n, double multiplier, double *upper, double *lower)
+{
+    switch (activeIsa()) {
+#if defined(KQUANT_KERNELS_X86)
+    case Avx2Isa: bandsAvx2(middle, n, multiplier, upper, lower); return;
+    case Sse2Isa: bandsSse2(middle, n, multiplier, upper, lower); return;
+#endif
+    default: bandsScalar(middle, n, multiplier, upper, lower); return;
+    }
+}
+
+void trueRange(const double *high, const double *low, const double *close, int n, double *out)
+{
+    switch (activeIsa()) {
+#if defined(KQUANT_KERNELS_X86)
+    case Avx2Isa: trueRangeAvx2(high, low, close, n, out); return;
+    case Sse2Isa: trueRangeSse2(high, low, close, n, out); return;
+#endif
+    default: trueRangeScalar(high, low, close, n, out); return;
+    }
+}
+
+void windowMax(const double *in, int n, int period, double *out)
+{
+    switch (activeIsa()) {
+#if defined(KQUANT_KERNELS_X86)
+    case Avx2Isa: windowMaxAvx2(in, n, period, out); return;
+    case Sse2Isa: windowMaxSse2(in, n, period, out); return;
+#endif
+    default: windowMaxScalar(in, n, period, out); return;
+    }
+}
+
+void windowMin(const double *in, int n, int period, double *out)
+{
+    switch (activeIsa()) {
+#if defined(KQUANT_KERNELS_X86)
+    case Avx2Isa: windowMinAvx2(in, n, period, out); return;
+    case Sse2Isa: windowMinSse2(in, n, period, out); return;
+#endif
+    default: windowMinScalar(in, n, period, out); return;
+    }
+}
+
+// Kahan补偿求和
+struct KahanSum {
+    double sum;
+    double compensation;
+
+    KahanSum() : sum(0.0), compensation(0.0) {}
+
+    void add(double value)
+    {
+        const double y = value - compensation;
+        const double t = sum + y;
+        compensation = (t - sum) - y;
+        sum = t;
+    }
+};
+
+// 与RollingWindow::recompute相同：按窗口重新求和，补偿项清零
+KahanSum windowSum(const double *window, int period)
+{
+    KahanSum sum;
+    for (int i = 0; i < period; ++i) {
+        sum.add(window[i]);
+    }
+    sum.compensation = 0.0;
+    return sum;
+}
+
+// van Herk/Gil-Werman区间最值：第一遍按period分块求块内前缀最值写入out，
+// 第二遍从后向前维护块内后缀最值并与前缀最值合并，每个元素比较3次，与区间长度无关
+template <typename Better>
+void blockExtremum(const double *in, int n, int period, double *out, Better better)
+{
+    for (int i = 0; i < n; ++i) {
+        out[i] = (i % period == 0) ? in[i] : better(out[i - 1], in[i]);
+    }
+
+    // suffix为以j起到所在块末尾的最值，先按最后一个窗口的起点初始化
+    const int last = n - period;
+    const int lastBlockEnd = (last / period + 1) * period - 1;
+    double suffix = in[last];
+    for (int k = last + 1; k <= lastBlockEnd; ++k) {
+        suffix = better(suffix, in[k]);
+    }
+    for (int j = last; j >= 0; --j) {
+        if (j < last) {
+            suffix = ((j + 1) % period == 0) ? in[j] : better(in[j], suffix);
+        }
+        // 窗口[j, i]恰好是一个块时前缀最值即为结果
+        const int i = j + period - 1;
+        if (j % period != 0) {
+            out[i] = better(suffix, out[i]);
+        }
+    }
+}
+
+} // namespace
+
+Isa detectedIsa()
+{
+    static const Isa isa = detectIsa();
+    return isa;
+}
+
+Isa activeIsa()
+{
+    return static_cast<Isa>(activeIsaStorage().load(std::memory_order_relaxed));
+}
+
+void setActiveIsa(Isa isa)
+{
+    activeIsaStorage().store(qMin(isa, detectedIsa()), std::memory_order_relaxed);
+}
+
+const char *isaName(Isa isa)
+{
+    switch (isa) {
+    case Avx2Isa: return "avx2";
+    case Sse2Isa: return "sse2";
+    default: return "scalar";
+    }
+}
+
+void sma(const double *in, int n, int period, double *out)
+{
+    period = qMax(1, period);
+    fillNaN(out, qMin(n, period - 1));
+    if (n < period) {
+        return;
+    }
+
+    // out[i]先存放进出窗口的差值，再原地累加为窗口和；
+    // 与RollingWindow一样每period根按窗口重新求和一次
+    lagDiff(in, n, period, out);
+
+    KahanSum sum;
+    for (int i = period - 1; i < n; ++i) {
+        if ((i + 1) % period == 0) {
+            sum = windowSum(in + i - period + 1, period);
+        } else {
+            sum.add(out[i]);
+        }
+        out[i] = sum.sum;
+    }
+
+    divide(out + period - 1, n - period + 1, period);
+}
+
+void ema(const double *in, int n, int period, double *out)
+{
+    if (n <= 0) {
+        return;
+    }
+
+    const double multiplier = emaMultiplier(period);
+    double value = in[0];
+    out[0] = value;
+    for (int i = 1; i < n; ++i) {
+        value = emaStep(value, in[i], multiplier);
+        out[i] = value;
+    }
+}
+
+void wma(const double *in, int n, int period, double *out)
+{
+    period = qMax(1, period);
+    fillNaN(out, qMin(n, period - 1));
+    if (n < period) {
+        return;
+    }
+
+    // out[i]先存放进出窗口的差值，再原地替换为线性加权和：新值权重为period，
+    // 其余值权重各减1，相当于减去原窗口和
+    lagDiff(in, n, period, out);
+
+    KahanSum sum;
+    double weightedSum = 0.0;
+    for (int i = period - 1; i < n; ++i) {
+        if ((i + 1) % period == 0) {
+            const double *window = in + i - period + 1;
+            sum = windowSum(window, period);
+            weightedSum = 0.0;
+            for (int k = 0; k < period; ++k) {
+                weightedSum += (k + 1) * window[k];
+            }
+        } else {
+            weightedSum += period * in[i] - sum.sum;
+            sum.add(out[i]);
+        }
+        out[i] = weightedSum;
+    }
+
+    divide(out + period - 1, n - period + 1, period * (period + 1) / 2.0);
+}
+
+void rsi(const double *close, int n, int period, double *out, double *avgGain, double *avgLoss)
+{
+    period = qMax(1, period);
+    if (n <= period) {
+        fillNaN(out, n);
+        return;
+    }
+
+    // out[i]先存放涨跌额
+    lagDiff(close, n, 1, out);
+
+    double sumGain = 0.0;
+    double sumLoss = 0.0;
+    for (int i = 1; i <= period; ++i) {
+        const double change = out[i];
+        if (change > 0) {
+            sumGain += change;
+        } else {
+            sumLoss -= change;
+        }
+    }
+
+    double gain = sumGain / period;
+    double loss = sumLoss / period;
+    out[period] = rsiValue(gain, loss);
+
+    for (int i = period + 1; i < n; ++i) {
+        const double change = out[i];
+        gain = wilderStep(gain, change > 0 ? change : 0.0, period);
+        loss = wilderStep(loss, change < 0 ? -change : 0.0, period);
+        out[i] = rsiValue(gain, loss);
+    }
+
+    fillNaN(out, period);
+    if (avgGain) {
+        *avgGain = gain;
+    }
+    if (avgLoss) {
+        *avgLoss = loss;
+    }
+}
+
+void macd(const double *close, int n, int fastPeriod, int slowPeriod, int signalPeriod,
+          double *dif, double *dea, double *hist, double *fastEma, double *slowEma)
+{
+    if (n <= 0) {
+        return;
+    }
+
+    // hist先存放慢线
+    ema(close, n, fastPeriod, dif);
+    ema(close, n, slowPeriod, hist);
+    if (fastEma) {
+        *fastEma = dif[n - 1];
+    }
+    if (slowEma) {
+        *slowEma = hist[n - 1];
+    }
+    subtract(dif, hist, n, dif);
+    ema(dif, n, signalPeriod, dea);
+    subtract(dif, dea, n, hist);
+}
+
+void bollinger(const double *in, int n, int period, double multiplier,
+               double *middle, double *upper, double *lower)
+{
+    period = qMax(1, period);
+    sma(in, n, period, middle);
+    fillNaN(upper, qMin(n, period - 1));
+    fillNaN(lower, qMin(n, period - 1));
+    if (n < period) {
+        return;
+    }
+
+    // middle先存放窗口和，upper先存放进出窗口的差值、再替换为离差平方和；
+    // 均值和离差平方和按滑动Welford更新，与RollingWindow一样每period根按窗口重新计算一次
+    lagDiff(in, n, period, upper);
+
+    KahanSum sum;
+    double mean = 0.0;
+    double m2 = 0.0;
+    for (int i = period - 1; i < n; ++i) {
+        if ((i + 1) % period == 0) {
+            const double *window = in + i - period + 1;
+            sum = windowSum(window, period);
+            mean = sum.sum / period;
+            m2 = 0.0;
+            for (int k = 0; k < period; ++k) {
+                const double deviation = window[k] - mean;
+                m2 += deviation * deviation;
+            }
+        } else {
+            const double change = upper[i];
+            const double oldMean = mean;
+            mean += change / period;
+            m2 += change * (in[i] - mean + in[i - period] - oldMean);
+            sum.add(change);
+        }
+        middle[i] = sum.sum;
+        upper[i] = m2;
+    }
+
+    divide(middle + period - 1, n - period + 1, period);
+    divide(upper + period - 1, n - period + 1, period);
+    bands(middle + period - 1, n - period + 1, multiplier, upper + period - 1, lower + period - 1);
+}
+
+void atr(const double *high, const double *low, const double *close, int n, int period, double *out)
+{
+    period = qMax(1, period);
+    if (n < period) {
+        fillNaN(out, n);
+        return;
+    }
+
+    // out[i]先存放真实波幅，第一根没有昨收，取最高价减最低价
+    out[0] = high[0] - low[0];
+    trueRange(high, low, close, n, out);
+
+    double sum = 0.0;
+    for (int i = 0; i < period; ++i) {
+        sum += out[i];
+    }
+    double value = sum / period;
+    fillNaN(out, period - 1);
+    out[period - 1] = value;
+
+    for (int i = period; i < n; ++i) {
+        value = wilderStep(value, out[i], period);
+        out[i] = value;
+    }
+}
+
+void rollingMax(const double *in, int n, int period, double *out)
+{
+    period = qMax(1, period);
+    if (n >= period) {
+        if (period <= kDirectExtremumPeriod) {
+            windowMax(in, n, period, out);
+        } else {
+            blockExtremum(in, n, period, out, [](double a, double b) { return qMax(a, b); });
+        }
+    }
+    fillNaN(out, qMin(n, period - 1));
+}
+
+void rollingMin(const double *in, int n, int period, double *out)
+{
+    period = qMax(1, period);
+    if (n >= period) {
+        if (period <= kDirectExtremumPeriod) {
+            windowMin(in, n, period, out);
+        } else {
+            blockExtremum(in, n, period, out, [](double a, double b) { return qMin(a, b); });
+        }
+    }
+    fillNaN(out, qMin(n, period - 1));
+}
+
+} // namespace IndicatorKernels
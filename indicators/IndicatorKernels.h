@@ -0,0 +1,105 @@
+﻿#ifndef INDICATORKERNELS_H
+#define INDICATORKERNELS_H
+
+/**
+ * @brief 连续double数组上的批量指标计算
+ *
+ * 所有函数把结果写入调用方预先分配的长度为n的输出数组，不分配内存；
+ * 预热期（窗口未满）的输出为NaN。输入和输出可以是不同的数组，除特别说明外不能重叠。
+ *
+ * 逐元素的步骤（差分、真实波幅、除法、上下轨、短区间最值等）按运行时检测到的
+ * 指令集选择AVX2、SSE2或标量实现；EMA、Wilder平滑等前后相依的递推无法跨时间向量化，
+ * 始终为标量循环。
+ *
+ * 各内核的浮点运算顺序与指标类逐根更新的路径（RollingWindow和下面的递推函数）完全相同，
+ * 批量计算后接若干次逐根更新的结果与整段重新计算逐位一致，且与所选指令集无关。
+ * 标量实现的最值比较与_mm_max_pd/_mm_min_pd取相同的操作数顺序（任一操作数为NaN时
+ * 取第二个），输入含NaN时各指令集的结果同样一致；此时不保证与逐根更新的路径一致。
+ * 数据不足一个预热期时，指标类不调用内核，只逐根积累递推状态（或窗口），
+ * 之后的实时更新由此接续。
+ */
+namespace IndicatorKernels {
+
+// EMA平滑系数
+inline double emaMultiplier(int period)
+{
+    return 2.0 / ((period > 1 ? period : 1) + 1);
+}
+
+// EMA递推一步
+inline double emaStep(double previous, double value, double multiplier)
+{
+    return (value - previous) * multiplier + previous;
+}
+
+// Wilder平滑递推一步
+inline double wilderStep(double previous, double value, int period)
+{
+    return (previous * (period - 1) + value) / period;
+}
+
+// 由平均涨幅和平均跌幅计算RSI
+inline double rsiValue(double avgGain, double avgLoss)
+{
+    return avgLoss == 0.0 ? 100.0 : 100.0 - (100.0 / (1.0 + avgGain / avgLoss));
+}
+
+// 指令集
+enum Isa {
+    ScalarIsa,
+    Sse2Isa,
+    Avx2Isa
+};
+
+// CPU支持的最高指令集
+Isa detectedIsa();
+
+// 当前使用的指令集，默认为detectedIsa()
+Isa activeIsa();
+
+// 指定使用的指令集（用于测试和性能对比），超过CPU支持的指令集时取CPU支持的最高指令集
+void setActiveIsa(Isa isa);
+
+// 指令集名称
+const char *isaName(Isa isa);
+
+// 简单移动平均，out[period-1]起有效
+void sma(const double *in, int n, int period, double *out);
+
+// 指数移动平均，以in[0]为初值，out[0]起有效
+void ema(const double *in, int n, int period, double *out);
+
+// 线性加权移动平均，最新值权重为period，out[period-1]起有效
+void wma(const double *in, int n, int period, double *out);
+
+/**
+ * @brief 相对强弱指数（Wilder平滑），out[period]起有效
+ * @param avgGain 输出最后的平均涨幅，可为空
+ * @param avgLoss 输出最后的平均跌幅，可为空
+ */
+void rsi(const double *close, int n, int period, double *out,
+         double *avgGain = nullptr, double *avgLoss = nullptr);
+
+/**
+ * @brief MACD：DIF = EMA(fast) - EMA(slow)，DEA = EMA(DIF, signal)，柱 = DIF - DEA，均从下标0起有效
+ * @param fastEma 输出最后的快线EMA，可为空
+ * @param slowEma 输出最后的慢线EMA，可为空
+ */
+void macd(const double *close, int n, int fastPeriod, int slowPeriod, int signalPeriod,
+          double *dif, double *dea, double *hist,
+          double *fastEma = nullptr, double *slowEma = nullptr);
+
+// 布林带：中轨为简单移动平均，上下轨为中轨加减multiplier倍总体标准差，[period-1]起有效
+void bollinger(const double *in, int n, int period, double multiplier,
+               double *middle, double *upper, double *lower);
+
+// 平均真实波幅（Wilder平滑），首个值为前period个真实波幅的平均，out[period-1]起有效
+void atr(const double *high, const double *low, const double *close, int n, int period, double *out);
+
+// 区间最大值/最小值，out[period-1]起有效
+void rollingMax(const double *in, int n, int period, double *out);
+void rollingMin(const double *in, int n, int period, double *out);
+
+} // namespace IndicatorKernels
+
+#endif // INDICATORKERNELS_H
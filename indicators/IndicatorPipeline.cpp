@@ -0,0 +1,504 @@
+﻿#include "IndicatorPipeline.h"
+#include "IndicatorKernels.h"
+#include <QMutexLocker>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+QString fieldName(IndicatorPipeline::Field field)
+{
+    switch (field) {
+    case IndicatorPipeline::Open: return "open";
+    case IndicatorPipeline::High: return "high";
+    case IndicatorPipeline::Low: return "low";
+    case IndicatorPipeline::Close: return "close";
+    case IndicatorPipeline::Volume: return "volume";
+    case IndicatorPipeline::HL2: return "hl2";
+    case IndicatorPipeline::HLC3: return "hlc3";
+    }
+    return QString();
+}
+
+double fieldValue(IndicatorPipeline::Field field, const AppData::MarketData &bar)
+{
+    switch (field) {
+    case IndicatorPipeline::Open: return bar.open;
+    case IndicatorPipeline::High: return bar.high;
+    case IndicatorPipeline::Low: return bar.low;
+    case IndicatorPipeline::Close: return bar.close;
+    case IndicatorPipeline::Volume: return bar.volume;
+    case IndicatorPipeline::HL2: return (bar.high + bar.low) / 2.0;
+    case IndicatorPipeline::HLC3: return (bar.high + bar.low + bar.close) / 3.0;
+    }
+    return kNaN;
+}
+
+} // namespace
+
+IndicatorPipeline::Node::Node()
+    : kind(SourceNode)
+    , inputA(-1)
+    , inputB(-1)
+    , period(1)
+    , weightA(0.0)
+    , weightB(0.0)
+    , field(Close)
+    , count(0)
+    , state(0.0)
+    , state2(0.0)
+    , last(0.0)
+{
+}
+
+IndicatorPipeline::IndicatorPipeline(QObject *parent)
+    : QObject(parent)
+    , m_barCount(0)
+    , m_maxLookback(0)
+{
+}
+
+IndicatorPipeline::~IndicatorPipeline()
+{
+}
+
+void IndicatorPipeline::setMaxLookback(int bars)
+{
+    m_maxLookback = qMax(0, bars);
+    for (Node &node : m_nodes) {
+        node.values.setMaxLookback(m_maxLookback);
+        if (node.indicator) {
+            node.indicator->setMaxLookback(m_maxLookback);
+        }
+    }
+    if (m_maxLookback > 0 && m_bars.size() > m_maxLookback) {
+        m_bars.remove(0, m_bars.size() - m_maxLookback);
+    }
+}
+
+int IndicatorPipeline::maxLookback() const
+{
+    return m_maxLookback;
+}
+
+int IndicatorPipeline::source(Field field)
+{
+    Node node;
+    node.kind = SourceNode;
+    node.field = field;
+    node.signature = fieldName(field);
+    return addNode(node);
+}
+
+int IndicatorPipeline::ema(int input, int period)
+{
+    if (!isValidNode(input)) {
+        return -1;
+    }
+    Node node;
+    node.kind = EmaNode;
+    node.inputA = input;
+    node.period = qMax(1, period);
+    node.signature = QString("ema(%1,%2)").arg(signature(input)).arg(node.period);
+    return addNode(node);
+}
+
+int IndicatorPipeline::sma(int input, int period)
+{
+    if (!isValidNode(input)) {
+        return -1;
+    }
+    Node node;
+    node.kind = SmaNode;
+    node.inputA = input;
+    node.period = qMax(1, period);
+    node.window = RollingWindow(node.period);
+    node.signature = QString("sma(%1,%2)").arg(signature(input)).arg(node.period);
+    return addNode(node);
+}
+
+int IndicatorPipeline::wma(int input, int period)
+{
+    if (!isValidNode(input)) {
+        return -1;
+    }
+    Node node;
+    node.kind = WmaNode;
+    node.inputA = input;
+    node.period = qMax(1, period);
+    node.window = RollingWindow(node.period);
+    node.signature = QString("wma(%1,%2)").arg(signature(input)).arg(node.period);
+    return addNode(node);
+}
+
+int IndicatorPipeline::rsi(int input, int period)
+{
+    if (!isValidNode(input)) {
+        return -1;
+    }
+    Node node;
+    node.kind = RsiNode;
+    node.inputA = input;
+    node.period = qMax(1, period);
+    node.signature = QString("rsi(%1,%2)").arg(signature(input)).arg(node.period);
+    return addNode(node);
+}
+
+int IndicatorPipeline::atr(int period)
+{
+    Node node;
+    node.kind = AtrNode;
+    node.period = qMax(1, period);
+    node.signature = QString("atr(%1)").arg(node.period);
+    return addNode(node);
+}
+
+int IndicatorPipeline::highest(int input, int period)
+{
+    if (!isValidNode(input)) {
+        return -1;
+    }
+    Node node;
+    node.kind = HighestNode;
+    node.inputA = input;
+    node.period = qMax(1, period);
+    node.extremum = MonotonicWindow(node.period, MonotonicWindow::Max);
+    node.signature = QString("highest(%1,%2)").arg(signature(input)).arg(node.period);
+    return addNode(node);
+}
+
+int IndicatorPipeline::lowest(int input, int period)
+{
+    if (!isValidNode(input)) {
+        return -1;
+    }
+    Node node;
+    node.kind = LowestNode;
+    node.inputA = input;
+    node.period = qMax(1, period);
+    node.extremum = MonotonicWindow(node.period, MonotonicWindow::Min);
+    node.signature = QString("lowest(%1,%2)").arg(signature(input)).arg(node.period);
+    return addNode(node);
+}
+
+int IndicatorPipeline::linear(int a, double weightA, int b, double weightB)
+{
+    if (!isValidNode(a) || !isValidNode(b)) {
+        return -1;
+    }
+    Node node;
+    node.kind = LinearNode;
+    node.inputA = a;
+    node.inputB = b;
+    node.weightA = weightA;
+    node.weightB = weightB;
+    node.signature = QString("linear(%1*%2,%3*%4)")
+                         .arg(QString::number(weightA, 'g', 17), signature(a),
+                              QString::number(weightB, 'g', 17), signature(b));
+    return addNode(node);
+}
+
+int IndicatorPipeline::indicator(std::shared_ptr<IndicatorBase> indicator)
+{
+    if (!indicator) {
+        return -1;
+    }
+    Node node;
+    node.kind = IndicatorNode;
+    node.signature = QString("indicator(%1,%2)").arg(static_cast<int>(indicator->type())).arg(indicator->name());
+    node.indicator = indicator;
+    return addNode(node);
+}
+
+std::shared_ptr<IndicatorBase> IndicatorPipeline::indicator(int node) const
+{
+    return isValidNode(node) ? m_nodes[node].indicator : std::shared_ptr<IndicatorBase>();
+}
+
+int IndicatorPipeline::addNode(Node node)
+{
+    auto it = m_index.constFind(node.signature);
+    if (it != m_index.constEnd()) {
+        return it.value();
+    }
+
+    // 补算保留的K线：输入节点都已存在，且至少保存了同样多的值
+    if (node.kind == IndicatorNode) {
+        node.indicator->setMaxLookback(m_maxLookback);
+        node.indicator->calculate(QVector<AppData::MarketData>());
+    }
+    const int backfill = m_maxLookback > 0 ? qMin(m_bars.size(), m_maxLookback) : m_bars.size();
+    node.values.setMaxLookback(m_maxLookback);
+    node.values.reserve(backfill);
+    for (int i = m_bars.size() - backfill; i < m_bars.size(); ++i) {
+        evaluate(node, m_bars[i], m_bars.size() - 1 - i);
+    }
+
+    const int id = m_nodes.size();
+    m_nodes.append(node);
+    m_index.insert(node.signature, id);
+    return id;
+}
+
+void IndicatorPipeline::append(const AppData::MarketData &bar)
+{
+    appendBar(bar);
+    emit updated();
+}
+
+void IndicatorPipeline::appendBar(const AppData::MarketData &bar)
+{
+    // 有最大回看长度时攒够一倍再整体丢弃更早的K线，均摊O(1)
+    if (m_maxLookback > 0 && m_bars.size() >= 2 * m_maxLookback) {
+        m_bars.remove(0, m_bars.size() - m_maxLookback);
+    }
+    m_bars.append(bar);
+    ++m_barCount;
+    for (int i = 0; i < m_nodes.size(); ++i) {
+        evaluate(m_nodes[i], bar, 0);
+    }
+}
+
+void IndicatorPipeline::reset()
+{
+    m_bars.clear();
+    m_barCount = 0;
+    for (Node &node : m_nodes) {
+        resetNode(node);
+    }
+}
+
+void IndicatorPipeline::calculate(const QVector<AppData::MarketData> &data)
+{
+    reset();
+    m_bars.reserve(m_maxLookback > 0 ? qMin(data.size(), 2 * m_maxLookback) : data.size());
+    for (Node &node : m_nodes) {
+        node.values.reserve(data.size());
+    }
+    for (const auto &bar : data) {
+        appendBar(bar);
+    }
+    emit updated();
+}
+
+int IndicatorPipeline::nodeCount() const
+{
+    return m_nodes.size();
+}
+
+int IndicatorPipeline::barCount() const
+{
+    return m_barCount;
+}
+
+QString IndicatorPipeline::signature(int node) const
+{
+    return isValidNode(node) ? m_nodes[node].signature : QString();
+}
+
+int IndicatorPipeline::find(const QString &signature) const
+{
+    return m_index.value(signature, -1);
+}
+
+double IndicatorPipeline::value(int node) const
+{
+    return isValidNode(node) ? m_nodes[node].values.value(0) : kNaN;
+}
+
+SeriesView IndicatorPipeline::values(int node) const
+{
+    return isValidNode(node) ? m_nodes[node].values.view() : SeriesView();
+}
+
+void IndicatorPipeline::resetNode(Node &node)
+{
+    node.count = 0;
+    node.state = 0.0;
+    node.state2 = 0.0;
+    node.last = 0.0;
+    node.window.reset();
+    node.extremum.reset();
+    node.values.clear();
+    if (node.indicator) {
+        node.indicator->calculate(QVector<AppData::MarketData>());
+    }
+}
+
+double IndicatorPipeline::inputValue(int input, int barsAgo) const
+{
+    return m_nodes[input].values.value(barsAgo);
+}
+
+bool IndicatorPipeline::isValidNode(int node) const
+{
+    return node >= 0 && node < m_nodes.size();
+}
+
+void IndicatorPipeline::evaluate(Node &node, const AppData::MarketData &bar, int barsAgo)
+{
+    double result = kNaN;
+
+    switch (node.kind) {
+    case SourceNode:
+        result = fieldValue(node.field, bar);
+        break;
+
+    case EmaNode: {
+        const double x = inputValue(node.inputA, barsAgo);
+        if (std::isnan(x)) {
+            break;
+        }
+        node.state = ++node.count == 1
+            ? x
+            : IndicatorKernels::emaStep(node.state, x, IndicatorKernels::emaMultiplier(node.period));
+        result = node.state;
+        break;
+    }
+
+    case SmaNode:
+    case WmaNode: {
+        const double x = inputValue(node.inputA, barsAgo);
+        if (std::isnan(x)) {
+            break;
+        }
+        node.window.push(x);
+        if (node.window.isFull()) {
+            result = node.kind == SmaNode
+                ? node.window.mean()
+                : node.window.weightedSum() / (node.period * (node.period + 1) / 2.0);
+        }
+        break;
+    }
+
+    case RsiNode: {
+        // 与RSI::append相同：前period个涨跌额先求和，之后按Wilder平滑
+        const double x = inputValue(node.inputA, barsAgo);
+        if (std::isnan(x)) {
+            break;
+        }
+        if (++node.count == 1) {
+            node.last = x;
+            break;
+        }
+        const double change = x - node.last;
+        const int changes = node.count - 1;
+        node.last = x;
+        if (changes <= node.period) {
+            if (change > 0) {
+                node.state += change;
+            } else {
+                node.state2 -= change;
+            }
+            if (changes < node.period) {
+                break;
+            }
+            node.state /= node.period;
+            node.state2 /= node.period;
+        } else {
+            node.state = IndicatorKernels::wilderStep(node.state, change > 0 ? change : 0.0, node.period);
+            node.state2 = IndicatorKernels::wilderStep(node.state2, change < 0 ? -change : 0.0, node.period);
+        }
+        result = IndicatorKernels::rsiValue(node.state, node.state2);
+        break;
+    }
+
+    case AtrNode: {
+        // 与IndicatorKernels::atr相同：首个值为前period个真实波幅的平均
+        double trueRange = bar.high - bar.low;
+        if (node.count > 0) {
+            trueRange = qMax(trueRange, qMax(std::fabs(bar.high - node.last), std::fabs(bar.low - node.last)));
+        }
+        node.last = bar.close;
+        ++node.count;
+        if (node.count <= node.period) {
+            node.state += trueRange;
+            if (node.count < node.period) {
+                break;
+            }
+            node.state /= node.period;
+        } else {
+            node.state = IndicatorKernels::wilderStep(node.state, trueRange, node.period);
+        }
+        result = node.state;
+        break;
+    }
+
+    case HighestNode:
+    case LowestNode: {
+        const double x = inputValue(node.inputA, barsAgo);
+        if (std::isnan(x)) {
+            break;
+        }
+        node.extremum.push(x);
+        if (node.extremum.isFull()) {
+            result = node.extremum.value();
+        }
+        break;
+    }
+
+    case LinearNode: {
+        const double a = inputValue(node.inputA, barsAgo);
+        const double b = inputValue(node.inputB, barsAgo);
+        if (!std::isnan(a) && !std::isnan(b)) {
+            result = node.weightA * a + node.weightB * b;
+        }
+        break;
+    }
+
+    case IndicatorNode:
+        node.indicator->update(bar);
+        if (!node.indicator->values().isEmpty()) {
+            result = node.indicator->lastValue();
+        }
+        break;
+    }
+
+    node.values.append(result);
+}
+
+IndicatorPipelineRegistry::IndicatorPipelineRegistry()
+{
+}
+
+IndicatorPipelineRegistry::~IndicatorPipelineRegistry()
+{
+}
+
+IndicatorPipelineRegistry* IndicatorPipelineRegistry::instance()
+{
+    // 局部静态变量的初始化是线程安全的
+    static IndicatorPipelineRegistry registry;
+    return &registry;
+}
+
+std::shared_ptr<IndicatorPipeline> IndicatorPipelineRegistry::acquire(const QString &symbol,
+                                                                      AppData::TimeFrame timeFrame)
+{
+    QMutexLocker locker(&m_mutex);
+    const QPair<QString, int> key = qMakePair(symbol, static_cast<int>(timeFrame));
+    std::shared_ptr<IndicatorPipeline> pipeline = m_pipelines.value(key).lock();
+    if (!pipeline) {
+        // 顺带清理已销毁的计算图
+        for (auto it = m_pipelines.begin(); it != m_pipelines.end();) {
+            if (it.value().expired()) {
+                it = m_pipelines.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        pipeline = std::make_shared<IndicatorPipeline>();
+        pipeline->setMaxLookback(kDefaultMaxLookback);
+        m_pipelines.insert(key, pipeline);
+    }
+    return pipeline;
+}
+
+std::shared_ptr<IndicatorPipeline> IndicatorPipelineRegistry::find(const QString &symbol,
+                                                                   AppData::TimeFrame timeFrame) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_pipelines.value(qMakePair(symbol, static_cast<int>(timeFrame))).lock();
+}
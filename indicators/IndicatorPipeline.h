@@ -0,0 +1,221 @@
+﻿#ifndef INDICATORPIPELINE_H
+#define INDICATORPIPELINE_H
+
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QVector>
+#include <memory>
+#include "IndicatorBase.h"
+#include "IndicatorSeries.h"
+#include "MonotonicWindow.h"
+#include "RollingWindow.h"
+#include "../AppData.h"
+
+/**
+ * @brief 指标计算图
+ *
+ * 每个节点是一个逐根递推的序列（EMA(close,12)、WMA(x,20)、ATR(14)……），
+ * 节点按签名去重：同一输入上相同参数的节点只创建一次，由所有订阅者共享。
+ * 节点只能引用已存在的节点作为输入，因此创建顺序即拓扑顺序，每根K线按该顺序
+ * 逐个计算一次，每个节点O(1)。
+ *
+ * 预热期或输入为NaN时节点输出NaN，且不推进自身的递推状态，因此嵌套的指标
+ * （如WMA(2*WMA(x,n/2)-WMA(x,n), sqrt(n))）从输入第一个有效值起开始预热。
+ *
+ * 已有的IndicatorBase子类可以作为节点加入，每根K线调用其update()。
+ *
+ * 默认保留全部K线和各节点的完整序列；设置最大回看长度后，节点序列和用于补算的K线
+ * 都只保留最近maxLookback根，长时间运行的实盘会话内存不再增长。此时之后加入的节点
+ * 只按保留的K线补算，递推类节点的初值与从头计算不同。
+ */
+class IndicatorPipeline : public QObject
+{
+    Q_OBJECT
+public:
+    // K线字段
+    enum Field {
+        Open,
+        High,
+        Low,
+        Close,
+        Volume,
+        HL2,        // (最高+最低)/2
+        HLC3        // (最高+最低+收盘)/3
+    };
+
+    explicit IndicatorPipeline(QObject *parent = nullptr);
+    ~IndicatorPipeline() override;
+
+    // 设置最大回看长度，节点序列和K线只保留最近bars根；0表示不限长度（默认）。
+    // 加入的指标对象的结果序列使用同样的长度
+    void setMaxLookback(int bars);
+    int maxLookback() const;
+
+    // 以下函数返回节点编号，签名相同的节点返回已有的编号；
+    // 在已有K线之后加入的节点会先按已有（保留的）K线补算
+
+    // K线字段
+    int source(Field field);
+
+    // 指数移动平均
+    int ema(int input, int period);
+
+    // 简单移动平均
+    int sma(int input, int period);
+
+    // 线性加权移动平均
+    int wma(int input, int period);
+
+    // 相对强弱指数（Wilder平滑）
+    int rsi(int input, int period);
+
+    // 平均真实波幅（Wilder平滑），直接读取K线的最高、最低和收盘价
+    int atr(int period);
+
+    // 区间最大值/最小值
+    int highest(int input, int period);
+    int lowest(int input, int period);
+
+    // 线性组合：weightA * a + weightB * b
+    int linear(int a, double weightA, int b, double weightB);
+
+    /**
+     * @brief 加入已有的指标对象
+     *
+     * 以指标类型和名称为签名，同名指标只保留先加入的对象：传入的对象与已有节点同名时
+     * 返回已有节点的编号，传入的对象不会被加入，也不会被update()，调用方应通过
+     * indicator(int)取得实际被驱动的对象。加入后指标由计算图驱动：
+     * 先清空，再按已有K线逐根update()。节点值为指标的lastValue()，指标尚未产生值时为NaN。
+     */
+    int indicator(std::shared_ptr<IndicatorBase> indicator);
+
+    // 指标节点实际驱动的指标对象，节点不是指标节点时返回空
+    std::shared_ptr<IndicatorBase> indicator(int node) const;
+
+    // 追加一根K线，按拓扑顺序计算所有节点
+    void append(const AppData::MarketData &bar);
+
+    // 清空K线和所有节点的状态，节点保留
+    void reset();
+
+    // 清空后依次追加data中的K线
+    void calculate(const QVector<AppData::MarketData> &data);
+
+    // 节点数
+    int nodeCount() const;
+
+    // 已追加的K线数
+    int barCount() const;
+
+    // 节点签名，如"wma(close,20)"
+    QString signature(int node) const;
+
+    // 按签名查找节点，不存在时返回-1
+    int find(const QString &signature) const;
+
+    // 节点的最新值，没有K线或预热期为NaN
+    double value(int node) const;
+
+    // 节点的序列（只读视图，下一次追加前有效），与保留的最近K线一一对应
+    SeriesView values(int node) const;
+
+signals:
+    // 一根K线的所有节点计算完成
+    void updated();
+
+private:
+    enum NodeKind {
+        SourceNode,
+        EmaNode,
+        SmaNode,
+        WmaNode,
+        RsiNode,
+        AtrNode,
+        HighestNode,
+        LowestNode,
+        LinearNode,
+        IndicatorNode
+    };
+
+    struct Node {
+        NodeKind kind;
+        QString signature;
+        int inputA;
+        int inputB;
+        int period;
+        double weightA;
+        double weightB;
+        Field field;
+        std::shared_ptr<IndicatorBase> indicator;
+
+        // 递推状态
+        int count;                              // 已并入的有效输入个数
+        double state;                           // EMA值、ATR值或平均涨幅
+        double state2;                          // 平均跌幅
+        double last;                            // 上一个输入值（RSI）或上一根收盘价（ATR）
+        RollingWindow window;                   // SMA/WMA窗口
+        MonotonicWindow extremum;               // 区间最值的单调队列
+
+        IndicatorSeries values;
+
+        Node();
+    };
+
+    // 按签名去重后加入节点，并按已有K线补算
+    int addNode(Node node);
+
+    // 清空节点的递推状态和序列
+    static void resetNode(Node &node);
+
+    // 计算节点在bar上的值并追加到序列，bar为最新K线之前barsAgo根（0为最新）
+    void evaluate(Node &node, const AppData::MarketData &bar, int barsAgo);
+
+    // 节点的输入在最新K线之前barsAgo根上的值
+    double inputValue(int input, int barsAgo) const;
+
+    // 追加一根K线，有最大回看长度时丢弃更早的K线
+    void appendBar(const AppData::MarketData &bar);
+
+    bool isValidNode(int node) const;
+
+    QVector<Node> m_nodes;
+    QHash<QString, int> m_index;                // 签名 -> 节点编号
+    QVector<AppData::MarketData> m_bars;        // 用于补算之后加入的节点，有最大回看长度时只保留最近的K线
+    int m_barCount;                             // 已追加的K线总数
+    int m_maxLookback;
+};
+
+/**
+ * @brief 按品种和周期共享指标计算图
+ *
+ * 同一品种、同一周期的策略和图表取得同一个IndicatorPipeline，相同的指标节点只计算一次。
+ * 注册表只保存弱引用，最后一个订阅者释放后计算图随之销毁。所有接口均为线程安全，
+ * 计算图本身应在喂入K线的线程中使用。
+ * 新建的计算图最大回看长度为kDefaultMaxLookback，需要更长历史的订阅者在喂入K线的线程中
+ * 调用setMaxLookback()调大。
+ */
+class IndicatorPipelineRegistry
+{
+public:
+    static const int kDefaultMaxLookback = 5000;
+
+    static IndicatorPipelineRegistry* instance();
+
+    // 获取品种和周期对应的计算图，不存在时创建
+    std::shared_ptr<IndicatorPipeline> acquire(const QString &symbol, AppData::TimeFrame timeFrame);
+
+    // 查找已有的计算图（供行情源喂入K线），不存在时返回空
+    std::shared_ptr<IndicatorPipeline> find(const QString &symbol, AppData::TimeFrame timeFrame) const;
+
+private:
+    IndicatorPipelineRegistry();
+    ~IndicatorPipelineRegistry();
+    Q_DISABLE_COPY(IndicatorPipelineRegistry)
+
+    mutable QMutex m_mutex;
+    QHash<QPair<QString, int>, std::weak_ptr<IndicatorPipeline>> m_pipelines;
+};
+
+#endif // INDICATORPIPELINE_H
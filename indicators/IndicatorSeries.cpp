@@ -0,0 +1,109 @@
+﻿#include "IndicatorSeries.h"
+#include <QtGlobal>
+#include <limits>
+
+double SeriesView::value(int barsAgo) const
+{
+    if (barsAgo < 0 || barsAgo >= m_size) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return m_data[m_size - 1 - barsAgo];
+}
+
+QVector<double> SeriesView::toVector() const
+{
+    QVector<double> result(m_size);
+    for (int i = 0; i < m_size; ++i) {
+        result[i] = m_data[i];
+    }
+    return result;
+}
+
+IndicatorSeries::IndicatorSeries(int maxLookback)
+    : m_capacity(qMax(0, maxLookback))
+    , m_size(0)
+    , m_next(0)
+{
+    if (m_capacity > 0) {
+        m_data.resize(2 * m_capacity);
+    }
+}
+
+void IndicatorSeries::setMaxLookback(int maxLookback)
+{
+    maxLookback = qMax(0, maxLookback);
+    if (maxLookback == m_capacity) {
+        return;
+    }
+
+    const QVector<double> kept = toVector();
+    m_capacity = maxLookback;
+    m_data.clear();
+    if (m_capacity > 0) {
+        m_data.resize(2 * m_capacity);
+    }
+    m_size = 0;
+    m_next = 0;
+    assign(kept.constData(), kept.size());
+}
+
+void IndicatorSeries::clear()
+{
+    if (m_capacity == 0) {
+        m_data.clear();
+    }
+    m_size = 0;
+    m_next = 0;
+}
+
+void IndicatorSeries::reserve(int count)
+{
+    if (m_capacity == 0) {
+        m_data.reserve(count);
+    }
+}
+
+void IndicatorSeries::append(double value)
+{
+    if (m_capacity == 0) {
+        m_data.append(value);
+        ++m_size;
+        return;
+    }
+
+    m_data[m_next] = value;
+    m_data[m_next + m_capacity] = value;
+    m_next = m_next + 1 == m_capacity ? 0 : m_next + 1;
+    if (m_size < m_capacity) {
+        ++m_size;
+    }
+}
+
+void IndicatorSeries::assign(const double *values, int count)
+{
+    clear();
+    reserve(count);
+    const int start = m_capacity > 0 ? qMax(0, count - m_capacity) : 0;
+    for (int i = start; i < count; ++i) {
+        append(values[i]);
+    }
+}
+
+double IndicatorSeries::last() const
+{
+    return view().last();
+}
+
+SeriesView IndicatorSeries::view() const
+{
+    if (m_capacity == 0) {
+        return SeriesView(m_data.constData(), m_size);
+    }
+    if (m_size == 0) {
+        return SeriesView();
+    }
+
+    // 最新值位于latest和latest + m_capacity，往前m_size个值在后一半的镜像中连续
+    const int latest = m_next == 0 ? m_capacity - 1 : m_next - 1;
+    return SeriesView(m_data.constData() + latest + m_capacity - m_size + 1, m_size);
+}
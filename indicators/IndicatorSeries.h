@@ -0,0 +1,96 @@
+﻿#ifndef INDICATORSERIES_H
+#define INDICATORSERIES_H
+
+#include <QVector>
+
+/**
+ * @brief 指标序列的只读视图
+ *
+ * 指向连续double数组的指针和长度，不复制数据也不涉及隐式共享的引用计数。
+ * 按下标访问时从旧到新；value(n)按Pine的习惯从最新往回数，0为最新值。
+ * 视图在所属序列下一次追加或重新计算之前有效，跨线程使用时需由调用方保证
+ * 此期间序列不被修改。
+ */
+class SeriesView
+{
+public:
+    SeriesView() : m_data(nullptr), m_size(0) {}
+    SeriesView(const double *data, int size) : m_data(data), m_size(size) {}
+
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+    const double *data() const { return m_data; }
+    const double *begin() const { return m_data; }
+    const double *end() const { return m_data + m_size; }
+
+    // 第i个值，从旧到新
+    double operator[](int i) const { return m_data[i]; }
+
+    // n根K线之前的值，0为最新值，越界时为NaN
+    double value(int barsAgo = 0) const;
+
+    // 最新值，视图为空时为0
+    double last() const { return m_size > 0 ? m_data[m_size - 1] : 0.0; }
+
+    // 复制为QVector
+    QVector<double> toVector() const;
+
+private:
+    const double *m_data;
+    int m_size;
+};
+
+/**
+ * @brief 指标结果的存储
+ *
+ * 默认不限长度，与原先的QVector相同；设置最大回看长度后改为预先分配的环形缓冲区，
+ * 只保留最近maxLookback个值，长时间运行的实盘会话内存不再增长。
+ * 环形缓冲区的每个值同时写入前后两半（镜像），任意时刻最近的值在内存中都是连续的，
+ * 因此view()始终是零拷贝的连续视图，代价是每次追加写两次。
+ */
+class IndicatorSeries
+{
+public:
+    // maxLookback为0表示不限长度
+    explicit IndicatorSeries(int maxLookback = 0);
+
+    // 设置最大回看长度，保留最近的值；0表示不限长度
+    void setMaxLookback(int maxLookback);
+    int maxLookback() const { return m_capacity; }
+
+    // 清空，不释放环形缓冲区
+    void clear();
+
+    // 不限长度时预留空间，环形缓冲区已预先分配
+    void reserve(int count);
+
+    // 追加一个值，超过最大回看长度时覆盖最旧的值
+    void append(double value);
+
+    // 替换为values[0..count)中最后的maxLookback个值
+    void assign(const double *values, int count);
+
+    // 当前保存的值个数
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+
+    // 最新值，序列为空时为0
+    double last() const;
+
+    // n根K线之前的值，0为最新值，越界时为NaN
+    double value(int barsAgo = 0) const { return view().value(barsAgo); }
+
+    // 当前保存的值的只读视图，从旧到新
+    SeriesView view() const;
+
+    // 复制为QVector
+    QVector<double> toVector() const { return view().toVector(); }
+
+private:
+    QVector<double> m_data;     // 不限长度时为序列本身，否则为2*m_capacity的镜像环形缓冲区
+    int m_capacity;
+    int m_size;
+    int m_next;                 // 环形缓冲区下一个写入位置
+};
+
+#endif // INDICATORSERIES_H
@@ -1,4 +1,5 @@
 ﻿#include "MACD.h"
+#include "IndicatorKernels.h"
 #include "../AppData.h"
 
 
@@ -6,8 +7,15 @@ MACD::MACD(int fastPeriod, int slowPeriod, int signalPeriod, QObject *parent)
     : IndicatorBase(AppData::MACD, parent),
       m_fastPeriod(fastPeriod), 
       m_slowPeriod(slowPeriod), 
-      m_signalPeriod(signalPeriod)
+      m_signalPeriod(signalPeriod),
+      m_barCount(0),
+      m_emaFast(0.0),
+      m_emaSlow(0.0),
+      m_dea(0.0)
 {
+    addSeries(&m_difValues);
+    addSeries(&m_deaValues);
+    addSeries(&m_macdHist);
 }
 
 void MACD::calculate(const QVector<AppData::MarketData> &data)
@@ -15,79 +23,82 @@ void MACD::calculate(const QVector<AppData::MarketData> &data)
     m_difValues.clear();
     m_deaValues.clear();
     m_macdHist.clear();
+    m_barCount = 0;
     
-    if (data.size() < m_slowPeriod + m_signalPeriod) return;
-    
-    // 计算EMA12和EMA26
-    QVector<double> emaFast(data.size());
-    QVector<double> emaSlow(data.size());
-    
-    double fastMultiplier = 2.0 / (m_fastPeriod + 1);
-    double slowMultiplier = 2.0 / (m_slowPeriod + 1);
-    
-    emaFast[0] = data[0].close;
-    emaSlow[0] = data[0].close;
-    
-    for (int i = 1; i < data.size(); ++i) {
-        emaFast[i] = (data[i].close - emaFast[i-1]) * fastMultiplier + emaFast[i-1];
-        emaSlow[i] = (data[i].close - emaSlow[i-1]) * slowMultiplier + emaSlow[i-1];
+    const QVector<double> closes = closePrices(data);
+    if (closes.isEmpty() || closes.size() < m_slowPeriod + m_signalPeriod) {
+        for (double close : closes) {
+            append(close);
+        }
+        return;
     }
     
-    // 计算DIF
-    for (int i = 0; i < data.size(); ++i) {
-        m_difValues.append(emaFast[i] - emaSlow[i]);
-    }
-    
-    // 计算DEA
-    double deaMultiplier = 2.0 / (m_signalPeriod + 1);
-    m_deaValues.append(m_difValues[0]);
-    
-    for (int i = 1; i < m_difValues.size(); ++i) {
-        double dea = (m_difValues[i] - m_deaValues.last()) * deaMultiplier + m_deaValues.last();
-        m_deaValues.append(dea);
-    }
-    
-    // 计算MACD柱
-    for (int i = 0; i < m_difValues.size(); ++i) {
-        m_macdHist.append(m_difValues[i] - m_deaValues[i]);
-    }
+    // DIF、DEA和柱均以第一根收盘价为初值，从下标0起有效；同时取回快慢线供实时更新接续
+    QVector<double> dif(closes.size());
+    QVector<double> dea(closes.size());
+    QVector<double> hist(closes.size());
+    IndicatorKernels::macd(closes.constData(), closes.size(), m_fastPeriod, m_slowPeriod, m_signalPeriod,
+                           dif.data(), dea.data(), hist.data(), &m_emaFast, &m_emaSlow);
+    m_difValues.assign(dif.constData(), dif.size());
+    m_deaValues.assign(dea.constData(), dea.size());
+    m_macdHist.assign(hist.constData(), hist.size());
+    m_dea = dea.last();
+    m_barCount = closes.size();
     
     emit indicatorUpdated();
 }
 
 void MACD::update(const AppData::MarketData &newData)
 {
-    // 需要维护足够的历史数据才能实时更新MACD
-    // 实际实现中需要保存足够的历史数据
+    append(newData.close);
     emit indicatorUpdated();
 }
 
+void MACD::append(double close)
+{
+    if (++m_barCount == 1) {
+        m_emaFast = close;
+        m_emaSlow = close;
+    } else {
+        m_emaFast = IndicatorKernels::emaStep(m_emaFast, close, IndicatorKernels::emaMultiplier(m_fastPeriod));
+        m_emaSlow = IndicatorKernels::emaStep(m_emaSlow, close, IndicatorKernels::emaMultiplier(m_slowPeriod));
+    }
+    
+    const double dif = m_emaFast - m_emaSlow;
+    m_dea = m_barCount == 1
+        ? dif
+        : IndicatorKernels::emaStep(m_dea, dif, IndicatorKernels::emaMultiplier(m_signalPeriod));
+    m_difValues.append(dif);
+    m_deaValues.append(m_dea);
+    m_macdHist.append(dif - m_dea);
+}
+
 QString MACD::name() const
 {
     return QString("MACD(%1,%2,%3)").arg(m_fastPeriod).arg(m_slowPeriod).arg(m_signalPeriod);
 }
 
-QVector<double> MACD::values() const
+SeriesView MACD::values() const
 {
-    return m_macdHist;
+    return macdHist();
 }
 
 double MACD::lastValue() const
 {
-    return m_macdHist.isEmpty() ? 0.0 : m_macdHist.last();
+    return hasEnoughData() && !m_macdHist.isEmpty() ? m_macdHist.last() : 0.0;
 }
 
-QVector<double> MACD::difLine() const
+SeriesView MACD::difLine() const
 {
-    return m_difValues;
+    return hasEnoughData() ? m_difValues.view() : SeriesView();
 }
 
-QVector<double> MACD::deaLine() const
+SeriesView MACD::deaLine() const
 {
-    return m_deaValues;
+    return hasEnoughData() ? m_deaValues.view() : SeriesView();
 }
 
-QVector<double> MACD::macdHist() const
+SeriesView MACD::macdHist() const
 {
-    return m_macdHist;
+    return hasEnoughData() ? m_macdHist.view() : SeriesView();
 }
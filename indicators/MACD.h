@@ -19,27 +19,39 @@ public:
     QString name() const override;
     
     // 获取计算结果
-    QVector<double> values() const override;
+    SeriesView values() const override;
     
     // 获取最新值
     double lastValue() const override;
 
     // 获取DIF线
-    QVector<double> difLine() const;
+    SeriesView difLine() const;
     
     // 获取DEA线
-    QVector<double> deaLine() const;
+    SeriesView deaLine() const;
     
     // 获取MACD柱
-    QVector<double> macdHist() const;
+    SeriesView macdHist() const;
 
 private:
+    // 并入一根K线的收盘价
+    void append(double close);
+
+    // K线数不少于slowPeriod + signalPeriod时才对外提供指标值，与整段计算的规则一致
+    bool hasEnoughData() const { return m_barCount >= m_slowPeriod + m_signalPeriod; }
+
     int m_fastPeriod;
     int m_slowPeriod;
     int m_signalPeriod;
-    QVector<double> m_difValues;
-    QVector<double> m_deaValues;
-    QVector<double> m_macdHist;
+    IndicatorSeries m_difValues;
+    IndicatorSeries m_deaValues;
+    IndicatorSeries m_macdHist;
+
+    // 递推状态
+    int m_barCount;
+    double m_emaFast;
+    double m_emaSlow;
+    double m_dea;
 };
 
 #endif // MACD_H
\ No newline at end of file
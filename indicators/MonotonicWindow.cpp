@@ -0,0 +1,56 @@
+﻿#include "MonotonicWindow.h"
+#include <QtGlobal>
+
+MonotonicWindow::MonotonicWindow(int period, Mode mode)
+    : m_period(qMax(1, period))
+    , m_mode(mode)
+    , m_values(m_period, 0.0)
+    , m_positions(m_period, 0)
+    , m_head(0)
+    , m_size(0)
+    , m_count(0)
+{
+}
+
+void MonotonicWindow::reset()
+{
+    m_head = 0;
+    m_size = 0;
+    m_count = 0;
+}
+
+void MonotonicWindow::push(double value)
+{
+    // 队首移出窗口：每次最多有一个值过期
+    if (m_size > 0 && m_positions[m_head] <= m_count - m_period) {
+        m_head = m_head + 1 == m_period ? 0 : m_head + 1;
+        --m_size;
+    }
+
+    // 弹出队尾所有不优于新值的值
+    while (m_size > 0) {
+        int back = m_head + m_size - 1;
+        if (back >= m_period) {
+            back -= m_period;
+        }
+        const bool dominated = m_mode == Max ? m_values[back] <= value : m_values[back] >= value;
+        if (!dominated) {
+            break;
+        }
+        --m_size;
+    }
+
+    int tail = m_head + m_size;
+    if (tail >= m_period) {
+        tail -= m_period;
+    }
+    m_values[tail] = value;
+    m_positions[tail] = m_count;
+    ++m_size;
+    ++m_count;
+}
+
+double MonotonicWindow::value() const
+{
+    return m_size > 0 ? m_values[m_head] : 0.0;
+}
@@ -0,0 +1,52 @@
+﻿#ifndef MONOTONICWINDOW_H
+#define MONOTONICWINDOW_H
+
+#include <QVector>
+
+/**
+ * @brief 定长滑动窗口的最大值或最小值
+ *
+ * 单调队列：队列中的值按加入顺序排列且单调（求最大值时递减），队首即窗口内的最值。
+ * 新值加入时从队尾弹出所有不优于它的值，每个值最多进出队列各一次，
+ * 每次push均摊O(1)，与窗口长度无关。队列长度不超过窗口长度，用定长环形缓冲区保存，
+ * 构造后不再分配内存。
+ */
+class MonotonicWindow
+{
+public:
+    enum Mode {
+        Max,    // 窗口最大值
+        Min     // 窗口最小值
+    };
+
+    explicit MonotonicWindow(int period = 1, Mode mode = Max);
+
+    // 清空窗口
+    void reset();
+
+    // 加入新值，窗口已满时最旧的值移出窗口
+    void push(double value);
+
+    // 窗口长度
+    int period() const { return m_period; }
+
+    // 已加入的值个数
+    qint64 count() const { return m_count; }
+
+    // 窗口是否已满
+    bool isFull() const { return m_count >= m_period; }
+
+    // 窗口内的最值，窗口为空时为0
+    double value() const;
+
+private:
+    int m_period;
+    Mode m_mode;
+    QVector<double> m_values;       // 队列的环形缓冲区
+    QVector<qint64> m_positions;    // 对应值的加入序号
+    int m_head;                     // 队首位置
+    int m_size;                     // 队列长度
+    qint64 m_count;
+};
+
+#endif // MONOTONICWINDOW_H
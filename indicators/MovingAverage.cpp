@@ -1,49 +1,45 @@
 ﻿#include "MovingAverage.h"
+#include "IndicatorKernels.h"
 #include "../AppData.h"
 
 MovingAverage::MovingAverage(int period, MAType maType, QObject *parent)
-    : IndicatorBase(AppData::MA, parent), m_period(period), m_maType(maType)
+    : IndicatorBase(AppData::MA, parent), m_period(period), m_maType(maType),
+      m_barCount(0), m_ema(0.0), m_window(period)
 {
+    addSeries(&m_values);
 }
 
 void MovingAverage::calculate(const QVector<AppData::MarketData> &data)
 {
     m_values.clear();
-    if (data.size() < m_period) return;
+    m_window.reset();
+    m_barCount = 0;
+    m_ema = 0.0;
 
-    switch (m_maType) {
-    case SMA: {
-        for (int i = m_period - 1; i < data.size(); ++i) {
-            double sum = 0.0;
-            for (int j = 0; j < m_period; ++j) {
-                sum += data[i - j].close;
-            }
-            m_values.append(sum / m_period);
-        }
-        break;
-    }
-    case EMA: {
-        double multiplier = 2.0 / (m_period + 1);
-        double ema = data[0].close;
-        m_values.append(ema);
-        
-        for (int i = 1; i < data.size(); ++i) {
-            ema = (data[i].close - ema) * multiplier + ema;
-            m_values.append(ema);
+    const QVector<double> closes = closePrices(data);
+    if (closes.size() < m_period) {
+        for (double close : closes) {
+            append(close);
         }
-        break;
+        return;
     }
-    case WMA: {
-        double weightSum = m_period * (m_period + 1) / 2.0;
-        for (int i = m_period - 1; i < data.size(); ++i) {
-            double sum = 0.0;
-            for (int j = 0; j < m_period; ++j) {
-                sum += data[i - j].close * (j + 1);
-            }
-            m_values.append(sum / weightSum);
-        }
-        break;
+
+    // 整段计算交给批量内核，结果去掉窗口未满的部分
+    QVector<double> buffer(closes.size());
+    switch (m_maType) {
+    case SMA: IndicatorKernels::sma(closes.constData(), closes.size(), m_period, buffer.data()); break;
+    case EMA: IndicatorKernels::ema(closes.constData(), closes.size(), m_period, buffer.data()); break;
+    case WMA: IndicatorKernels::wma(closes.constData(), closes.size(), m_period, buffer.data()); break;
     }
+    const int warmup = m_maType == EMA ? 0 : m_period - 1;
+    m_values.assign(buffer.constData() + warmup, buffer.size() - warmup);
+
+    // 恢复递推状态，之后的实时更新与整段重新计算逐位一致
+    m_barCount = closes.size();
+    if (m_maType == EMA) {
+        m_ema = buffer.last();
+    } else {
+        m_window.restore(closes.constData(), closes.size());
     }
     
     emit indicatorUpdated();
@@ -51,30 +47,37 @@ void MovingAverage::calculate(const QVector<AppData::MarketData> &data)
 
 void MovingAverage::update(const AppData::MarketData &newData)
 {
-    if (m_values.isEmpty()) {
-        m_values.append(newData.close);
-        return;
-    }
+    append(newData.close);
+    emit indicatorUpdated();
+}
 
+void MovingAverage::append(double close)
+{
+    ++m_barCount;
     switch (m_maType) {
     case SMA: {
-        // 需要维护一个数据窗口来更新SMA
+        m_window.push(close);
+        if (m_window.isFull()) {
+            m_values.append(m_window.mean());
+        }
         break;
     }
     case EMA: {
-        double multiplier = 2.0 / (m_period + 1);
-        double lastEma = m_values.last();
-        double newEma = (newData.close - lastEma) * multiplier + lastEma;
-        m_values.append(newEma);
+        m_ema = m_barCount == 1
+            ? close
+            : IndicatorKernels::emaStep(m_ema, close, IndicatorKernels::emaMultiplier(m_period));
+        m_values.append(m_ema);
         break;
     }
     case WMA: {
-        // 需要维护一个数据窗口来更新WMA
+        m_window.push(close);
+        if (m_window.isFull()) {
+            double weightSum = m_window.period() * (m_window.period() + 1) / 2.0;
+            m_values.append(m_window.weightedSum() / weightSum);
+        }
         break;
     }
     }
-    
-    emit indicatorUpdated();
 }
 
 QString MovingAverage::name() const
@@ -87,12 +90,12 @@ QString MovingAverage::name() const
     return QString();
 }
 
-QVector<double> MovingAverage::values() const
+SeriesView MovingAverage::values() const
 {
-    return m_values;
+    return hasEnoughData() ? m_values.view() : SeriesView();
 }
 
 double MovingAverage::lastValue() const
 {
-    return m_values.isEmpty() ? 0.0 : m_values.last();
+    return hasEnoughData() && !m_values.isEmpty() ? m_values.last() : 0.0;
 }
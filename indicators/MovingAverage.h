@@ -2,6 +2,7 @@
 #define MOVINGAVERAGE_H
 
 #include "IndicatorBase.h"
+#include "RollingWindow.h"
 
 class MovingAverage : public IndicatorBase
 {
@@ -25,15 +26,24 @@ public:
     QString name() const override;
     
     // 获取计算结果
-    QVector<double> values() const override;
+    SeriesView values() const override;
     
     // 获取最新值
     double lastValue() const override;
 
 private:
+    // 并入一根K线的收盘价，SMA/WMA窗口满后才产生指标值
+    void append(double close);
+
+    // K线数不少于周期时才对外提供指标值，与整段计算的规则一致
+    bool hasEnoughData() const { return m_barCount >= m_period; }
+
     int m_period;
     MAType m_maType;
-    QVector<double> m_values;
+    IndicatorSeries m_values;
+    int m_barCount;
+    double m_ema;               // EMA的递推状态
+    RollingWindow m_window;     // SMA/WMA的递推状态
 };
 
 #endif // MOVINGAVERAGE_H
\ No newline at end of file
@@ -1,77 +1,80 @@
 ﻿#include "RSI.h"
-#include <cmath>
+#include "IndicatorKernels.h"
 #include "../AppData.h"
 
 RSI::RSI(int period, QObject *parent)
     : IndicatorBase(AppData::RSI, parent),
       m_period(period),
+      m_barCount(0),
       m_lastClose(0.0),
       m_avgGain(0.0),
       m_avgLoss(0.0)
 {
+    addSeries(&m_values);
 }
 
 void RSI::calculate(const QVector<AppData::MarketData> &data)
 {
     m_values.clear();
-    if (data.size() <= m_period) return;
+    m_barCount = 0;
+    m_lastClose = 0.0;
+    m_avgGain = 0.0;
+    m_avgLoss = 0.0;
     
-    // 计算初始平均增益和平均损失
-    double sumGain = 0.0;
-    double sumLoss = 0.0;
-    
-    for (int i = 1; i <= m_period; ++i) {
-        double change = data[i].close - data[i-1].close;
-        if (change > 0) {
-            sumGain += change;
-        } else {
-            sumLoss += std::abs(change);
+    const QVector<double> closes = closePrices(data);
+    if (closes.size() <= m_period) {
+        for (double close : closes) {
+            append(close);
         }
+        return;
     }
     
-    m_avgGain = sumGain / m_period;
-    m_avgLoss = sumLoss / m_period;
-    
-    // 计算第一个RSI值
-    double rs = m_avgLoss == 0.0 ? 100.0 : 100.0 - (100.0 / (1.0 + m_avgGain / m_avgLoss));
-    m_values.append(rs);
+    // 整段计算交给批量内核，同时取回最后的平均涨跌幅供实时更新接续
+    QVector<double> buffer(closes.size());
+    IndicatorKernels::rsi(closes.constData(), closes.size(), m_period, buffer.data(),
+                          &m_avgGain, &m_avgLoss);
+    m_values.assign(buffer.constData() + m_period, buffer.size() - m_period);
     
-    // 计算后续RSI值
-    for (int i = m_period + 1; i < data.size(); ++i) {
-        double change = data[i].close - data[i-1].close;
-        double gain = change > 0 ? change : 0.0;
-        double loss = change < 0 ? std::abs(change) : 0.0;
-        
-        m_avgGain = (m_avgGain * (m_period - 1) + gain) / m_period;
-        m_avgLoss = (m_avgLoss * (m_period - 1) + loss) / m_period;
-        
-        double rs = m_avgLoss == 0.0 ? 100.0 : 100.0 - (100.0 / (1.0 + m_avgGain / m_avgLoss));
-        m_values.append(rs);
-    }
-    
-    m_lastClose = data.last().close;
+    m_barCount = closes.size();
+    m_lastClose = closes.last();
     emit indicatorUpdated();
 }
 
 void RSI::update(const AppData::MarketData &newData)
 {
-    if (m_values.isEmpty()) {
-        m_lastClose = newData.close;
+    append(newData.close);
+    emit indicatorUpdated();
+}
+
+void RSI::append(double close)
+{
+    if (++m_barCount == 1) {
+        m_lastClose = close;
         return;
     }
     
-    double change = newData.close - m_lastClose;
-    double gain = change > 0 ? change : 0.0;
-    double loss = change < 0 ? std::abs(change) : 0.0;
-    
-    m_avgGain = (m_avgGain * (m_period - 1) + gain) / m_period;
-    m_avgLoss = (m_avgLoss * (m_period - 1) + loss) / m_period;
+    const double change = close - m_lastClose;
+    const int changes = m_barCount - 1;
+    m_lastClose = close;
     
-    double rs = m_avgLoss == 0.0 ? 100.0 : 100.0 - (100.0 / (1.0 + m_avgGain / m_avgLoss));
-    m_values.append(rs);
-    m_lastClose = newData.close;
+    if (changes <= m_period) {
+        // 第period个涨跌额到来时由和得到初始平均涨跌幅
+        if (change > 0) {
+            m_avgGain += change;
+        } else {
+            m_avgLoss -= change;
+        }
+        if (changes < m_period) {
+            return;
+        }
+        m_avgGain /= m_period;
+        m_avgLoss /= m_period;
+    } else {
+        m_avgGain = IndicatorKernels::wilderStep(m_avgGain, change > 0 ? change : 0.0, m_period);
+        m_avgLoss = IndicatorKernels::wilderStep(m_avgLoss, change < 0 ? -change : 0.0, m_period);
+    }
     
-    emit indicatorUpdated();
+    m_values.append(IndicatorKernels::rsiValue(m_avgGain, m_avgLoss));
 }
 
 QString RSI::name() const
@@ -79,9 +82,9 @@ QString RSI::name() const
     return QString("RSI(%1)").arg(m_period);
 }
 
-QVector<double> RSI::values() const
+SeriesView RSI::values() const
 {
-    return m_values;
+    return m_values.view();
 }
 
 double RSI::lastValue() const
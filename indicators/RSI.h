@@ -19,17 +19,21 @@ public:
     QString name() const override;
     
     // 获取计算结果
-    QVector<double> values() const override;
+    SeriesView values() const override;
     
     // 获取最新值
     double lastValue() const override;
 
 private:
+    // 并入一根K线的收盘价，前period个涨跌额只求和，之后按Wilder平滑
+    void append(double close);
+
     int m_period;
-    QVector<double> m_values;
+    IndicatorSeries m_values;
+    int m_barCount;
     double m_lastClose;
-    double m_avgGain;
-    double m_avgLoss;
+    double m_avgGain;           // 前period个涨跌额期间为涨幅之和
+    double m_avgLoss;           // 前period个涨跌额期间为跌幅之和
 };
 
 #endif // RSI_H
\ No newline at end of file
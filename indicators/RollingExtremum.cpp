@@ -0,0 +1,56 @@
+﻿#include "RollingExtremum.h"
+#include "../AppData.h"
+
+RollingExtremum::RollingExtremum(int period, Mode mode, QObject *parent)
+    : IndicatorBase(mode == Highest ? AppData::HIGHEST : AppData::LOWEST, parent),
+      m_period(qMax(1, period)),
+      m_mode(mode),
+      m_window(m_period, mode == Highest ? MonotonicWindow::Max : MonotonicWindow::Min)
+{
+    addSeries(&m_values);
+}
+
+void RollingExtremum::calculate(const QVector<AppData::MarketData> &data)
+{
+    m_values.clear();
+    m_window.reset();
+    
+    // 单调队列逐根推进，整段计算为O(n)，与实时更新共用同一套状态
+    m_values.reserve(qMax(0, data.size() - m_period + 1));
+    for (const auto &bar : data) {
+        append(bar);
+    }
+    
+    if (!m_values.isEmpty()) {
+        emit indicatorUpdated();
+    }
+}
+
+void RollingExtremum::update(const AppData::MarketData &newData)
+{
+    append(newData);
+    emit indicatorUpdated();
+}
+
+void RollingExtremum::append(const AppData::MarketData &bar)
+{
+    m_window.push(m_mode == Highest ? bar.high : bar.low);
+    if (m_window.isFull()) {
+        m_values.append(m_window.value());
+    }
+}
+
+QString RollingExtremum::name() const
+{
+    return QString(m_mode == Highest ? "Highest(%1)" : "Lowest(%1)").arg(m_period);
+}
+
+SeriesView RollingExtremum::values() const
+{
+    return m_values.view();
+}
+
+double RollingExtremum::lastValue() const
+{
+    return m_values.isEmpty() ? 0.0 : m_values.last();
+}
@@ -0,0 +1,44 @@
+﻿#ifndef ROLLINGEXTREMUM_H
+#define ROLLINGEXTREMUM_H
+
+#include "IndicatorBase.h"
+#include "MonotonicWindow.h"
+
+// 区间最高价/最低价：最近period根K线最高价的最大值或最低价的最小值
+class RollingExtremum : public IndicatorBase
+{
+    Q_OBJECT
+public:
+    enum Mode {
+        Highest,    // 区间最高价
+        Lowest      // 区间最低价
+    };
+
+    explicit RollingExtremum(int period, Mode mode = Highest, QObject *parent = nullptr);
+    
+    // 计算指标值
+    void calculate(const QVector<AppData::MarketData> &data) override;
+    
+    // 实时更新指标
+    void update(const AppData::MarketData &newData) override;
+    
+    // 获取指标名称
+    QString name() const override;
+    
+    // 获取计算结果
+    SeriesView values() const override;
+    
+    // 获取最新值
+    double lastValue() const override;
+
+private:
+    // 并入一根K线，窗口满后才产生指标值
+    void append(const AppData::MarketData &bar);
+
+    int m_period;
+    Mode m_mode;
+    IndicatorSeries m_values;
+    MonotonicWindow m_window;
+};
+
+#endif // ROLLINGEXTREMUM_H
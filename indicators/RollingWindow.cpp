@@ -0,0 +1,122 @@
+﻿#include "RollingWindow.h"
+#include <QtGlobal>
+#include <cmath>
+
+RollingWindow::RollingWindow(int period)
+    : m_buffer(qMax(1, period), 0.0)
+    , m_head(0)
+    , m_count(0)
+    , m_sum(0.0)
+    , m_compensation(0.0)
+    , m_mean(0.0)
+    , m_m2(0.0)
+    , m_weightedSum(0.0)
+{
+}
+
+void RollingWindow::reset()
+{
+    m_buffer.fill(0.0);
+    m_head = 0;
+    m_count = 0;
+    m_sum = 0.0;
+    m_compensation = 0.0;
+    m_mean = 0.0;
+    m_m2 = 0.0;
+    m_weightedSum = 0.0;
+}
+
+void RollingWindow::push(double value)
+{
+    const int period = m_buffer.size();
+
+    if (m_count < period) {
+        // 窗口未满：新值的权重为当前个数
+        ++m_count;
+        const double delta = value - m_mean;
+        m_mean += delta / m_count;
+        m_m2 += delta * (value - m_mean);
+        m_weightedSum += m_count * value;
+
+        const double y = value - m_compensation;
+        const double t = m_sum + y;
+        m_compensation = (t - m_sum) - y;
+        m_sum = t;
+    } else {
+        // 窗口已满：移出最旧值，其余值权重各减1
+        const double oldest = m_buffer[m_head];
+        const double oldMean = m_mean;
+        m_mean += (value - oldest) / period;
+        m_m2 += (value - oldest) * (value - m_mean + oldest - oldMean);
+        m_weightedSum += period * value - m_sum;
+
+        const double y = (value - oldest) - m_compensation;
+        const double t = m_sum + y;
+        m_compensation = (t - m_sum) - y;
+        m_sum = t;
+    }
+
+    m_buffer[m_head] = value;
+    m_head = m_head + 1 == period ? 0 : m_head + 1;
+
+    if (m_head == 0 && m_count == period) {
+        recompute();
+    }
+}
+
+void RollingWindow::restore(const double *values, int count)
+{
+    reset();
+
+    // 重新计算发生在第period、2*period……个值之后，从最后一次重新计算的窗口起点开始重放
+    const int period = m_buffer.size();
+    const int start = count < period ? 0 : (count / period - 1) * period;
+    for (int i = start; i < count; ++i) {
+        push(values[i]);
+    }
+}
+
+double RollingWindow::mean() const
+{
+    return m_count > 0 ? m_sum / m_count : 0.0;
+}
+
+double RollingWindow::variance() const
+{
+    // 浮点误差可能使离差平方和略小于0
+    return m_count > 0 ? qMax(0.0, m_m2 / m_count) : 0.0;
+}
+
+double RollingWindow::stddev() const
+{
+    return std::sqrt(variance());
+}
+
+void RollingWindow::recompute()
+{
+    // 只在窗口已满且m_head为0时调用，此时缓冲区按从旧到新的顺序排列
+    const int period = m_buffer.size();
+    double sum = 0.0;
+    double compensation = 0.0;
+    double weightedSum = 0.0;
+    for (int i = 0; i < period; ++i) {
+        const double y = m_buffer[i] - compensation;
+        const double t = sum + y;
+        compensation = (t - sum) - y;
+        sum = t;
+        weightedSum += (i + 1) * m_buffer[i];
+    }
+
+    const double mean = sum / period;
+    double m2 = 0.0;
+    for (int i = 0; i < period; ++i) {
+        const double deviation = m_buffer[i] - mean;
+        m2 += deviation * deviation;
+    }
+
+    m_sum = sum;
+    m_compensation = 0.0;
+    m_mean = mean;
+    m_m2 = m2;
+    m_weightedSum = weightedSum;
+}
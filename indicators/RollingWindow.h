@@ -0,0 +1,70 @@
+﻿#ifndef ROLLINGWINDOW_H
+#define ROLLINGWINDOW_H
+
+#include <QVector>
+
+/**
+ * @brief 定长滑动窗口及其滚动统计量
+ *
+ * 用环形缓冲区保存最近period个值，每次push为O(1)：
+ *   - 和：Kahan补偿求和
+ *   - 方差：滑动Welford更新均值和离差平方和
+ *   - 线性加权和：最新值权重为period，最旧值权重为1
+ * 缓冲区每绕回一圈按窗口内的值重新计算一次各统计量，消除长时间运行的
+ * 累积误差，均摊开销仍为O(1)。
+ */
+class RollingWindow
+{
+public:
+    explicit RollingWindow(int period = 1);
+
+    // 清空窗口
+    void reset();
+
+    // 加入新值，窗口已满时移出最旧的值
+    void push(double value);
+
+    // 恢复为依次push了values[0..count)之后的状态；只需重放最近一次按窗口重新计算以来的值，
+    // 结果与逐个push完全相同
+    void restore(const double *values, int count);
+
+    // 窗口长度
+    int period() const { return m_buffer.size(); }
+
+    // 窗口内的值个数
+    int count() const { return m_count; }
+
+    // 窗口是否已满
+    bool isFull() const { return m_count == m_buffer.size(); }
+
+    // 窗口内值的和
+    double sum() const { return m_sum; }
+
+    // 窗口内值的平均
+    double mean() const;
+
+    // 窗口内值的总体方差
+    double variance() const;
+
+    // 窗口内值的总体标准差
+    double stddev() const;
+
+    // 线性加权和，最旧的值权重为1，依次递增
+    double weightedSum() const { return m_weightedSum; }
+
+private:
+    // 按窗口内的值重新计算各统计量
+    void recompute();
+
+    QVector<double> m_buffer;   // 环形缓冲区
+    int m_head;                 // 下一个写入位置，窗口满时也是最旧值的位置
+    int m_count;
+
+    double m_sum;
+    double m_compensation;      // Kahan补偿项
+    double m_mean;
+    double m_m2;                // 离差平方和
+    double m_weightedSum;
+};
+
+#endif // ROLLINGWINDOW_H
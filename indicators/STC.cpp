@@ -0,0 +1,109 @@
+﻿#include "STC.h"
+#include "IndicatorKernels.h"
+#include "../AppData.h"
+
+STC::STC(int cycleLength, int fastLength, int slowLength, double factor, QObject *parent)
+    : IndicatorBase(AppData::STC, parent),
+      m_cycleLength(qMax(1, cycleLength)),
+      m_fastLength(fastLength),
+      m_slowLength(slowLength),
+      m_factor(factor),
+      m_barCount(0),
+      m_emaFast(0.0),
+      m_emaSlow(0.0),
+      m_macdHighest(m_cycleLength, MonotonicWindow::Max),
+      m_macdLowest(m_cycleLength, MonotonicWindow::Min),
+      m_macdStoch(0.0),
+      m_macdSmooth(0.0),
+      m_smoothHighest(m_cycleLength, MonotonicWindow::Max),
+      m_smoothLowest(m_cycleLength, MonotonicWindow::Min),
+      m_smoothStoch(0.0),
+      m_stc(0.0)
+{
+    addSeries(&m_values);
+}
+
+void STC::calculate(const QVector<AppData::MarketData> &data)
+{
+    m_values.clear();
+    m_barCount = 0;
+    m_emaFast = 0.0;
+    m_emaSlow = 0.0;
+    m_macdHighest.reset();
+    m_macdLowest.reset();
+    m_macdStoch = 0.0;
+    m_macdSmooth = 0.0;
+    m_smoothHighest.reset();
+    m_smoothLowest.reset();
+    m_smoothStoch = 0.0;
+    m_stc = 0.0;
+    
+    // 两级归一化的区间最值由单调队列维护，整段计算为O(n)，与实时更新共用同一套状态
+    m_values.reserve(data.size());
+    for (const auto &bar : data) {
+        append(bar.close);
+    }
+    
+    if (!m_values.isEmpty()) {
+        emit indicatorUpdated();
+    }
+}
+
+void STC::update(const AppData::MarketData &newData)
+{
+    append(newData.close);
+    emit indicatorUpdated();
+}
+
+void STC::append(double close)
+{
+    if (++m_barCount == 1) {
+        m_emaFast = close;
+        m_emaSlow = close;
+    } else {
+        m_emaFast = IndicatorKernels::emaStep(m_emaFast, close, IndicatorKernels::emaMultiplier(m_fastLength));
+        m_emaSlow = IndicatorKernels::emaStep(m_emaSlow, close, IndicatorKernels::emaMultiplier(m_slowLength));
+    }
+    const double macd = m_emaFast - m_emaSlow;
+    
+    // 第一次归一化和平滑
+    m_macdHighest.push(macd);
+    m_macdLowest.push(macd);
+    if (m_macdHighest.isFull()) {
+        const double lowest = m_macdLowest.value();
+        const double range = m_macdHighest.value() - lowest;
+        if (range > 0) {
+            m_macdStoch = (macd - lowest) / range * 100.0;
+        }
+    }
+    m_macdSmooth += m_factor * (m_macdStoch - m_macdSmooth);
+    
+    // 第二次归一化和平滑
+    m_smoothHighest.push(m_macdSmooth);
+    m_smoothLowest.push(m_macdSmooth);
+    if (m_smoothHighest.isFull()) {
+        const double lowest = m_smoothLowest.value();
+        const double range = m_smoothHighest.value() - lowest;
+        if (range > 0) {
+            m_smoothStoch = (m_macdSmooth - lowest) / range * 100.0;
+        }
+    }
+    m_stc += m_factor * (m_smoothStoch - m_stc);
+    
+    m_values.append(m_stc);
+}
+
+QString STC::name() const
+{
+    return QString("STC(%1,%2,%3,%4)").arg(m_cycleLength).arg(m_fastLength).arg(m_slowLength).arg(m_factor);
+}
+
+SeriesView STC::values() const
+{
+    return m_values.view();
+}
+
+double STC::lastValue() const
+{
+    return m_values.isEmpty() ? 0.0 : m_values.last();
+}
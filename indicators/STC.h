@@ -0,0 +1,61 @@
+﻿#ifndef STC_H
+#define STC_H
+
+#include "IndicatorBase.h"
+#include "MonotonicWindow.h"
+
+/**
+ * @brief Schaff趋势周期（STC）
+ *
+ * 对MACD（快慢EMA之差）在cycleLength根内做两次随机指标式的归一化，
+ * 每次归一化后按factor做一阶平滑，结果在0到100之间。区间未满或区间内
+ * 最高等于最低时沿用上一次的归一化值，与TradingView的常见实现一致。
+ * 从第一根K线起即有值。
+ */
+class STC : public IndicatorBase
+{
+    Q_OBJECT
+public:
+    explicit STC(int cycleLength = 80, int fastLength = 27, int slowLength = 50,
+                 double factor = 0.5, QObject *parent = nullptr);
+    
+    // 计算指标值
+    void calculate(const QVector<AppData::MarketData> &data) override;
+    
+    // 实时更新指标
+    void update(const AppData::MarketData &newData) override;
+    
+    // 获取指标名称
+    QString name() const override;
+    
+    // 获取计算结果
+    SeriesView values() const override;
+    
+    // 获取最新值
+    double lastValue() const override;
+
+private:
+    // 并入一根K线的收盘价
+    void append(double close);
+
+    int m_cycleLength;
+    int m_fastLength;
+    int m_slowLength;
+    double m_factor;
+    IndicatorSeries m_values;
+
+    // 递推状态
+    int m_barCount;
+    double m_emaFast;
+    double m_emaSlow;
+    MonotonicWindow m_macdHighest;
+    MonotonicWindow m_macdLowest;
+    double m_macdStoch;         // MACD的归一化值
+    double m_macdSmooth;        // 平滑后的MACD归一化值
+    MonotonicWindow m_smoothHighest;
+    MonotonicWindow m_smoothLowest;
+    double m_smoothStoch;       // 第二次归一化值
+    double m_stc;               // 平滑后的第二次归一化值，即STC
+};
+
+#endif // STC_H
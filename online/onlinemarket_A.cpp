@@ -1,4 +1,5 @@
 #include "onlinemarket_A.h"
+#include "../global/SymbolTable.h"
 #include <QUrlQuery>
 #include <QRandomGenerator>
 
@@ -297,6 +298,7 @@ void onLineMarket_A::parseMarketData(const QByteArray &data)
     // 创建MarketData对象并发出信号
     AppData::MarketData marketData;
     marketData.symbol = symbol;
+    marketData.symbolId = SymbolTable::instance()->intern(symbol);
     marketData.price = lastPrice;
     marketData.volume = volume;
     marketData.high = high;
@@ -442,6 +444,7 @@ void onLineMarket_A::parseWebSocketMessage(const QString &message)
         // 创建MarketData对象并发出信号
         AppData::MarketData marketData;
         marketData.symbol = symbol;
+        marketData.symbolId = SymbolTable::instance()->intern(symbol);
         marketData.price = lastPrice;
         marketData.volume = volume;
         marketData.high = high;
@@ -1,4 +1,5 @@
 #include "onlinemarket_okb.h"
+#include "../global/SymbolTable.h"
 #include <QUrlQuery>
 
 onLineMarket_OKB::onLineMarket_OKB(QObject *parent)
@@ -253,6 +254,7 @@ void onLineMarket_OKB::parseMarketData(const QByteArray &data)
     // 创建MarketData对象并发出信号
     AppData::MarketData marketData;
     marketData.symbol = symbol;
+    marketData.symbolId = SymbolTable::instance()->intern(symbol);
     marketData.price = lastPrice;
     marketData.volume = volume24h;
     marketData.high = high24h;
@@ -383,6 +385,7 @@ void onLineMarket_OKB::parseWebSocketMessage(const QString &message)
         // 创建MarketData对象并发出信号
         AppData::MarketData marketData;
         marketData.symbol = symbol;
+        marketData.symbolId = SymbolTable::instance()->intern(symbol);
         marketData.price = lastPrice;
         marketData.volume = volume24h;
         marketData.high = high24h;
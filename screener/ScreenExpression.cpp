@@ -0,0 +1,530 @@
+﻿#include "ScreenExpression.h"
+#include <QStringList>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+// 指标的参数个数、默认值和输出名（第一个为默认输出）
+struct FunctionSpec {
+    const char *name;
+    int requiredArgs;
+    int totalArgs;
+    double defaults[4];
+    const char *outputs[3];
+};
+
+const FunctionSpec kFunctions[] = {
+    {"SMA", 1, 1, {0}, {nullptr}},
+    {"EMA", 1, 1, {0}, {nullptr}},
+    {"WMA", 1, 1, {0}, {nullptr}},
+    {"RSI", 0, 1, {14}, {nullptr}},
+    {"ATR", 0, 1, {14}, {nullptr}},
+    {"HIGHEST", 1, 1, {0}, {nullptr}},
+    {"LOWEST", 1, 1, {0}, {nullptr}},
+    {"MACD", 0, 3, {12, 26, 9}, {"HIST", "DIF", "DEA"}},
+    {"BOLL", 0, 2, {20, 2}, {"MIDDLE", "UPPER", "LOWER"}},
+    {"DONCHIAN", 0, 1, {20}, {"MIDDLE", "UPPER", "LOWER"}},
+    {"STC", 0, 4, {80, 27, 50, 0.5}, {nullptr}},
+};
+
+const char *const kFields[] = {"OPEN", "HIGH", "LOW", "CLOSE", "VOLUME", "AMOUNT"};
+
+const FunctionSpec *findFunction(const QString &name)
+{
+    for (const auto &spec : kFunctions) {
+        if (name == QString(spec.name)) {
+            return &spec;
+        }
+    }
+    return nullptr;
+}
+
+bool isField(const QString &name)
+{
+    for (const char *field : kFields) {
+        if (name == QString(field)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool isTrue(double value)
+{
+    return value != 0.0 && !std::isnan(value);
+}
+
+} // namespace
+
+bool ScreenExpression::Term::isField() const
+{
+    return ::isField(function);
+}
+
+QString ScreenExpression::Term::indicatorKey() const
+{
+    if (args.isEmpty()) {
+        return function;
+    }
+    QStringList parts;
+    for (double arg : args) {
+        parts.append(QString::number(arg));
+    }
+    return QString("%1(%2)").arg(function, parts.join(","));
+}
+
+QString ScreenExpression::Term::text() const
+{
+    QString result = isField() ? function.toLower() : indicatorKey();
+    if (!output.isEmpty()) {
+        result += "." + output;
+    }
+    if (barsAgo > 0) {
+        result += QString("[%1]").arg(barsAgo);
+    }
+    return result;
+}
+
+/**
+ * @brief 递归下降解析器
+ *
+ *   or      := and (("or" | "||") and)*
+ *   and     := not (("and" | "&&") not)*
+ *   not     := ("not" | "!") not | compare
+ *   compare := sum (("<" | "<=" | ">" | ">=" | "==" | "!=") sum)?
+ *   sum     := product (("+" | "-") product)*
+ *   product := unary (("*" | "/") unary)*
+ *   unary   := "-" unary | primary
+ *   primary := number | "(" or ")" | name ["(" number ("," number)* ")"] ["." name] ["[" number "]"]
+ */
+class ScreenExpression::Parser
+{
+public:
+    Parser(ScreenExpression &expression, const QString &text)
+        : m_expression(expression), m_text(text), m_pos(0)
+    {
+    }
+
+    int parse()
+    {
+        const int root = parseOr();
+        if (root >= 0 && !atEnd()) {
+            return fail(QString("unexpected '%1'").arg(m_text.at(m_pos)));
+        }
+        return root;
+    }
+
+    QString error() const { return m_error; }
+
+private:
+    int parseOr()
+    {
+        int left = parseAnd();
+        while (left >= 0 && (matchKeyword("or") || match("||"))) {
+            left = logical(Or, left, parseAnd());
+        }
+        return left;
+    }
+
+    int parseAnd()
+    {
+        int left = parseNot();
+        while (left >= 0 && (matchKeyword("and") || match("&&"))) {
+            left = logical(And, left, parseNot());
+        }
+        return left;
+    }
+
+    int parseNot()
+    {
+        if (matchKeyword("not") || (peek("!") && !peek("!=") && match("!"))) {
+            return unary(Not, parseNot());
+        }
+        return parseCompare();
+    }
+
+    int parseCompare()
+    {
+        const int left = parseSum();
+        if (left < 0) {
+            return left;
+        }
+        // 先匹配两个字符的运算符
+        if (match("<=")) return binary(LessEqual, left, parseSum());
+        if (match(">=")) return binary(GreaterEqual, left, parseSum());
+        if (match("==")) return binary(Equal, left, parseSum());
+        if (match("!=")) return binary(NotEqual, left, parseSum());
+        if (match("<")) return binary(Less, left, parseSum());
+        if (match(">")) return binary(Greater, left, parseSum());
+        return left;
+    }
+
+    int parseSum()
+    {
+        int left = parseProduct();
+        while (left >= 0) {
+            if (match("+")) {
+                left = binary(Add, left, parseProduct());
+            } else if (match("-")) {
+                left = binary(Subtract, left, parseProduct());
+            } else {
+                break;
+            }
+        }
+        return left;
+    }
+
+    int parseProduct()
+    {
+        int left = parseUnary();
+        while (left >= 0) {
+            if (match("*")) {
+                left = binary(Multiply, left, parseUnary());
+            } else if (match("/")) {
+                left = binary(Divide, left, parseUnary());
+            } else {
+                break;
+            }
+        }
+        return left;
+    }
+
+    int parseUnary()
+    {
+        if (match("-")) {
+            return unary(Negate, parseUnary());
+        }
+        return parsePrimary();
+    }
+
+    int parsePrimary()
+    {
+        skipSpaces();
+        if (atEnd()) {
+            return fail("unexpected end of expression");
+        }
+
+        if (match("(")) {
+            const int inner = parseOr();
+            if (inner < 0) {
+                return inner;
+            }
+            return match(")") ? inner : fail("expected ')'");
+        }
+
+        double number = 0.0;
+        if (readNumber(number)) {
+            Node node = makeNode(Number);
+            node.number = number;
+            return addNode(node);
+        }
+
+        const QString name = readName().toUpper();
+        if (name.isEmpty()) {
+            return fail(QString("unexpected '%1'").arg(m_text.at(m_pos)));
+        }
+        return parseTerm(name);
+    }
+
+    int parseTerm(const QString &name)
+    {
+        Term term;
+        term.function = name;
+        term.barsAgo = 0;
+
+        const FunctionSpec *spec = findFunction(name);
+        if (!spec && !::isField(name)) {
+            return fail(QString("unknown name '%1'").arg(name));
+        }
+
+        // 参数，省略的取默认值
+        if (spec) {
+            QVector<double> args;
+            if (match("(") && !match(")")) {
+                do {
+                    double arg = 0.0;
+                    skipSpaces();
+                    if (!readNumber(arg)) {
+                        return fail(QString("expected a number in %1()").arg(name));
+                    }
+                    args.append(arg);
+                } while (match(","));
+                if (!match(")")) {
+                    return fail(QString("expected ')' after %1 arguments").arg(name));
+                }
+            }
+            if (args.size() < spec->requiredArgs || args.size() > spec->totalArgs) {
+                if (spec->requiredArgs == spec->totalArgs) {
+                    return fail(QString("%1 takes %2 arguments").arg(name).arg(spec->totalArgs));
+                }
+                return fail(QString("%1 takes %2 to %3 arguments").arg(name).arg(spec->requiredArgs).arg(spec->totalArgs));
+            }
+            for (int i = args.size(); i < spec->totalArgs; ++i) {
+                args.append(spec->defaults[i]);
+            }
+            term.args = args;
+        }
+
+        // 输出名
+        if (spec && spec->outputs[0]) {
+            term.output = QString(spec->outputs[0]);
+            if (match(".")) {
+                const QString output = readName().toUpper();
+                bool known = false;
+                for (const char *candidate : spec->outputs) {
+                    known = known || (candidate && output == QString(candidate));
+                }
+                if (!known) {
+                    return fail(QString("%1 has no output '%2'").arg(name, output));
+                }
+                term.output = output;
+            }
+        }
+
+        // 回看
+        if (match("[")) {
+            double barsAgo = 0.0;
+            skipSpaces();
+            if (!readNumber(barsAgo) || barsAgo < 0 || barsAgo != std::floor(barsAgo) || !match("]")) {
+                return fail("expected a non-negative integer in []");
+            }
+            term.barsAgo = static_cast<int>(barsAgo);
+        }
+
+        Node node = makeNode(Value);
+        node.term = addTerm(term);
+        node.indicatorCount = term.isField() ? 0 : 1;
+        return addNode(node);
+    }
+
+    int addTerm(const Term &term)
+    {
+        const QString text = term.text();
+        for (int i = 0; i < m_expression.m_terms.size(); ++i) {
+            if (m_expression.m_terms[i].text() == text) {
+                return i;
+            }
+        }
+        m_expression.m_terms.append(term);
+        return m_expression.m_terms.size() - 1;
+    }
+
+    static Node makeNode(Op op)
+    {
+        Node node;
+        node.op = op;
+        node.number = 0.0;
+        node.term = -1;
+        node.left = -1;
+        node.right = -1;
+        node.indicatorCount = 0;
+        return node;
+    }
+
+    int addNode(const Node &node)
+    {
+        m_expression.m_nodes.append(node);
+        return m_expression.m_nodes.size() - 1;
+    }
+
+    int unary(Op op, int operand)
+    {
+        if (operand < 0) {
+            return operand;
+        }
+        Node node = makeNode(op);
+        node.left = operand;
+        node.indicatorCount = m_expression.m_nodes[operand].indicatorCount;
+        return addNode(node);
+    }
+
+    int binary(Op op, int left, int right)
+    {
+        if (right < 0) {
+            return right;
+        }
+        Node node = makeNode(op);
+        node.left = left;
+        node.right = right;
+        node.indicatorCount = m_expression.m_nodes[left].indicatorCount
+                            + m_expression.m_nodes[right].indicatorCount;
+        return addNode(node);
+    }
+
+    // and/or两侧都没有副作用，交换求值顺序不改变结果
+    int logical(Op op, int left, int right)
+    {
+        if (right >= 0 && m_expression.m_nodes[right].indicatorCount < m_expression.m_nodes[left].indicatorCount) {
+            std::swap(left, right);
+        }
+        return binary(op, left, right);
+    }
+
+    bool atEnd()
+    {
+        skipSpaces();
+        return m_pos >= m_text.size();
+    }
+
+    void skipSpaces()
+    {
+        while (m_pos < m_text.size() && m_text.at(m_pos).isSpace()) {
+            ++m_pos;
+        }
+    }
+
+    bool peek(const char *token)
+    {
+        skipSpaces();
+        return m_text.mid(m_pos, static_cast<int>(qstrlen(token))) == QString(token);
+    }
+
+    bool match(const char *token)
+    {
+        if (!peek(token)) {
+            return false;
+        }
+        m_pos += static_cast<int>(qstrlen(token));
+        return true;
+    }
+
+    // 匹配关键字，后面不能紧跟名称字符
+    bool matchKeyword(const char *keyword)
+    {
+        skipSpaces();
+        const int length = static_cast<int>(qstrlen(keyword));
+        if (m_text.mid(m_pos, length).compare(QString(keyword), Qt::CaseInsensitive) != 0) {
+            return false;
+        }
+        const int end = m_pos + length;
+        if (end < m_text.size() && (m_text.at(end).isLetterOrNumber() || m_text.at(end) == '_')) {
+            return false;
+        }
+        m_pos = end;
+        return true;
+    }
+
+    QString readName()
+    {
+        skipSpaces();
+        const int start = m_pos;
+        while (m_pos < m_text.size() && (m_text.at(m_pos).isLetter() || m_text.at(m_pos) == '_'
+                                         || (m_pos > start && m_text.at(m_pos).isDigit()))) {
+            ++m_pos;
+        }
+        return m_text.mid(start, m_pos - start);
+    }
+
+    bool readNumber(double &value)
+    {
+        const int start = m_pos;
+        while (m_pos < m_text.size() && (m_text.at(m_pos).isDigit() || m_text.at(m_pos) == '.')) {
+            ++m_pos;
+        }
+        if (m_pos == start) {
+            return false;
+        }
+        bool ok = false;
+        value = m_text.mid(start, m_pos - start).toDouble(&ok);
+        if (!ok) {
+            m_pos = start;
+        }
+        return ok;
+    }
+
+    int fail(const QString &message)
+    {
+        if (m_error.isEmpty()) {
+            m_error = QString("%1 at position %2").arg(message).arg(m_pos);
+        }
+        return -1;
+    }
+
+    ScreenExpression &m_expression;
+    const QString &m_text;
+    int m_pos;
+    QString m_error;
+};
+
+ScreenExpression::ScreenExpression()
+    : m_root(-1)
+{
+}
+
+bool ScreenExpression::parse(const QString &text, QString *error)
+{
+    m_text = text;
+    m_terms.clear();
+    m_nodes.clear();
+
+    Parser parser(*this, text);
+    m_root = parser.parse();
+    if (m_root < 0) {
+        m_terms.clear();
+        m_nodes.clear();
+        if (error) {
+            *error = parser.error();
+        }
+        return false;
+    }
+    return true;
+}
+
+bool ScreenExpression::isValid() const
+{
+    return m_root >= 0;
+}
+
+QString ScreenExpression::text() const
+{
+    return m_text;
+}
+
+bool ScreenExpression::evaluate(const std::function<double(int)> &termValue) const
+{
+    return isValid() && isTrue(evaluate(m_root, termValue));
+}
+
+double ScreenExpression::evaluate(int index, const std::function<double(int)> &termValue) const
+{
+    const Node &node = m_nodes[index];
+    switch (node.op) {
+    case Number:
+        return node.number;
+    case Value:
+        return termValue(node.term);
+    case Negate:
+        return -evaluate(node.left, termValue);
+    case Not:
+        return isTrue(evaluate(node.left, termValue)) ? 0.0 : 1.0;
+    case And:
+        return isTrue(evaluate(node.left, termValue)) && isTrue(evaluate(node.right, termValue)) ? 1.0 : 0.0;
+    case Or:
+        return isTrue(evaluate(node.left, termValue)) || isTrue(evaluate(node.right, termValue)) ? 1.0 : 0.0;
+    default:
+        break;
+    }
+
+    // 算术和比较，NaN参与的比较为假
+    const double left = evaluate(node.left, termValue);
+    const double right = evaluate(node.right, termValue);
+    if (node.op >= Less && (std::isnan(left) || std::isnan(right))) {
+        return 0.0;
+    }
+    switch (node.op) {
+    case Add: return left + right;
+    case Subtract: return left - right;
+    case Multiply: return left * right;
+    case Divide: return right != 0.0 ? left / right : kNaN;
+    case Less: return left < right ? 1.0 : 0.0;
+    case LessEqual: return left <= right ? 1.0 : 0.0;
+    case Greater: return left > right ? 1.0 : 0.0;
+    case GreaterEqual: return left >= right ? 1.0 : 0.0;
+    case Equal: return left == right ? 1.0 : 0.0;
+    case NotEqual: return left != right ? 1.0 : 0.0;
+    default: return kNaN;
+    }
+}
@@ -0,0 +1,105 @@
+﻿#ifndef SCREENEXPRESSION_H
+#define SCREENEXPRESSION_H
+
+#include <QString>
+#include <QVector>
+#include <functional>
+
+/**
+ * @brief 选股条件表达式
+ *
+ * 例如 "RSI(14) < 30 and close > BOLL(20,2).LOWER"。支持：
+ *   - K线字段：open、high、low、close、volume、amount
+ *   - 指标：SMA(n)、EMA(n)、WMA(n)、RSI(n=14)、ATR(n=14)、HIGHEST(n)、LOWEST(n)、
+ *     MACD(12,26,9).DIF/DEA/HIST、BOLL(20,2).UPPER/MIDDLE/LOWER、
+ *     DONCHIAN(20).UPPER/MIDDLE/LOWER、STC(80,27,50,0.5)，省略的参数取默认值，
+ *     省略输出名时取第一个输出（MACD为HIST，通道类为MIDDLE）
+ *   - [n]取n根K线之前的值，如 close[1]
+ *   - 四则运算、比较（< <= > >= == !=）、and/or/not（也可写作&& || !）和括号
+ * 名称不区分大小写。
+ *
+ * 取值为NaN（数据不足、指标未到预热期）时比较结果为假。and/or从左到右短路求值，
+ * 解析时把不含指标的一侧调到前面，使只看K线字段的条件先于需要计算指标的条件求值。
+ */
+class ScreenExpression
+{
+public:
+    // 表达式引用的一个值：K线字段或指标的某个输出
+    struct Term {
+        QString function;           // 大写的指标名或K线字段名
+        QVector<double> args;       // 补全默认值后的参数
+        QString output;             // 大写的输出名，单输出指标和K线字段为空
+        int barsAgo;                // 0为最新值
+
+        // 是否为K线字段
+        bool isField() const;
+
+        // 指标实例的标识，如"BOLL(20,2)"，同一标识的项共享一个指标对象
+        QString indicatorKey() const;
+
+        // 规范化的文本，如"BOLL(20,2).LOWER[1]"
+        QString text() const;
+    };
+
+    ScreenExpression();
+
+    // 解析表达式，失败时通过error返回错误说明
+    bool parse(const QString &text, QString *error = nullptr);
+
+    // 是否已成功解析
+    bool isValid() const;
+
+    // 原始文本
+    QString text() const;
+
+    // 表达式引用的值，相同的值只出现一次
+    const QVector<Term> &terms() const { return m_terms; }
+
+    /**
+     * @brief 对一个品种求值
+     * @param termValue 返回第i个Term的值，只在求值需要时调用，不可用时返回NaN
+     * @return 条件是否成立
+     */
+    bool evaluate(const std::function<double(int)> &termValue) const;
+
+private:
+    enum Op {
+        Number,
+        Value,
+        Negate,
+        Not,
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Less,
+        LessEqual,
+        Greater,
+        GreaterEqual,
+        Equal,
+        NotEqual,
+        And,
+        Or
+    };
+
+    struct Node {
+        Op op;
+        double number;      // Number
+        int term;           // Value
+        int left;
+        int right;
+        int indicatorCount; // 子树中引用指标的项数，用于调整and/or的求值顺序
+    };
+
+    class Parser;
+    friend class Parser;
+
+    double evaluate(int node, const std::function<double(int)> &termValue) const;
+
+    QString m_text;
+    QVector<Term> m_terms;
+    QVector<Node> m_nodes;
+    int m_root;
+};
+
+#endif // SCREENEXPRESSION_H
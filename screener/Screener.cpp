@@ -0,0 +1,326 @@
+﻿#include "Screener.h"
+#include "../history/BarSeries.h"
+#include "../history/HistoryDataManager.h"
+#include "../history/MappedHistory.h"
+#include "../indicators/ATR.h"
+#include "../indicators/BollingerBands.h"
+#include "../indicators/DonchianChannel.h"
+#include "../indicators/MACD.h"
+#include "../indicators/MovingAverage.h"
+#include "../indicators/RSI.h"
+#include "../indicators/RollingExtremum.h"
+#include "../indicators/STC.h"
+#include <QFuture>
+#include <QtConcurrent>
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+const double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+// 每个线程分到的块数，品种之间读取和计算的耗时差异较大，多切几块以均衡负载
+const int kChunksPerThread = 4;
+
+// 指标结果保留的最少根数；表达式回看更远时按需重建指标
+const int kMinIndicatorLookback = 64;
+
+// 创建表达式项对应的指标
+std::shared_ptr<IndicatorBase> createIndicator(const ScreenExpression::Term &term)
+{
+    const QVector<double> &args = term.args;
+    auto period = [&args](int i) { return qMax(1, static_cast<int>(args[i])); };
+
+    if (term.function == "SMA") return std::make_shared<MovingAverage>(period(0), MovingAverage::SMA);
+    if (term.function == "EMA") return std::make_shared<MovingAverage>(period(0), MovingAverage::EMA);
+    if (term.function == "WMA") return std::make_shared<MovingAverage>(period(0), MovingAverage::WMA);
+    if (term.function == "RSI") return std::make_shared<RSI>(period(0));
+    if (term.function == "ATR") return std::make_shared<ATR>(period(0));
+    if (term.function == "HIGHEST") return std::make_shared<RollingExtremum>(period(0), RollingExtremum::Highest);
+    if (term.function == "LOWEST") return std::make_shared<RollingExtremum>(period(0), RollingExtremum::Lowest);
+    if (term.function == "MACD") return std::make_shared<MACD>(period(0), period(1), period(2));
+    if (term.function == "BOLL") return std::make_shared<BollingerBands>(period(0), args[1]);
+    if (term.function == "DONCHIAN") return std::make_shared<DonchianChannel>(period(0));
+    if (term.function == "STC") return std::make_shared<STC>(period(0), period(1), period(2), args[3]);
+    return nullptr;
+}
+
+// 指标的某个输出序列
+SeriesView outputSeries(const IndicatorBase &indicator, const QString &output)
+{
+    if (const MACD *macd = dynamic_cast<const MACD *>(&indicator)) {
+        if (output == "DIF") return macd->difLine();
+        if (output == "DEA") return macd->deaLine();
+        return macd->macdHist();
+    }
+    if (const BollingerBands *bands = dynamic_cast<const BollingerBands *>(&indicator)) {
+        if (output == "UPPER") return bands->upperBand();
+        if (output == "LOWER") return bands->lowerBand();
+        return bands->middleBand();
+    }
+    if (const DonchianChannel *channel = dynamic_cast<const DonchianChannel *>(&indicator)) {
+        if (output == "UPPER") return channel->upperBand();
+        if (output == "LOWER") return channel->lowerBand();
+        return channel->middleBand();
+    }
+    return indicator.values();
+}
+
+} // namespace
+
+// 一个品种的缓存：已读取的K线和已创建的指标
+struct Screener::SymbolState {
+    struct CachedIndicator {
+        std::shared_ptr<IndicatorBase> indicator;
+        int barCount;               // 已并入指标的K线数
+    };
+
+    QString symbol;
+    BarSeries bars;
+    QHash<QString, CachedIndicator> indicators;     // 指标标识 -> 指标
+};
+
+Screener::Screener(QObject *parent)
+    : QObject(parent),
+      m_timeFrame(AppData::D1),
+      m_startTime(QDateTime::fromMSecsSinceEpoch(0)),
+      m_threadCount(0)
+{
+}
+
+Screener::~Screener()
+{
+}
+
+void Screener::setDataManager(std::shared_ptr<HistoryDataManager> dataManager)
+{
+    m_dataManager = dataManager;
+    clearCache();
+}
+
+void Screener::setTimeFrame(AppData::TimeFrame timeFrame)
+{
+    if (timeFrame != m_timeFrame) {
+        m_timeFrame = timeFrame;
+        clearCache();
+    }
+}
+
+AppData::TimeFrame Screener::timeFrame() const
+{
+    return m_timeFrame;
+}
+
+void Screener::setSymbols(const QStringList &symbols)
+{
+    m_symbols = symbols;
+}
+
+void Screener::setStartTime(const QDateTime &startTime)
+{
+    if (startTime != m_startTime) {
+        m_startTime = startTime;
+        clearCache();
+    }
+}
+
+void Screener::setThreadCount(int threadCount)
+{
+    m_threadCount = qMax(0, threadCount);
+    if (m_threadCount > 0) {
+        m_threadPool.setMaxThreadCount(m_threadCount);
+    }
+}
+
+bool Screener::setExpression(const QString &expression, QString *error)
+{
+    ScreenExpression parsed;
+    if (!parsed.parse(expression, error)) {
+        return false;
+    }
+    m_expression = parsed;
+    return true;
+}
+
+QString Screener::expression() const
+{
+    return m_expression.text();
+}
+
+QVector<Screener::Match> Screener::run()
+{
+    QVector<Match> matches;
+    if (!m_expression.isValid()) {
+        emit logMessage(tr("未设置筛选条件"), 1);
+        return matches;
+    }
+
+    QStringList symbols = m_symbols;
+    if (symbols.isEmpty() && m_dataManager) {
+        symbols = m_dataManager->availableSymbols(m_timeFrame);
+    }
+
+    // 缓存在当前线程中创建，并行阶段每个品种只由一个线程访问
+    QVector<SymbolState *> states;
+    states.reserve(symbols.size());
+    for (const QString &symbol : symbols) {
+        states.append(symbolState(symbol));
+    }
+    QVector<char> matched(states.size(), 0);
+
+    QThreadPool *pool = m_threadCount > 0 ? &m_threadPool : QThreadPool::globalInstance();
+    const int chunkCount = qMin(states.size(), pool->maxThreadCount() * kChunksPerThread);
+    QVector<QFuture<void>> futures;
+    futures.reserve(chunkCount);
+    for (int chunk = 0; chunk < chunkCount; ++chunk) {
+        const int begin = states.size() * chunk / chunkCount;
+        const int end = states.size() * (chunk + 1) / chunkCount;
+        futures.append(QtConcurrent::run(pool, [this, &states, &matched, begin, end]() {
+            for (int i = begin; i < end; ++i) {
+                if (m_dataManager) {
+                    loadNewBars(*states[i]);
+                }
+                matched[i] = evaluate(*states[i]);
+            }
+        }));
+    }
+    for (int chunk = 0; chunk < futures.size(); ++chunk) {
+        futures[chunk].waitForFinished();
+        emit progressUpdated((chunk + 1) * 100 / futures.size());
+    }
+
+    for (int i = 0; i < states.size(); ++i) {
+        if (matched[i]) {
+            const AppData::Bar last = states[i]->bars.last();
+            matches.append(Match{states[i]->symbol, last.timestamp, last.close});
+        }
+    }
+    std::sort(matches.begin(), matches.end(), [](const Match &a, const Match &b) {
+        return a.symbol < b.symbol;
+    });
+
+    emit logMessage(tr("筛选完成: %1/%2 个品种满足条件").arg(matches.size()).arg(states.size()), 0);
+    return matches;
+}
+
+void Screener::appendBars(const QString &symbol, const QVector<AppData::MarketData> &bars)
+{
+    SymbolState *state = symbolState(symbol);
+    for (const auto &data : bars) {
+        const AppData::Bar bar = BarSeries::toBar(data);
+        if (state->bars.isEmpty() || bar.timestamp > state->bars.last().timestamp) {
+            state->bars.append(bar);
+        }
+    }
+}
+
+void Screener::clearCache()
+{
+    m_states.clear();
+}
+
+int Screener::cachedSymbolCount() const
+{
+    return m_states.size();
+}
+
+Screener::SymbolState *Screener::symbolState(const QString &symbol)
+{
+    std::shared_ptr<SymbolState> &state = m_states[symbol];
+    if (!state) {
+        state = std::make_shared<SymbolState>();
+        state->symbol = symbol;
+        state->bars.setTimeFrame(m_timeFrame);
+    }
+    return state.get();
+}
+
+void Screener::loadNewBars(SymbolState &state) const
+{
+    const qint64 startMs = state.bars.isEmpty()
+        ? m_startTime.toMSecsSinceEpoch()
+        : state.bars.last().timestamp + 1;
+
+    // 列式存储：映射后按时间二分定位，只读取新的行
+    std::shared_ptr<MappedHistory> history = m_dataManager->openMappedHistory(state.symbol, m_timeFrame);
+    if (history) {
+        const BarView view = history->view(startMs, std::numeric_limits<qint64>::max());
+        state.bars.reserve(state.bars.size() + static_cast<int>(view.size()));
+        for (qint64 i = 0; i < view.size(); ++i) {
+            AppData::Bar bar;
+            bar.timestamp = view.timestamp(i);
+            bar.symbolId = view.symbolId();
+            bar.open = view.open(i);
+            bar.high = view.high(i);
+            bar.low = view.low(i);
+            bar.close = view.close(i);
+            bar.volume = view.volume(i);
+            bar.amount = view.amount(i);
+            state.bars.append(bar);
+        }
+        return;
+    }
+
+    // 没有列式存储时读取CSV文件
+    if (!m_dataManager->hasHistoricalData(state.symbol, m_timeFrame)) {
+        return;
+    }
+    QVector<AppData::MarketData> data;
+    m_dataManager->loadHistoricalData(state.symbol,
+                                      QDateTime::fromMSecsSinceEpoch(startMs),
+                                      QDateTime(QDate(9999, 12, 31), QTime(23, 59, 59)),
+                                      data, m_timeFrame);
+    for (const auto &item : data) {
+        const AppData::Bar bar = BarSeries::toBar(item);
+        if (bar.timestamp >= startMs && (state.bars.isEmpty() || bar.timestamp > state.bars.last().timestamp)) {
+            state.bars.append(bar);
+        }
+    }
+}
+
+bool Screener::evaluate(SymbolState &state) const
+{
+    if (state.bars.isEmpty()) {
+        return false;
+    }
+    return m_expression.evaluate([this, &state](int term) { return termValue(state, term); });
+}
+
+double Screener::termValue(SymbolState &state, int index) const
+{
+    const ScreenExpression::Term &term = m_expression.terms()[index];
+    const BarSeries &bars = state.bars;
+
+    if (term.isField()) {
+        const int row = bars.size() - 1 - term.barsAgo;
+        if (row < 0) {
+            return kNaN;
+        }
+        if (term.function == "OPEN") return bars.opens()[row];
+        if (term.function == "HIGH") return bars.highs()[row];
+        if (term.function == "LOW") return bars.lows()[row];
+        if (term.function == "CLOSE") return bars.closes()[row];
+        if (term.function == "VOLUME") return bars.volumes()[row];
+        if (term.function == "AMOUNT") return bars.amounts()[row];
+        return kNaN;
+    }
+
+    SymbolState::CachedIndicator &cached = state.indicators[term.indicatorKey()];
+    if (!cached.indicator || term.barsAgo >= cached.indicator->maxLookback()) {
+        // 首次使用或需要更远的回看：按全部K线整段计算
+        cached.indicator = createIndicator(term);
+        if (!cached.indicator) {
+            return kNaN;
+        }
+        cached.indicator->setMaxLookback(qMax(kMinIndicatorLookback, term.barsAgo + 1));
+        cached.indicator->calculate(bars.toMarketData(state.symbol));
+    } else {
+        // 已有指标只补算新到的K线
+        for (int i = cached.barCount; i < bars.size(); ++i) {
+            cached.indicator->update(BarSeries::toMarketData(bars.at(i), state.symbol));
+        }
+    }
+    cached.barCount = bars.size();
+
+    return outputSeries(*cached.indicator, term.output).value(term.barsAgo);
+}
@@ -0,0 +1,108 @@
+﻿#ifndef SCREENER_H
+#define SCREENER_H
+
+#include "ScreenExpression.h"
+#include "../AppData.h"
+#include <QDateTime>
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include <memory>
+
+class HistoryDataManager;
+
+/**
+ * @brief 全市场选股
+ *
+ * 对HistoryDataManager数据目录中某一周期下的所有品种（或指定的品种）按ScreenExpression
+ * 筛选，各品种并行求值。
+ *
+ * 每个品种的K线（BarSeries）和已创建的指标对象在两次筛选之间保留：再次调用run()时只从
+ * 数据目录读取上次之后新到的K线，已有指标逐根update()接续，盘中重复筛选的开销只与新K线
+ * 的数量有关。指标按需创建，and/or短路时没有求值到的指标不会被计算；更换表达式后，
+ * 相同参数的指标继续沿用。
+ *
+ * 数据优先通过内存映射读取列式存储，没有列式存储时回退到HistoryDataManager::loadHistoricalData()。
+ * 已处理的K线不会被修改，未完成的K线应在收盘后再写入数据目录，或由appendBars()推送。
+ */
+class Screener : public QObject
+{
+    Q_OBJECT
+public:
+    // 一个满足条件的品种
+    struct Match {
+        QString symbol;
+        qint64 timestamp;           // 最新K线的时间戳(毫秒)
+        double close;               // 最新K线的收盘价
+    };
+
+    explicit Screener(QObject *parent = nullptr);
+    ~Screener() override;
+
+    // 数据来源
+    void setDataManager(std::shared_ptr<HistoryDataManager> dataManager);
+
+    // K线周期，默认日线；更改后清空缓存
+    void setTimeFrame(AppData::TimeFrame timeFrame);
+    AppData::TimeFrame timeFrame() const;
+
+    // 参与筛选的品种，为空时使用数据目录中该周期下的全部品种（默认）
+    void setSymbols(const QStringList &symbols);
+
+    // 首次加载K线的起始时间，默认加载全部历史；更改后清空缓存
+    void setStartTime(const QDateTime &startTime);
+
+    // 并行使用的线程数，0表示使用全局线程池（默认）
+    void setThreadCount(int threadCount);
+
+    // 设置筛选条件，解析失败时返回false并通过error返回错误说明
+    bool setExpression(const QString &expression, QString *error = nullptr);
+    QString expression() const;
+
+    /**
+     * @brief 读取新到的K线并筛选
+     * @return 满足条件的品种，按品种代码排序
+     */
+    QVector<Match> run();
+
+    // 推送一个品种的新K线（不经过数据目录），时间戳不晚于已有K线的会被忽略；下一次run()时生效
+    void appendBars(const QString &symbol, const QVector<AppData::MarketData> &bars);
+
+    // 清空所有品种的K线和指标
+    void clearCache();
+
+    // 已缓存的品种数
+    int cachedSymbolCount() const;
+
+signals:
+    void progressUpdated(int progress);
+    void logMessage(const QString &message, int level = 0);
+
+private:
+    struct SymbolState;
+
+    // 取得品种的缓存状态，不存在时创建
+    SymbolState *symbolState(const QString &symbol);
+
+    // 从数据目录读取品种上次之后新到的K线
+    void loadNewBars(SymbolState &state) const;
+
+    // 对一个品种求值
+    bool evaluate(SymbolState &state) const;
+
+    // 表达式中第term项在品种上的值，按需创建指标并补算到最新K线
+    double termValue(SymbolState &state, int term) const;
+
+    std::shared_ptr<HistoryDataManager> m_dataManager;
+    AppData::TimeFrame m_timeFrame;
+    QStringList m_symbols;
+    QDateTime m_startTime;
+    int m_threadCount;
+    QThreadPool m_threadPool;                   // 指定线程数时使用的线程池
+    ScreenExpression m_expression;
+    QHash<QString, std::shared_ptr<SymbolState>> m_states;
+};
+
+#endif // SCREENER_H
@@ -1,4 +1,5 @@
 #include "TradingEngine.h"
+#include "../global/SymbolTable.h"
 #include <QDebug>
 
 TradingEngine::TradingEngine(QObject *parent)
@@ -95,7 +96,21 @@ void TradingEngine::stopTrading()
 
 QMap<QString, AppData::Position> TradingEngine::getPositions() const
 {
-    return m_positions;
+    QMap<QString, AppData::Position> positions;
+    for (const auto &position : m_positions) {
+        if (position.symbolId != SymbolTable::kInvalidId) {
+            positions.insert(position.symbol, position);
+        }
+    }
+    return positions;
+}
+
+AppData::Position &TradingEngine::positionSlot(quint32 symbolId)
+{
+    if (static_cast<int>(symbolId) >= m_positions.size()) {
+        m_positions.resize(static_cast<int>(symbolId) + 1);
+    }
+    return m_positions[static_cast<int>(symbolId)];
 }
 
 void TradingEngine::executeOrder(const AppData::Order &order)
@@ -107,6 +122,7 @@ void TradingEngine::executeOrder(const AppData::Order &order)
     trade.tradeId = QString("trade_%1").arg(m_account.trades.size() + 1);
     trade.orderId = order.orderId;
     trade.symbol = order.symbol;
+    trade.symbolId = order.symbolId;
     trade.tradeTime = QDateTime::currentDateTime();
     trade.direction = order.direction;
     trade.price = order.price;
@@ -142,20 +158,25 @@ void TradingEngine::cancelOrder(const QString &orderId)
 
 void TradingEngine::updateAccount(const AppData::Trade &trade)
 {
+    quint32 symbolId = trade.symbolId;
+    if (symbolId == SymbolTable::kInvalidId) {
+        symbolId = SymbolTable::instance()->intern(trade.symbol);
+    }
+    auto &position = positionSlot(symbolId);
+    bool hasPosition = position.symbolId != SymbolTable::kInvalidId;
+
     // 计算盈亏
     double pnl = 0.0;
     if (trade.direction == AppData::Long) {
         // 做多：卖出时计算盈亏
-        if (m_positions.contains(trade.symbol)) {
-            auto &position = m_positions[trade.symbol];
+        if (hasPosition) {
             if (position.direction == AppData::Long) {
                 pnl = (trade.price - position.avgPrice) * trade.quantity;
             }
         }
     } else {
         // 做空：买入时计算盈亏
-        if (m_positions.contains(trade.symbol)) {
-            auto &position = m_positions[trade.symbol];
+        if (hasPosition) {
             if (position.direction == AppData::Short) {
                 pnl = (position.avgPrice - trade.price) * trade.quantity;
             }
@@ -170,32 +191,30 @@ void TradingEngine::updateAccount(const AppData::Trade &trade)
     // 更新持仓
     if (trade.direction == AppData::Long) {
         // 买入
-        if (!m_positions.contains(trade.symbol)) {
-            AppData::Position position;
+        if (!hasPosition) {
+            position = AppData::Position();
             position.symbol = trade.symbol;
+            position.symbolId = symbolId;
             position.direction = AppData::Long;
             position.quantity = trade.quantity;
             position.avgPrice = trade.price;
             position.openTime = QDateTime::currentDateTime();
-            m_positions[trade.symbol] = position;
         } else {
-            auto &position = m_positions[trade.symbol];
             position.avgPrice = (position.avgPrice * position.quantity + trade.price * trade.quantity) / 
                                (position.quantity + trade.quantity);
             position.quantity += trade.quantity;
         }
     } else {
         // 卖出
-        if (!m_positions.contains(trade.symbol)) {
-            AppData::Position position;
+        if (!hasPosition) {
+            position = AppData::Position();
             position.symbol = trade.symbol;
+            position.symbolId = symbolId;
             position.direction = AppData::Short;
             position.quantity = trade.quantity;
             position.avgPrice = trade.price;
             position.openTime = QDateTime::currentDateTime();
-            m_positions[trade.symbol] = position;
         } else {
-            auto &position = m_positions[trade.symbol];
             position.avgPrice = (position.avgPrice * position.quantity + trade.price * trade.quantity) / 
                                (position.quantity + trade.quantity);
             position.quantity += trade.quantity;
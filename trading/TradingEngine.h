@@ -55,11 +55,14 @@ private:
     // 执行订单
     void executeOrder(const AppData::Order &order);
 
+    // 获取品种对应的持仓槽位，不存在时扩容
+    AppData::Position &positionSlot(quint32 symbolId);
+
     // 取消订单
     // void cancelOrder(const QString &orderId);
 
     QMap<QString, AppData::Order> m_activeOrders;
-    QMap<QString, AppData::Position> m_positions;
+    QVector<AppData::Position> m_positions; // 持仓，按品种ID(SymbolTable)索引
     AppData::Account m_account;
     QVector<std::shared_ptr<Strategy>> m_strategies;
     bool m_isTrading;